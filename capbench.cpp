@@ -0,0 +1,439 @@
+// capbench.cpp
+// End-to-end benchmark of the Wayland capture path: the real screencopy
+// engine against an in-process mock compositor (see mock_compositor.h).
+// - Measures captured frames/s, copy bandwidth, capture latency and the CPU
+//   time of the capture and compositor threads, with or without damage.
+// - --mode-change / --hotplug script mode changes and unplugs of the first
+//   output while capturing, to exercise buffer reallocation and recovery.
+// - --tile-diff derives damage from tile hashes, for comparing it with the
+//   compositor's own (or its absence, with --no-damage).
+// - --serve just runs the mock, so vrdesktop itself can be pointed at it.
+// - Prints one key=value summary line on stdout for CI to track.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "screencopy.h"
+#include "frame_handoff.h"
+#include "frame_pacer.h"
+#include "latency.h"
+#include "mock_compositor.h"
+
+#define CAPBENCH_DEFAULT_SECONDS 5.0f
+
+struct CapBenchOptions {
+    MockConfig mock;
+    float seconds = CAPBENCH_DEFAULT_SECONDS;
+    int inFlight = SCREENCOPY_DEFAULT_IN_FLIGHT;
+    bool useDamage = true;
+    bool tileDiff = false;
+    bool serve = false;
+    capture_region regions[SCREENCOPY_MAX_STREAMS];
+    int numRegions = 0;
+    float modeChangeSeconds = 0.0f;     // toggle the first output's mode this often
+    float hotplugSeconds = 0.0f;        // unplug / replug it this often
+};
+
+// capture thread -> consumers, one per output
+static FrameHandoff g_frameHandoff[SCREENCOPY_MAX_STREAMS];
+static FramePacer g_framePacer;
+static std::atomic<bool> g_captureRunning{false};
+static std::atomic<bool> g_serving{true};
+
+// ----------------------------------------------------------------------
+// Thread CPU time
+// ----------------------------------------------------------------------
+
+static int64_t thread_cpu_ns(std::thread &t)
+{
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(t.native_handle(), &clock) != 0 ||
+        clock_gettime(clock, &ts) != 0)
+        return 0;
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+// ----------------------------------------------------------------------
+// Capture thread: same loop as vrdesktop's, unpaced
+// ----------------------------------------------------------------------
+
+static void on_capture_published(void *user, const capture_request &req)
+{
+    (void)user;
+    frame_pacer_capture_done(g_framePacer, req.issue_ns, req.ready_ns);
+}
+
+static void capture_thread_func(screencopy_state *st)
+{
+    while (g_captureRunning.load()) {
+        // keep the pipeline full; damage requests park in the compositor
+        // until the desktop changes
+        for (int i = 0; i < st->num_streams; ++i) {
+            capture_stream *s = &st->streams[i];
+            while (screencopy_can_issue(s, g_frameHandoff[i]) &&
+                   screencopy_issue(s, g_frameHandoff[i], st->use_damage) == 0)
+                ;
+        }
+
+        screencopy_arm_timer(st, 0);
+        if (screencopy_wait(st) < 0) {
+            std::fprintf(stderr, "screencopy: Wayland connection lost\n");
+            break;
+        }
+        for (int i = 0; i < st->num_streams; ++i)
+            screencopy_collect(&st->streams[i], g_frameHandoff[i], on_capture_published, nullptr);
+    }
+    for (int i = 0; i < st->num_streams; ++i)
+        screencopy_abort(&st->streams[i], g_frameHandoff[i]);
+}
+
+// ----------------------------------------------------------------------
+// Consumer: takes the newest frame like the upload thread would
+// ----------------------------------------------------------------------
+
+struct ConsumerStats {
+    uint64_t frames = 0;
+    uint64_t damagedBytes = 0;      // what a damage-driven upload would move
+    uint64_t checksum = 0;          // keeps the reads from being optimized out
+    uint64_t sizeChanges = 0;
+};
+
+static uint64_t frame_damaged_bytes(const FrameSlot &f)
+{
+    if (f.fullDamage)
+        return (uint64_t)f.stride * (uint64_t)f.height;
+    uint64_t bytes = 0;
+    for (int i = 0; i < f.numDamage; ++i)
+        bytes += (uint64_t)f.damage[i].width * (uint64_t)f.damage[i].height * 4;
+    return bytes;
+}
+
+static void consumer_thread_func(FrameHandoff *handoff, LatencyStats *latency, ConsumerStats *stats)
+{
+    uint64_t lastSeq = 0;
+    int lastWidth = 0, lastHeight = 0;
+    while (g_captureRunning.load()) {
+        FrameSlot *f = handoff_acquire(*handoff);
+        if (!f) {
+            handoff_wait(*handoff, 10);
+            continue;
+        }
+
+        const int64_t now = pacer_now_ns();
+        latency_record(*latency, LATENCY_CAPTURE_TO_COPY, f->readyNs - f->presentNs);
+        latency_record(*latency, LATENCY_COPY_TO_UPLOAD, now - f->readyNs);
+
+        // a skipped frame's damage is lost, same as the real consumer
+        FrameSlot whole = *f;
+        if (lastSeq && f->seq != lastSeq + 1)
+            whole.fullDamage = true;
+        stats->damagedBytes += frame_damaged_bytes(whole);
+        // the middle and the very last pixel, so a buffer smaller than the
+        // frame claims to be shows up
+        stats->checksum += f->data[(size_t)(f->height / 2) * f->stride + (size_t)f->width * 2];
+        stats->checksum += f->data[(size_t)(f->height - 1) * f->stride + (size_t)f->width * 4 - 1];
+        if (lastWidth && (f->width != lastWidth || f->height != lastHeight))
+            stats->sizeChanges++;
+        lastWidth = f->width;
+        lastHeight = f->height;
+        stats->frames++;
+        lastSeq = f->seq;
+    }
+}
+
+// ----------------------------------------------------------------------
+// documentation
+// ----------------------------------------------------------------------
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [OPTIONS]\n"
+        "\n"
+        "Benchmark wlr-screencopy capture against a mock compositor.\n"
+        "\n"
+        "Options:\n"
+        "  --outputs <n>       Mock outputs, side by side (default 1, max %d).\n"
+        "  --size <W>x<H>      Output size (default 1920x1080).\n"
+        "  --pattern <name>    Damage pattern: full, box, typing (default box).\n"
+        "  --refresh <hz>      Output refresh rate (default 60).\n"
+        "  --content-fps <n>   Desktop changes per second, 0 = static (default 60).\n"
+        "  --seconds <s>       Run time (default 5).\n"
+        "  --mode-change <s>   Switch the first output between its size and half\n"
+        "                      of it every s seconds.\n"
+        "  --hotplug <s>       Unplug / replug the first output every s seconds.\n"
+        "  --in-flight <n>     Screencopy requests in flight, 1-%d (default %d).\n"
+        "  --no-damage         Plain copies instead of copy_with_damage.\n"
+        "  --tile-diff         Damage from tile hashes for frames without any;\n"
+        "                      unchanged frames are dropped.\n"
+        "  --region X,Y,WxH    Capture only this rectangle, in the outputs' shared\n"
+        "                      logical space; repeat for up to %d regions.\n"
+        "  --serve             Only run the mock compositor until interrupted.\n",
+        prog, MOCK_MAX_OUTPUTS, SCREENCOPY_MAX_IN_FLIGHT, SCREENCOPY_DEFAULT_IN_FLIGHT,
+        SCREENCOPY_MAX_STREAMS);
+}
+
+static bool parse_size(const char *s, int *w, int *h)
+{
+    return std::sscanf(s, "%dx%d", w, h) == 2 && *w > 0 && *h > 0;
+}
+
+static bool parse_options(int argc, char **argv, CapBenchOptions &o)
+{
+    int width = 1920, height = 1080;
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--outputs") == 0 && more) {
+            o.mock.numOutputs = atoi(argv[++i]);
+            if (o.mock.numOutputs < 1 || o.mock.numOutputs > MOCK_MAX_OUTPUTS)
+                return false;
+        } else if (strcmp(argv[i], "--size") == 0 && more) {
+            if (!parse_size(argv[++i], &width, &height))
+                return false;
+        } else if (strcmp(argv[i], "--pattern") == 0 && more) {
+            if (!synthetic_pattern_from_name(argv[++i], &o.mock.pattern))
+                return false;
+        } else if (strcmp(argv[i], "--refresh") == 0 && more) {
+            o.mock.refreshHz = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--content-fps") == 0 && more) {
+            o.mock.contentFps = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--seconds") == 0 && more) {
+            o.seconds = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--mode-change") == 0 && more) {
+            o.modeChangeSeconds = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--hotplug") == 0 && more) {
+            o.hotplugSeconds = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--in-flight") == 0 && more) {
+            o.inFlight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-damage") == 0) {
+            o.useDamage = false;
+        } else if (strcmp(argv[i], "--tile-diff") == 0) {
+            o.tileDiff = true;
+        } else if (strcmp(argv[i], "--region") == 0 && more) {
+            if (o.numRegions == SCREENCOPY_MAX_STREAMS ||
+                !screencopy_parse_region(argv[++i], &o.regions[o.numRegions++]))
+                return false;
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            o.serve = true;
+        } else {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < o.mock.numOutputs; ++i) {
+        std::snprintf(o.mock.outputs[i].name, sizeof(o.mock.outputs[i].name), "MOCK-%d", i + 1);
+        o.mock.outputs[i].width = width;
+        o.mock.outputs[i].height = height;
+    }
+    return true;
+}
+
+// libwayland puts the socket in XDG_RUNTIME_DIR; CI runners often have none
+static bool ensure_runtime_dir()
+{
+    if (getenv("XDG_RUNTIME_DIR"))
+        return true;
+    static char dir[] = "/tmp/capbench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "mkdtemp failed: %s\n", strerror(errno));
+        return false;
+    }
+    setenv("XDG_RUNTIME_DIR", dir, 1);
+    return true;
+}
+
+static void on_signal(int)
+{
+    g_serving.store(false);
+}
+
+// Sleep until endNs, changing the first output's mode and plugging it in
+// and out on the way when asked to.
+static void run_output_script(MockCompositor &mc, const CapBenchOptions &o, int64_t endNs)
+{
+    const MockOutputConfig &cfg = o.mock.outputs[0];
+    const int64_t modeNs = (int64_t)(o.modeChangeSeconds * 1e9);
+    const int64_t plugNs = (int64_t)(o.hotplugSeconds * 1e9);
+    int64_t nextMode = modeNs > 0 ? pacer_now_ns() + modeNs : INT64_MAX;
+    int64_t nextPlug = plugNs > 0 ? pacer_now_ns() + plugNs : INT64_MAX;
+    bool half = false, plugged = true;
+
+    for (int64_t now = pacer_now_ns(); now < endNs; now = pacer_now_ns()) {
+        if (now >= nextMode) {
+            half = !half;
+            mock_compositor_resize_output(mc, 0, half ? cfg.width / 2 : cfg.width,
+                                          half ? cfg.height / 2 : cfg.height);
+            nextMode += modeNs;
+        }
+        if (now >= nextPlug) {
+            plugged = !plugged;
+            mock_compositor_plug_output(mc, 0, plugged);
+            nextPlug += plugNs;
+        }
+        int64_t until = endNs;
+        if (nextMode < until) until = nextMode;
+        if (nextPlug < until) until = nextPlug;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(until - now));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// main
+// ---------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    CapBenchOptions opt;
+    if (!parse_options(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (!ensure_runtime_dir())
+        return 1;
+
+    MockCompositor mc;
+    if (!mock_compositor_start(mc, opt.mock))
+        return 1;
+
+    if (opt.serve) {
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        printf("WAYLAND_DISPLAY=%s XDG_RUNTIME_DIR=%s\n", mc.socket, getenv("XDG_RUNTIME_DIR"));
+        fflush(stdout);
+        const int64_t startNs = pacer_now_ns();
+        while (g_serving.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        print_mock_stats(mc, (double)(pacer_now_ns() - startNs) / 1e9);
+        mock_compositor_stop(mc);
+        return 0;
+    }
+
+    // ---------------- Capture engine ----------------
+    setenv("WAYLAND_DISPLAY", mc.socket, 1);
+    screencopy_state st{};
+    if (!screencopy_connect(&st, "all", opt.regions, opt.numRegions)) {
+        mock_compositor_stop(mc);
+        return 1;
+    }
+    screencopy_set_in_flight(&st, opt.inFlight);
+    st.use_damage = opt.useDamage &&
+        st.screencopy_version >= ZWLR_SCREENCOPY_FRAME_V1_COPY_WITH_DAMAGE_SINCE_VERSION;
+    if (opt.tileDiff)
+        screencopy_set_tile_diff(&st, 0);
+
+    frame_pacer_init(g_framePacer, opt.mock.refreshHz, false);
+    for (int i = 0; i < st.num_streams; ++i) {
+        handoff_init(g_frameHandoff[i], st.streams[i].num_buffers);
+        if (screencopy_capture_sync(&st.streams[i], g_frameHandoff[i], false) != 0) {
+            fprintf(stderr, "Initial capture failed\n");
+            screencopy_disconnect(&st);
+            mock_compositor_stop(mc);
+            return 1;
+        }
+    }
+    const int inFlight = st.streams[0].max_in_flight;
+
+    fprintf(stderr, "capbench: %d x %ux%u %s, %.0f Hz refresh, content %.0f fps, %s%s, %d in flight\n",
+            st.num_streams, st.streams[0].width, st.streams[0].height,
+            synthetic_pattern_name(opt.mock.pattern), mc.cfg.refreshHz, opt.mock.contentFps,
+            st.use_damage ? "copy_with_damage" : "copy", opt.tileDiff ? " + tile diff" : "",
+            inFlight);
+
+    LatencyStats latency[SCREENCOPY_MAX_STREAMS];
+    ConsumerStats consumedPer[SCREENCOPY_MAX_STREAMS];
+    const uint64_t servedBefore = mc.stats.framesServed.load();
+    const int64_t serverCpuBefore = thread_cpu_ns(mc.thread);
+
+    g_captureRunning.store(true);
+    const int64_t startNs = pacer_now_ns();
+    std::thread captureThread(capture_thread_func, &st);
+    std::thread consumerThreads[SCREENCOPY_MAX_STREAMS];
+    for (int i = 0; i < st.num_streams; ++i)
+        consumerThreads[i] = std::thread(consumer_thread_func, &g_frameHandoff[i],
+                                         &latency[i], &consumedPer[i]);
+
+    run_output_script(mc, opt, startNs + (int64_t)(opt.seconds * 1e9));
+
+    // sample CPU before the threads exit and their clocks go away
+    const int64_t captureCpu = thread_cpu_ns(captureThread);
+    const int64_t serverCpu = thread_cpu_ns(mc.thread) - serverCpuBefore;
+    const double secs = (double)(pacer_now_ns() - startNs) / 1e9;
+
+    g_captureRunning.store(false);
+    screencopy_wake(&st);
+    captureThread.join();
+    for (int i = 0; i < st.num_streams; ++i) {
+        handoff_wake(g_frameHandoff[i]);
+        consumerThreads[i].join();
+    }
+
+    // ---------------- Results ----------------
+    // rates are per stream, latency over all of them
+    ConsumerStats consumed;
+    uint64_t dropped = 0;
+    for (int i = 0; i < st.num_streams; ++i) {
+        consumed.frames += consumedPer[i].frames;
+        consumed.damagedBytes += consumedPer[i].damagedBytes;
+        dropped += g_frameHandoff[i].dropped.load();
+        if (i > 0)
+            latency_merge(latency[0], latency[i]);
+    }
+    const uint64_t captures = g_framePacer.captures.load();
+    const double perStream = secs * st.num_streams;
+    fprintf(stderr, "Capture: %.1f fps captured, %.1f fps consumed per stream, "
+            "%llu of %llu never consumed\n",
+            captures / perStream, consumed.frames / perStream,
+            (unsigned long long)dropped, (unsigned long long)captures);
+    print_mock_stats(mc, secs);
+    for (int i = 0; i < st.num_streams; ++i)
+        if (consumedPer[i].sizeChanges || st.streams[i].reallocations)
+            fprintf(stderr, "Stream %d: %llu size changes seen, %llu buffers reallocated%s\n", i,
+                    (unsigned long long)consumedPer[i].sizeChanges,
+                    (unsigned long long)st.streams[i].reallocations,
+                    st.streams[i].lost ? ", output unplugged" : "");
+    uint64_t unchanged = 0;
+    for (int i = 0; i < st.num_streams; ++i) {
+        print_tile_diff_stats(st.streams[i].tile_diff);
+        unchanged += st.streams[i].tile_diff.unchangedFrames;
+    }
+    print_latency_stats(latency[0]);
+    fprintf(stderr, "CPU: capture thread %.1f%%, compositor thread %.1f%%\n",
+            100.0 * captureCpu / (secs * 1e9), 100.0 * serverCpu / (secs * 1e9));
+
+    printf("capbench pattern=%s streams=%d size=%ux%u damage=%d tile_diff=%d in_flight=%d "
+           "capture_fps=%.1f served_fps=%.1f consumed_fps=%.1f unchanged_fps=%.1f "
+           "damage_mbps=%.1f capture_p50_ms=%.2f "
+           "capture_p99_ms=%.2f capture_cpu_pct=%.1f compositor_cpu_pct=%.1f\n",
+           synthetic_pattern_name(opt.mock.pattern), st.num_streams,
+           st.streams[0].width, st.streams[0].height,
+           st.use_damage ? 1 : 0, opt.tileDiff ? 1 : 0, inFlight,
+           captures / perStream,
+           (mc.stats.framesServed.load() - servedBefore) / perStream,
+           consumed.frames / perStream,
+           unchanged / perStream,
+           consumed.damagedBytes / secs / 1e6,
+           latency_percentile(latency[0].stage[LATENCY_CAPTURE_TO_COPY], 50.0) / 1e6,
+           latency_percentile(latency[0].stage[LATENCY_CAPTURE_TO_COPY], 99.0) / 1e6,
+           100.0 * captureCpu / (secs * 1e9),
+           100.0 * serverCpu / (secs * 1e9));
+
+    screencopy_disconnect(&st);
+    mock_compositor_stop(mc);
+
+    // nothing captured from a changing desktop: the capture path is broken,
+    // fail the CI job
+    return (captures || opt.mock.contentFps <= 0.0f) ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+#include "cursor_layer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "pixel_format.h"
+
+static void socket_path(const char *path, char *out, size_t size)
+{
+    if (path) {
+        std::snprintf(out, size, "%s", path);
+        return;
+    }
+    const char *dir = std::getenv("XDG_RUNTIME_DIR");
+    std::snprintf(out, size, "%s/%s", dir && *dir ? dir : "/tmp", CURSOR_SOCKET_NAME);
+}
+
+static bool make_address(const char *path, sockaddr_un *addr)
+{
+    std::memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(addr->sun_path)) {
+        std::fprintf(stderr, "Cursor socket path too long: %s\n", path);
+        return false;
+    }
+    std::strcpy(addr->sun_path, path);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Messages
+// ---------------------------------------------------------------------------
+
+static bool apply_message(CursorLayer &c, const uint8_t *data, size_t len)
+{
+    CursorMsgHeader hdr;
+    if (len < sizeof(hdr))
+        return false;
+    std::memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.magic != CURSOR_MAGIC)
+        return false;
+
+    switch (hdr.type) {
+    case CURSOR_MSG_POSITION: {
+        CursorMsgPosition m;
+        if (len != sizeof(m))
+            return false;
+        std::memcpy(&m, data, sizeof(m));
+        c.visible = true;
+        c.x = m.x;
+        c.y = m.y;
+        c.eventNs = m.eventNs;
+        c.positionSeq++;
+        return true;
+    }
+    case CURSOR_MSG_IMAGE: {
+        CursorMsgImage m;
+        if (len < sizeof(m))
+            return false;
+        std::memcpy(&m, data, sizeof(m));
+        if (m.width == 0 || m.height == 0 ||
+            m.width > CURSOR_MAX_SIZE || m.height > CURSOR_MAX_SIZE || m.scale < 1)
+            return false;
+        const size_t pixels = (size_t)m.width * m.height;
+        if (len != sizeof(m) + pixels * 4)
+            return false;
+        c.pixels.resize(pixels);
+        std::memcpy(c.pixels.data(), data + sizeof(m), pixels * 4);
+        c.width = (int)m.width;
+        c.height = (int)m.height;
+        c.hotX = m.hotX;
+        c.hotY = m.hotY;
+        c.scale = m.scale;
+        c.imageSeq++;
+        return true;
+    }
+    case CURSOR_MSG_HIDE:
+        if (len != sizeof(hdr))
+            return false;
+        c.visible = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void upload_image(CursorLayer &c)
+{
+    const PixelFormat *pf = pixel_format_lookup(SHM_FORMAT_ARGB8888);
+    if (!c.tex) {
+        glGenTextures(1, &c.tex);
+        glBindTexture(GL_TEXTURE_2D, c.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, c.tex);
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, pf->internalFormat, c.width, c.height, 0,
+                 pf->format, pf->type, c.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    c.texSeq = c.imageSeq;
+}
+
+// ---------------------------------------------------------------------------
+// Receiver
+// ---------------------------------------------------------------------------
+
+bool cursor_layer_open(CursorLayer &c, const char *path)
+{
+    socket_path(path, c.path, sizeof(c.path));
+    sockaddr_un addr;
+    if (!make_address(c.path, &addr))
+        return false;
+
+    c.fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c.fd < 0) {
+        std::perror("cursor socket");
+        return false;
+    }
+    unlink(c.path);
+    if (bind(c.fd, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+        std::fprintf(stderr, "Cursor socket %s: %s\n", c.path, std::strerror(errno));
+        close(c.fd);
+        c.fd = -1;
+        return false;
+    }
+    c.rx.resize(sizeof(CursorMsgImage) + (size_t)CURSOR_MAX_SIZE * CURSOR_MAX_SIZE * 4);
+    return true;
+}
+
+void cursor_layer_close(CursorLayer &c)
+{
+    if (c.tex)
+        glDeleteTextures(1, &c.tex);
+    c.tex = 0;
+    if (c.fd >= 0) {
+        close(c.fd);
+        unlink(c.path);
+    }
+    c.fd = -1;
+}
+
+void cursor_layer_poll(CursorLayer &c)
+{
+    if (c.fd < 0)
+        return;
+
+    // only the newest position counts, so a backlog costs one pass here
+    for (;;) {
+        const ssize_t n = recv(c.fd, c.rx.data(), c.rx.size(), MSG_DONTWAIT | MSG_TRUNC);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;      // EAGAIN: drained
+        }
+        c.messages++;
+        if ((size_t)n > c.rx.size() || !apply_message(c, c.rx.data(), (size_t)n))
+            c.rejected++;
+    }
+
+    if (c.imageSeq != c.texSeq)
+        upload_image(c);
+}
+
+bool cursor_layer_uv(const CursorLayer &c, int rx, int ry, int rw, int rh, float uv[4])
+{
+    if (!c.visible || !c.tex || rw <= 0 || rh <= 0)
+        return false;
+    if (c.x < rx || c.y < ry || c.x >= rx + rw || c.y >= ry + rh)
+        return false;
+
+    const float scale = (float)c.scale;
+    const float left = (float)(c.x - rx) - (float)c.hotX / scale;
+    const float top  = (float)(c.y - ry) - (float)c.hotY / scale;
+    uv[0] = left / (float)rw;
+    uv[1] = top / (float)rh;
+    uv[2] = (left + (float)c.width / scale) / (float)rw;
+    uv[3] = (top + (float)c.height / scale) / (float)rh;
+    return true;
+}
+
+void cursor_layer_drawn(CursorLayer &c, int64_t nowNs)
+{
+    if (c.drawnSeq == c.positionSeq)
+        return;
+    c.drawnSeq = c.positionSeq;
+    c.positionsDrawn++;
+    if (c.eventNs > 0 && nowNs >= c.eventNs) {
+        const int64_t d = nowNs - c.eventNs;
+        c.timedDraws++;
+        c.motionToDrawNs += d;
+        c.maxMotionToDrawNs = std::max(c.maxMotionToDrawNs, d);
+    }
+}
+
+void print_cursor_layer_stats(const CursorLayer &c)
+{
+    if (c.fd < 0 && !c.messages)
+        return;
+    std::fprintf(stderr, "Cursor layer: %llu messages (%llu rejected), %llu positions drawn",
+                 (unsigned long long)c.messages, (unsigned long long)c.rejected,
+                 (unsigned long long)c.positionsDrawn);
+    if (c.timedDraws)
+        std::fprintf(stderr, ", motion to draw %.2f ms avg, %.2f ms max",
+                     (double)c.motionToDrawNs / 1e6 / (double)c.timedDraws,
+                     (double)c.maxMotionToDrawNs / 1e6);
+    std::fprintf(stderr, "\n");
+}
+
+// ---------------------------------------------------------------------------
+// Sender
+// ---------------------------------------------------------------------------
+
+int cursor_sender_connect(const char *path)
+{
+    char p[sizeof(((sockaddr_un *)nullptr)->sun_path)];
+    socket_path(path, p, sizeof(p));
+    sockaddr_un addr;
+    if (!make_address(p, &addr))
+        return -1;
+
+    const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const void *data, size_t len)
+{
+    return send(fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)len;
+}
+
+bool cursor_send_position(int fd, int x, int y, int64_t eventNs)
+{
+    CursorMsgPosition m;
+    m.hdr.magic = CURSOR_MAGIC;
+    m.hdr.type = CURSOR_MSG_POSITION;
+    m.x = x;
+    m.y = y;
+    m.eventNs = eventNs;
+    return send_all(fd, &m, sizeof(m));
+}
+
+bool cursor_send_image(int fd, int width, int height, int hotX, int hotY, int scale,
+                       const uint32_t *pixels)
+{
+    if (width <= 0 || height <= 0 || width > CURSOR_MAX_SIZE || height > CURSOR_MAX_SIZE)
+        return false;
+
+    CursorMsgImage m;
+    m.hdr.magic = CURSOR_MAGIC;
+    m.hdr.type = CURSOR_MSG_IMAGE;
+    m.width = (uint32_t)width;
+    m.height = (uint32_t)height;
+    m.hotX = hotX;
+    m.hotY = hotY;
+    m.scale = scale;
+    m.reserved = 0;
+
+    std::vector<uint8_t> msg(sizeof(m) + (size_t)width * height * 4);
+    std::memcpy(msg.data(), &m, sizeof(m));
+    std::memcpy(msg.data() + sizeof(m), pixels, (size_t)width * height * 4);
+    return send_all(fd, msg.data(), msg.size());
+}
+
+bool cursor_send_hide(int fd)
+{
+    CursorMsgHeader m;
+    m.magic = CURSOR_MAGIC;
+    m.type = CURSOR_MSG_HIDE;
+    return send_all(fd, &m, sizeof(m));
+}
@@ -0,0 +1,131 @@
+#ifndef CURSOR_LAYER_H
+#define CURSOR_LAYER_H
+
+// The pointer as its own layer.
+//
+// A pointer that is part of the captured frames only moves as fast as whole
+// frames are captured and uploaded, and every move damages the desktop.
+// With the cursor layer on, frames are captured without the pointer
+// (screencopy_state::overlay_cursor) and its position and image come in
+// through a side channel instead: a local datagram socket that whatever
+// knows the pointer (a compositor plugin, an input helper) sends to.
+// wlr-screencopy has no cursor capture of its own, so the socket stands in
+// for one.
+//
+// The render thread drains the socket once per VR frame and draws the
+// pointer as a small quad on the panel under it; the texture is only
+// re-uploaded when a new image arrives.
+//
+// One message per datagram, in native byte order:
+//   CursorMsgPosition  hotspot in the compositor's logical coordinates
+//   CursorMsgImage     followed by width * height premultiplied ARGB8888
+//                      pixels (wl_shm ARGB8888, like wl_cursor images)
+//   CursorMsgHeader    of type CURSOR_MSG_HIDE, until the next position
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdint>
+#include <vector>
+
+#define CURSOR_MAGIC        0x55435256u     // "VRCU"
+#define CURSOR_MAX_SIZE     128             // image edge, in image pixels
+#define CURSOR_SOCKET_NAME  "vrdesktop-cursor"
+
+enum CursorMsgType {
+    CURSOR_MSG_POSITION = 1,
+    CURSOR_MSG_IMAGE = 2,
+    CURSOR_MSG_HIDE = 3,
+};
+
+struct CursorMsgHeader {
+    uint32_t magic;
+    uint32_t type;
+};
+
+struct CursorMsgPosition {
+    CursorMsgHeader hdr;
+    int32_t x;
+    int32_t y;
+    int64_t eventNs;        // CLOCK_MONOTONIC of the motion, 0 if unknown
+};
+
+struct CursorMsgImage {
+    CursorMsgHeader hdr;
+    uint32_t width;
+    uint32_t height;
+    int32_t hotX;           // in image pixels
+    int32_t hotY;
+    int32_t scale;          // image pixels per logical pixel
+    uint32_t reserved;
+};
+
+struct CursorLayer {
+    int fd = -1;
+    char path[108] = "";    // sun_path
+    std::vector<uint8_t> rx;
+
+    // latest state, render thread only
+    bool visible = false;
+    int x = 0;              // hotspot, logical coordinates
+    int y = 0;
+    int64_t eventNs = 0;
+    uint64_t positionSeq = 0;
+
+    int width = 0;
+    int height = 0;
+    int hotX = 0;
+    int hotY = 0;
+    int scale = 1;
+    std::vector<uint32_t> pixels;
+    uint64_t imageSeq = 0;
+
+    GLuint tex = 0;
+    uint64_t texSeq = 0;            // image the texture holds
+    uint64_t drawnSeq = 0;          // position last drawn
+
+    uint64_t messages = 0;
+    uint64_t rejected = 0;
+    uint64_t positionsDrawn = 0;
+    uint64_t timedDraws = 0;        // ... of which the sender gave eventNs
+    int64_t motionToDrawNs = 0;
+    int64_t maxMotionToDrawNs = 0;
+};
+
+// Bind the socket (nullptr = $XDG_RUNTIME_DIR/CURSOR_SOCKET_NAME). A socket
+// file left behind at path is replaced.
+bool cursor_layer_open(CursorLayer &c, const char *path);
+
+// Close and unlink the socket; deletes the texture, so the context that
+// drew the layer must be current.
+void cursor_layer_close(CursorLayer &c);
+
+// Apply every pending message without blocking. Needs a current context:
+// a new image is uploaded here.
+void cursor_layer_poll(CursorLayer &c);
+
+// Frame UVs {u0, v0, u1, v1} of the pointer image on a panel that shows the
+// logical rect (rx, ry, rw, rh); false if the pointer is hidden, has no
+// image yet or its hotspot is outside the rect. Where the image hangs over
+// the rect's edge the UVs go past 0..1; the renderer clips them.
+bool cursor_layer_uv(const CursorLayer &c, int rx, int ry, int rw, int rh, float uv[4]);
+
+// The pointer was drawn at nowNs (pacer_now_ns); counts each position once.
+void cursor_layer_drawn(CursorLayer &c, int64_t nowNs);
+
+void print_cursor_layer_stats(const CursorLayer &c);
+
+// Sender side, for helpers and benchmarks: a socket connected to path
+// (nullptr = the default), or -1. The sends never block: they return false
+// when the socket is full, and the sender should send its newest position
+// again later rather than queue the old one.
+int cursor_sender_connect(const char *path);
+bool cursor_send_position(int fd, int x, int y, int64_t eventNs);
+bool cursor_send_image(int fd, int width, int height, int hotX, int hotY, int scale,
+                       const uint32_t *pixels);
+bool cursor_send_hide(int fd);
+
+#endif //CURSOR_LAYER_H
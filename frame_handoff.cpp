@@ -0,0 +1,103 @@
+#include "frame_handoff.h"
+
+#include <chrono>
+
+static const uint32_t HANDOFF_FRESH = 0x80000000u;
+static const uint32_t HANDOFF_INDEX = 0x0000ffffu;
+
+void handoff_init(FrameHandoff &h, int slotCount)
+{
+    if (slotCount < 3)
+        slotCount = 3;
+    if (slotCount > FRAME_HANDOFF_MAX_SLOTS)
+        slotCount = FRAME_HANDOFF_MAX_SLOTS;
+
+    h.numSlots = slotCount;
+    for (int i = 0; i < slotCount; ++i) {
+        h.slots[i].data = nullptr;
+        h.slots[i].seq = 0;
+    }
+
+    // last slot parks in the shared word, the one before it is the
+    // consumer's, everything else belongs to the producer
+    h.latest.store((uint32_t)(slotCount - 1), std::memory_order_relaxed);
+    h.readIndex = slotCount - 2;
+    h.numFree = 0;
+    for (int i = slotCount - 3; i >= 0; --i)
+        h.freeSlots[h.numFree++] = i;
+
+    h.nextSeq = 1;
+    h.published.store(0, std::memory_order_relaxed);
+    h.consumed.store(0, std::memory_order_relaxed);
+    h.dropped.store(0, std::memory_order_relaxed);
+    h.claimed.store(0, std::memory_order_relaxed);
+}
+
+int handoff_claim(FrameHandoff &h)
+{
+    if (h.numFree == 0)
+        return -1;
+    h.claimed.fetch_add(1, std::memory_order_relaxed);
+    return h.freeSlots[--h.numFree];
+}
+
+bool handoff_publish(FrameHandoff &h, int slot)
+{
+    h.slots[slot].seq = h.nextSeq++;
+
+    uint32_t prev = h.latest.exchange((uint32_t)slot | HANDOFF_FRESH,
+                                      std::memory_order_acq_rel);
+    h.freeSlots[h.numFree++] = (int)(prev & HANDOFF_INDEX);
+    h.published.fetch_add(1, std::memory_order_relaxed);
+    h.claimed.fetch_sub(1, std::memory_order_relaxed);
+
+    if (prev & HANDOFF_FRESH) {
+        h.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    handoff_wake(h);
+    return true;
+}
+
+void handoff_cancel(FrameHandoff &h, int slot)
+{
+    h.freeSlots[h.numFree++] = slot;
+    h.claimed.fetch_sub(1, std::memory_order_relaxed);
+}
+
+FrameSlot *handoff_acquire(FrameHandoff &h)
+{
+    if (!(h.latest.load(std::memory_order_relaxed) & HANDOFF_FRESH))
+        return nullptr;
+
+    // only the producer can touch the word in between, and it can only
+    // make it fresh again, so the exchange always hands us a new frame
+    uint32_t prev = h.latest.exchange((uint32_t)h.readIndex,
+                                      std::memory_order_acq_rel);
+    h.readIndex = (int)(prev & HANDOFF_INDEX);
+    h.consumed.fetch_add(1, std::memory_order_relaxed);
+    return &h.slots[h.readIndex];
+}
+
+int handoff_pending(const FrameHandoff &h)
+{
+    return (h.latest.load(std::memory_order_relaxed) & HANDOFF_FRESH) ? 1 : 0;
+}
+
+bool handoff_wait(FrameHandoff &h, int timeoutMs)
+{
+    if (handoff_pending(h))
+        return true;
+
+    std::unique_lock<std::mutex> lock(h.waitLock);
+    h.waitCond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                        [&h] { return handoff_pending(h) != 0; });
+    return handoff_pending(h) != 0;
+}
+
+void handoff_wake(FrameHandoff &h)
+{
+    // taking the lock closes the gap between a waiter's check and its sleep
+    { std::lock_guard<std::mutex> lock(h.waitLock); }
+    h.waitCond.notify_one();
+}
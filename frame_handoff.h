@@ -0,0 +1,111 @@
+#ifndef FRAME_HANDOFF_H
+#define FRAME_HANDOFF_H
+
+// Lock-free single-producer / single-consumer frame handoff.
+//
+// The capture thread (producer) and the render thread (consumer) each own
+// their own slots; the only shared state is one atomic word holding the index
+// of the most recently published slot plus a "fresh" bit. Publishing swaps the
+// producer's finished slot into that word, acquiring swaps the consumer's old
+// slot back out, so neither side ever waits on the other and nothing is held
+// while a frame is being uploaded.
+//
+// With 3 slots this is a classic triple buffer. More slots let the producer
+// keep several frames in flight at once (one slot is always parked in the
+// shared word and one is held by the consumer).
+//
+// Slots do not own pixel memory; the producer points them at its own buffers
+// (for screencopy, the wl_shm buffers the compositor writes into).
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#define FRAME_HANDOFF_MAX_SLOTS 8
+#define FRAME_MAX_DAMAGE_RECTS  32
+
+struct FrameRect {
+    int x = 0;
+    int y = 0;
+    int width  = 0;
+    int height = 0;
+};
+
+struct FrameSlot {
+    uint8_t *data = nullptr;
+    int width  = 0;
+    int height = 0;
+    int stride = 0;
+    uint32_t format = 0;   // wl_shm_format of data (0 = ARGB8888)
+    uint64_t seq = 0;      // producer sequence number, 1 = first frame
+
+    // CLOCK_MONOTONIC: compositor presentation timestamp of the content,
+    // and when the copy was reported done
+    int64_t presentNs = 0;
+    int64_t readyNs = 0;
+
+    // What the frame shows in the compositor's logical space, as of its
+    // capture (0 size: unknown). The capture side's own geometry changes
+    // under it; consumers read it from here.
+    FrameRect logical;
+
+    // Damage relative to the previous published frame (seq - 1). A consumer
+    // that skipped frames must treat the whole frame as damaged.
+    bool fullDamage = true;
+    FrameRect damage[FRAME_MAX_DAMAGE_RECTS];
+    int numDamage = 0;
+};
+
+struct FrameHandoff {
+    FrameSlot slots[FRAME_HANDOFF_MAX_SLOTS];
+    int numSlots = 0;
+
+    // producer-private free list
+    int freeSlots[FRAME_HANDOFF_MAX_SLOTS];
+    int numFree = 0;
+    uint64_t nextSeq = 1;
+
+    // consumer-private
+    int readIndex = -1;
+
+    // shared: slot index | HANDOFF_FRESH
+    std::atomic<uint32_t> latest{0};
+
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> dropped{0};   // published but overwritten before being acquired
+    std::atomic<int> claimed{0};        // slots the producer is filling right now
+
+    // only used to park a consumer that has nothing to do; the handoff
+    // itself never takes the lock
+    std::mutex waitLock;
+    std::condition_variable waitCond;
+};
+
+// Must be called before either thread touches the handoff.
+// slotCount is clamped to [3, FRAME_HANDOFF_MAX_SLOTS].
+void handoff_init(FrameHandoff &h, int slotCount);
+
+// Producer: take a free slot to fill, or -1 if every producer slot is in use.
+int handoff_claim(FrameHandoff &h);
+// Producer: publish a filled slot. Returns false if it replaced a frame the
+// consumer never saw (counted in h.dropped).
+bool handoff_publish(FrameHandoff &h, int slot);
+// Producer: give back a claimed slot without publishing it (failed capture).
+void handoff_cancel(FrameHandoff &h, int slot);
+
+// Consumer: newest published slot, or nullptr if nothing new since the last
+// call. The slot stays valid until the next successful acquire.
+FrameSlot *handoff_acquire(FrameHandoff &h);
+
+// Consumer: sleep until a frame is pending or timeoutMs passes.
+// Returns true if a frame is pending.
+bool handoff_wait(FrameHandoff &h, int timeoutMs);
+// Wake a consumer blocked in handoff_wait (e.g. on shutdown).
+void handoff_wake(FrameHandoff &h);
+
+// Number of published frames waiting for the consumer (0 or 1).
+int handoff_pending(const FrameHandoff &h);
+
+#endif //FRAME_HANDOFF_H
@@ -0,0 +1,120 @@
+#include "frame_pacer.h"
+
+#include <chrono>
+#include <cstdio>
+
+int64_t pacer_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void frame_pacer_init(FramePacer &p, float refreshHz, bool enabled)
+{
+    if (refreshHz <= 0.0f)
+        refreshHz = PACER_DEFAULT_HZ;
+
+    p.enabled = enabled;
+    p.periodNs.store((int64_t)(1e9 / refreshHz));
+    p.startNs = p.lastReportNs = pacer_now_ns();
+    p.vsyncNs.store(p.startNs);
+    p.captureNs.store(0);
+    p.lastTargetNs = 0;
+
+    p.captures.store(0);
+    p.vrFrames.store(0);
+    p.freshFrames.store(0);
+    p.lastCaptures = p.lastVrFrames = p.lastFreshFrames = p.lastWasted = 0;
+
+    std::fprintf(stderr, "Capture pacing: %s (%.1f Hz)\n",
+                 enabled ? "vsync aligned" : "off", refreshHz);
+}
+
+void frame_pacer_vsync(FramePacer &p, float secondsSinceVsync, float refreshHz)
+{
+    if (refreshHz > 0.0f)
+        p.periodNs.store((int64_t)(1e9 / refreshHz), std::memory_order_relaxed);
+    p.vsyncNs.store(pacer_now_ns() - (int64_t)(secondsSinceVsync * 1e9),
+                    std::memory_order_relaxed);
+}
+
+int64_t frame_pacer_next_issue(FramePacer &p)
+{
+    if (!p.enabled)
+        return pacer_now_ns();
+
+    const int64_t period = p.periodNs.load(std::memory_order_relaxed);
+    const int64_t vsync  = p.vsyncNs.load(std::memory_order_relaxed);
+    const int64_t lead   = PACER_READY_MARGIN_NS + p.captureNs.load(std::memory_order_relaxed);
+    const int64_t now    = pacer_now_ns();
+
+    // first vsync we can still make, and never the one already captured for
+    int64_t target = vsync + period;
+    if (target < now + lead)
+        target += ((now + lead - target) / period + 1) * period;
+    while (target <= p.lastTargetNs + period / 2)
+        target += period;
+    p.lastTargetNs = target;
+
+    return target - lead;
+}
+
+void frame_pacer_capture_done(FramePacer &p, int64_t startNs, int64_t endNs)
+{
+    p.captures.fetch_add(1, std::memory_order_relaxed);
+
+    // a damage capture that waited for the desktop to change says nothing
+    // about how long the copy takes
+    const int64_t took = endNs - startNs;
+    if (took > PACER_MAX_CAPTURE_PERIODS * p.periodNs.load(std::memory_order_relaxed))
+        return;
+    const int64_t avg = p.captureNs.load(std::memory_order_relaxed);
+    p.captureNs.store(avg ? (avg * 7 + took) / 8 : took, std::memory_order_relaxed);
+}
+
+void frame_pacer_frame(FramePacer &p, bool fresh)
+{
+    p.vrFrames.fetch_add(1, std::memory_order_relaxed);
+    if (fresh)
+        p.freshFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void frame_pacer_report(FramePacer &p, uint64_t wastedCaptures, bool final)
+{
+    const int64_t now = pacer_now_ns();
+    const uint64_t captures = p.captures.load(std::memory_order_relaxed);
+    const uint64_t vrFrames = p.vrFrames.load(std::memory_order_relaxed);
+    const uint64_t fresh    = p.freshFrames.load(std::memory_order_relaxed);
+
+    if (final) {
+        double secs = (double)(now - p.startNs) / 1e9;
+        if (secs <= 0.0)
+            return;
+        std::fprintf(stderr,
+                     "Pacing: capture %.1f fps, submitted %.1f fps (%.1f fresh), "
+                     "%llu of %llu captures wasted\n",
+                     captures / secs, vrFrames / secs, fresh / secs,
+                     (unsigned long long)wastedCaptures,
+                     (unsigned long long)captures);
+        return;
+    }
+
+    if (now - p.lastReportNs < (int64_t)PACER_REPORT_SECONDS * 1000000000ll)
+        return;
+
+    double secs = (double)(now - p.lastReportNs) / 1e9;
+    std::fprintf(stderr,
+                 "Pacing: capture %.1f fps, submitted %.1f fps (%.1f fresh), "
+                 "%llu wasted, capture %.2f ms\n",
+                 (captures - p.lastCaptures) / secs,
+                 (vrFrames - p.lastVrFrames) / secs,
+                 (fresh - p.lastFreshFrames) / secs,
+                 (unsigned long long)(wastedCaptures - p.lastWasted),
+                 p.captureNs.load(std::memory_order_relaxed) / 1e6);
+
+    p.lastReportNs = now;
+    p.lastCaptures = captures;
+    p.lastVrFrames = vrFrames;
+    p.lastFreshFrames = fresh;
+    p.lastWasted = wastedCaptures;
+}
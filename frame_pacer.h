@@ -0,0 +1,77 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+// Capture pacing against the headset refresh.
+//
+// The render thread feeds in the HMD vsync phase (GetTimeSinceLastVsync)
+// and period (Prop_DisplayFrequency_Float). The capture thread then issues
+// at most one capture per VR frame, timed so that it completes a fixed
+// margin before its vsync: start = vsync - margin - capture time, with the
+// capture time tracked as a running average. When a capture takes longer
+// than a frame, requests for later vsyncs go out while earlier ones are
+// still in flight. With copy_with_damage the
+// compositor holds a request until something changes, so an idle desktop
+// costs no copies at all.
+//
+// Without a headset the pacer free-runs at the default rate.
+
+#include <atomic>
+#include <cstdint>
+
+#define PACER_DEFAULT_HZ        90.0f
+#define PACER_READY_MARGIN_NS   4000000ll     // frame published this long before vsync
+#define PACER_REPORT_SECONDS    10
+#define PACER_MAX_CAPTURE_PERIODS 3           // longer captures sat waiting for damage
+
+struct FramePacer {
+    bool enabled = true;
+
+    // render thread -> capture thread
+    std::atomic<int64_t> periodNs{0};
+    std::atomic<int64_t> vsyncNs{0};        // steady-clock time of a recent vsync
+
+    // capture thread (captureNs is also read by the report)
+    std::atomic<int64_t> captureNs{0};      // running average of one capture
+    int64_t lastTargetNs = 0;               // vsync the previous capture aimed at
+
+    // counters
+    std::atomic<uint64_t> captures{0};
+    std::atomic<uint64_t> vrFrames{0};      // frames submitted to the compositor
+    std::atomic<uint64_t> freshFrames{0};   // ... of which showed a new capture
+
+    // render thread: periodic report
+    int64_t startNs = 0;
+    int64_t lastReportNs = 0;
+    uint64_t lastCaptures = 0;
+    uint64_t lastVrFrames = 0;
+    uint64_t lastFreshFrames = 0;
+    uint64_t lastWasted = 0;
+};
+
+int64_t pacer_now_ns();
+
+void frame_pacer_init(FramePacer &p, float refreshHz, bool enabled);
+
+// Render thread: latest vsync phase and refresh rate (refreshHz <= 0 keeps
+// the current period).
+void frame_pacer_vsync(FramePacer &p, float secondsSinceVsync, float refreshHz);
+
+// Capture thread: steady-clock time at which to issue the next capture
+// (now when pacing is disabled). Each call books the following VR frame.
+int64_t frame_pacer_next_issue(FramePacer &p);
+
+// Capture thread: a capture issued at startNs has been published.
+void frame_pacer_capture_done(FramePacer &p, int64_t startNs, int64_t endNs);
+
+// Render thread: one frame submitted to the compositor. fresh when it shows
+// a capture no earlier submit did, i.e. a panel switched to a new one since
+// (upload_thread_front's frontFrames, not a texture's seq: a tile refresh
+// swaps textures without a new capture).
+void frame_pacer_frame(FramePacer &p, bool fresh);
+
+// Render thread: print capture / submitted FPS and wasted captures (frames
+// captured but replaced before they were shown) every PACER_REPORT_SECONDS,
+// or totals when final is set.
+void frame_pacer_report(FramePacer &p, uint64_t wastedCaptures, bool final);
+
+#endif //FRAME_PACER_H
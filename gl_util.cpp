@@ -0,0 +1,15 @@
+#include "gl_util.h"
+
+#include <cstring>
+
+bool gl_has_extension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char *ext = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if (ext && std::strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,14 @@
+#ifndef GL_UTIL_H
+#define GL_UTIL_H
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+// True if the current context advertises the extension (GL 3.0+ query, so it
+// also works on core profiles).
+bool gl_has_extension(const char *name);
+
+#endif //GL_UTIL_H
@@ -0,0 +1,392 @@
+#include "hud.h"
+
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Font: ASCII 32..127, 7 rows of 5 bits each (MSB = leftmost column).
+// Lower case is drawn upper case; characters without a glyph are blank.
+// ---------------------------------------------------------------------------
+
+#define HUD_FIRST_CHAR  32
+#define HUD_NUM_CHARS   96
+#define HUD_ATLAS_COLS  16
+#define HUD_ATLAS_ROWS  (HUD_NUM_CHARS / HUD_ATLAS_COLS)
+
+static const unsigned char k_font5x7[HUD_NUM_CHARS][HUD_GLYPH_H] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   //  
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   // !
+    { 0 },
+    { 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a },   // #
+    { 0 },
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // %
+    { 0 },
+    { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },   // '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   // (
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   // )
+    { 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 },   // *
+    { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },   // +
+    { 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 },   // ,
+    { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },   // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },   // .
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // /
+    { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },   // 0
+    { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },   // 1
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },   // 2
+    { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },   // 3
+    { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },   // 4
+    { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },   // 5
+    { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },   // 6
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+    { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },   // 8
+    { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },   // 9
+    { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },   // :
+    { 0 },
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },   // <
+    { 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 },   // =
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },   // >
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },   // ?
+    { 0 },
+    { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },   // A
+    { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },   // B
+    { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },   // C
+    { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },   // D
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },   // E
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },   // F
+    { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },   // G
+    { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },   // H
+    { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },   // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },   // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },   // L
+    { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },   // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // N
+    { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },   // O
+    { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },   // P
+    { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },   // Q
+    { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },   // R
+    { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },   // S
+    { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },   // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },   // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },   // W
+    { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },   // X
+    { 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04 },   // Y
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },   // Z
+    { 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e },   // [
+    { 0 },
+    { 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e },   // ]
+    { 0 },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f },   // _
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+    { 0 },
+};
+
+// ---------------------------------------------------------------------------
+// Shaders (positions in HUD texels, origin top-left)
+// ---------------------------------------------------------------------------
+
+static const char *k_textVertexShader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 aPos;\n"
+    "layout(location = 1) in vec2 aUv;\n"
+    "uniform vec2 uViewport;\n"
+    "out vec2 vUv;\n"
+    "void main() {\n"
+    "    vUv = aUv;\n"
+    "    gl_Position = vec4(aPos / uViewport * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *k_textFragmentShader =
+    "#version 330 core\n"
+    "in vec2 vUv;\n"
+    "uniform sampler2D uAtlas;\n"
+    "uniform vec4 uColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = vec4(uColor.rgb, uColor.a * texture(uAtlas, vUv).r);\n"
+    "}\n";
+
+static GLuint compile_shader(GLenum type, const char *src)
+{
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, nullptr);
+    glCompileShader(sh);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(sh, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "HUD shader compile failed: %s\n", log);
+        glDeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+
+static GLuint link_text_program()
+{
+    GLuint v = compile_shader(GL_VERTEX_SHADER, k_textVertexShader);
+    GLuint f = compile_shader(GL_FRAGMENT_SHADER, k_textFragmentShader);
+    if (!v || !f) {
+        if (v) glDeleteShader(v);
+        if (f) glDeleteShader(f);
+        return 0;
+    }
+
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, v);
+    glAttachShader(prog, f);
+    glLinkProgram(prog);
+    glDeleteShader(v);
+    glDeleteShader(f);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(prog, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "HUD shader link failed: %s\n", log);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// ---------------------------------------------------------------------------
+// Glyph atlas
+// ---------------------------------------------------------------------------
+
+static GLuint create_atlas()
+{
+    const int w = HUD_ATLAS_COLS * HUD_CELL_W;
+    const int h = HUD_ATLAS_ROWS * HUD_CELL_H;
+    std::vector<unsigned char> pixels((size_t)w * h, 0);
+
+    for (int c = 0; c < HUD_NUM_CHARS; ++c) {
+        const int ox = (c % HUD_ATLAS_COLS) * HUD_CELL_W;
+        const int oy = (c / HUD_ATLAS_COLS) * HUD_CELL_H;
+        for (int y = 0; y < HUD_GLYPH_H; ++y)
+            for (int x = 0; x < HUD_GLYPH_W; ++x)
+                if (k_font5x7[c][y] & (0x10 >> x))
+                    pixels[(size_t)(oy + y) * w + ox + x] = 255;
+    }
+
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
+// ---------------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------------
+
+bool hud_init(Hud &h)
+{
+    h.program = link_text_program();
+    if (!h.program)
+        return false;
+    h.uViewport = glGetUniformLocation(h.program, "uViewport");
+    h.uColor = glGetUniformLocation(h.program, "uColor");
+    glUseProgram(h.program);
+    glUniform1i(glGetUniformLocation(h.program, "uAtlas"), 0);
+    glUseProgram(0);
+
+    h.atlas = create_atlas();
+
+    glGenVertexArrays(1, &h.vao);
+    glGenBuffers(1, &h.vbo);
+    glBindVertexArray(h.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, h.vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 (GLsizeiptr)(HUD_LINES * HUD_COLS * 6 * 4 * sizeof(float)),
+                 nullptr, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (const void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                          (const void *)(2 * sizeof(float)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &h.tex);
+    glBindTexture(GL_TEXTURE_2D, h.tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, HUD_TEX_WIDTH, HUD_TEX_HEIGHT,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &h.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, h.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, h.tex, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::fprintf(stderr, "HUD FBO incomplete (status=0x%x)\n", status);
+        hud_destroy(h);
+        return false;
+    }
+
+    h.dirty = true;
+    return true;
+}
+
+void hud_destroy(Hud &h)
+{
+    if (h.fbo) glDeleteFramebuffers(1, &h.fbo);
+    if (h.tex) glDeleteTextures(1, &h.tex);
+    if (h.atlas) glDeleteTextures(1, &h.atlas);
+    if (h.vbo) glDeleteBuffers(1, &h.vbo);
+    if (h.vao) glDeleteVertexArrays(1, &h.vao);
+    if (h.program) glDeleteProgram(h.program);
+    h.fbo = h.tex = h.atlas = h.vbo = h.vao = h.program = 0;
+}
+
+void hud_set_line(Hud &h, int line, const char *fmt, ...)
+{
+    if (line < 0 || line >= HUD_LINES)
+        return;
+
+    char buf[HUD_COLS + 1];
+    va_list ap;
+    va_start(ap, fmt);
+    std::vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    for (char *p = buf; *p; ++p)
+        *p = (char)std::toupper((unsigned char)*p);
+
+    if (std::strcmp(buf, h.lines[line]) != 0) {
+        std::memcpy(h.lines[line], buf, sizeof(buf));
+        h.dirty = true;
+    }
+}
+
+static void push_vertex(std::vector<float> &v, float x, float y, float s, float t)
+{
+    v.push_back(x);
+    v.push_back(y);
+    v.push_back(s);
+    v.push_back(t);
+}
+
+void hud_update(Hud &h)
+{
+    if (!h.dirty || !h.fbo)
+        return;
+    h.dirty = false;
+
+    // one quad per visible character
+    const float atlasW = (float)(HUD_ATLAS_COLS * HUD_CELL_W);
+    const float atlasH = (float)(HUD_ATLAS_ROWS * HUD_CELL_H);
+    std::vector<float> verts;
+    verts.reserve(HUD_LINES * HUD_COLS * 6 * 4);
+
+    for (int line = 0; line < HUD_LINES; ++line) {
+        const float y0 = (float)(HUD_PAD + line * HUD_CELL_H * HUD_SCALE);
+        const float y1 = y0 + HUD_GLYPH_H * HUD_SCALE;
+        for (int col = 0; h.lines[line][col]; ++col) {
+            int c = (unsigned char)h.lines[line][col] - HUD_FIRST_CHAR;
+            if (c <= 0 || c >= HUD_NUM_CHARS)
+                continue;   // space or unprintable
+
+            const float x0 = (float)(HUD_PAD + col * HUD_CELL_W * HUD_SCALE);
+            const float x1 = x0 + HUD_GLYPH_W * HUD_SCALE;
+            const float s0 = (float)((c % HUD_ATLAS_COLS) * HUD_CELL_W) / atlasW;
+            const float t0 = (float)((c / HUD_ATLAS_COLS) * HUD_CELL_H) / atlasH;
+            const float s1 = s0 + HUD_GLYPH_W / atlasW;
+            const float t1 = t0 + HUD_GLYPH_H / atlasH;
+
+            push_vertex(verts, x0, y0, s0, t0);
+            push_vertex(verts, x0, y1, s0, t1);
+            push_vertex(verts, x1, y0, s1, t0);
+            push_vertex(verts, x1, y0, s1, t0);
+            push_vertex(verts, x0, y1, s0, t1);
+            push_vertex(verts, x1, y1, s1, t1);
+        }
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // HUD rows are stored top-down like the desktop texture, so the panel
+    // quad shows texel row 0 at the top
+    glBindFramebuffer(GL_FRAMEBUFFER, h.fbo);
+    glViewport(0, 0, HUD_TEX_WIDTH, HUD_TEX_HEIGHT);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.7f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (!verts.empty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, h.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(verts.size() * sizeof(float)),
+                        verts.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glUseProgram(h.program);
+        glUniform2f(h.uViewport, (float)HUD_TEX_WIDTH, (float)HUD_TEX_HEIGHT);
+        glUniform4f(h.uColor, 0.4f, 1.0f, 0.4f, 1.0f);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, h.atlas);
+        glBindVertexArray(h.vao);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 4));
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+        glDisable(GL_BLEND);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+float hud_height_meters()
+{
+    return HUD_WIDTH_METERS * (float)HUD_TEX_HEIGHT / (float)HUD_TEX_WIDTH;
+}
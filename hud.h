@@ -0,0 +1,65 @@
+#ifndef HUD_H
+#define HUD_H
+
+// Frame timing HUD shown next to the desktop panel in VR.
+//
+// Text is drawn from a built-in 5x7 bitmap font baked once into a glyph
+// atlas texture. The HUD lines are rendered into a small offscreen texture
+// only when their text changes (a few times a second), so every VR frame
+// just draws one more textured quad per eye.
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#define HUD_LINES       6
+#define HUD_COLS        40
+#define HUD_GLYPH_W     5
+#define HUD_GLYPH_H     7
+#define HUD_CELL_W      6       // glyph + spacing, in atlas texels
+#define HUD_CELL_H      9
+#define HUD_SCALE       2       // HUD texels per atlas texel
+#define HUD_PAD         8
+
+#define HUD_TEX_WIDTH   (HUD_COLS * HUD_CELL_W * HUD_SCALE + 2 * HUD_PAD)
+#define HUD_TEX_HEIGHT  (HUD_LINES * HUD_CELL_H * HUD_SCALE + 2 * HUD_PAD)
+
+#define HUD_WIDTH_METERS 0.45f
+#define HUD_GAP_METERS   0.03f  // between the desktop panel and the HUD
+
+struct Hud {
+    bool visible = false;
+
+    GLuint atlas = 0;
+    GLuint program = 0;
+    GLint uViewport = -1;
+    GLint uColor = -1;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+
+    // rendered HUD
+    GLuint fbo = 0;
+    GLuint tex = 0;
+
+    char lines[HUD_LINES][HUD_COLS + 1] = {};
+    bool dirty = true;
+};
+
+// Needs a current core-profile context.
+bool hud_init(Hud &h);
+void hud_destroy(Hud &h);
+
+// Set one line of text (printf style, upper-cased, clipped to HUD_COLS).
+// Only an actual change marks the HUD for re-rendering.
+void hud_set_line(Hud &h, int line, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// Re-render the HUD texture if any line changed. Leaves framebuffer 0 bound.
+void hud_update(Hud &h);
+
+// Height in meters of a HUD HUD_WIDTH_METERS wide.
+float hud_height_meters();
+
+#endif //HUD_H
@@ -0,0 +1,77 @@
+#include "latency.h"
+
+#include <cstdio>
+
+static const char *k_stageNames[LATENCY_STAGE_COUNT] = {
+    "capture->copy",
+    "copy->upload",
+    "upload->submit",
+    "submit->vsync",
+};
+
+void latency_record(LatencyStats &l, LatencyStage stage, int64_t ns)
+{
+    if (ns < 0)
+        return;
+
+    LatencyHistogram &h = l.stage[stage];
+    int64_t b = ns / LATENCY_BUCKET_NS;
+    h.buckets[b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS]++;
+    h.count++;
+    h.sumNs += ns;
+    if (ns > h.maxNs)
+        h.maxNs = ns;
+}
+
+void latency_merge(LatencyStats &dst, const LatencyStats &src)
+{
+    for (int s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+        LatencyHistogram &d = dst.stage[s];
+        const LatencyHistogram &h = src.stage[s];
+        for (int b = 0; b <= LATENCY_BUCKETS; ++b)
+            d.buckets[b] += h.buckets[b];
+        d.count += h.count;
+        d.sumNs += h.sumNs;
+        if (h.maxNs > d.maxNs)
+            d.maxNs = h.maxNs;
+    }
+}
+
+int64_t latency_percentile(const LatencyHistogram &h, double pct)
+{
+    if (!h.count)
+        return 0;
+
+    uint64_t rank = (uint64_t)((double)h.count * pct / 100.0);
+    if (rank >= h.count)
+        rank = h.count - 1;
+
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        seen += h.buckets[b];
+        if (seen > rank)
+            return (int64_t)(b + 1) * LATENCY_BUCKET_NS;
+    }
+    return h.maxNs;     // in the overflow bucket
+}
+
+void print_latency_stats(const LatencyStats &l)
+{
+    std::fprintf(stderr, "Latency (ms)      %8s %8s %8s %8s %8s %8s\n",
+                 "frames", "avg", "p50", "p95", "p99", "max");
+    for (int i = 0; i < LATENCY_STAGE_COUNT; ++i) {
+        const LatencyHistogram &h = l.stage[i];
+        if (!h.count) {
+            std::fprintf(stderr, "  %-15s %8s\n", k_stageNames[i], "-");
+            continue;
+        }
+        std::fprintf(stderr, "  %-15s %8llu %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+                     k_stageNames[i],
+                     (unsigned long long)h.count,
+                     (double)h.sumNs / (double)h.count / 1e6,
+                     latency_percentile(h, 50.0) / 1e6,
+                     latency_percentile(h, 95.0) / 1e6,
+                     latency_percentile(h, 99.0) / 1e6,
+                     h.maxNs / 1e6);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Capture-to-photon latency histograms.
+//
+// Every frame carries the compositor's presentation timestamp (frame_ready)
+// and the time the copy landed through the handoff and the upload. When a
+// frame first reaches the VR compositor the render thread records, per
+// stage:
+//
+//   capture -> copy     compositor timestamp to frame_ready on our side
+//   copy    -> upload   frame_ready to the texture upload being issued
+//   upload  -> submit   upload to VRCompositor()->Submit / SetOverlayTexture
+//   submit  -> vsync    Submit to the vsync that scans it out, from
+//                       IVRCompositor::GetFrameTiming
+//
+// All timestamps are CLOCK_MONOTONIC (std::chrono::steady_clock), the clock
+// wlroots stamps frames with. Only the render thread touches the stats.
+
+#include <cstdint>
+
+#define LATENCY_BUCKET_NS   50000ll     // 50 us
+#define LATENCY_BUCKETS     4000        // up to 200 ms, then overflow
+
+enum LatencyStage {
+    LATENCY_CAPTURE_TO_COPY = 0,
+    LATENCY_COPY_TO_UPLOAD,
+    LATENCY_UPLOAD_TO_SUBMIT,
+    LATENCY_SUBMIT_TO_VSYNC,
+    LATENCY_STAGE_COUNT
+};
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS + 1] = {};     // last = overflow
+    uint64_t count = 0;
+    int64_t sumNs = 0;
+    int64_t maxNs = 0;
+};
+
+struct LatencyStats {
+    LatencyHistogram stage[LATENCY_STAGE_COUNT];
+};
+
+// Negative samples (clock mismatch, missing timestamp) are ignored.
+void latency_record(LatencyStats &l, LatencyStage stage, int64_t ns);
+
+// Add src's samples to dst (per-thread stats gathered at the end).
+void latency_merge(LatencyStats &dst, const LatencyStats &src);
+
+// Value below which pct percent of the samples fall (bucket upper edge).
+int64_t latency_percentile(const LatencyHistogram &h, double pct);
+
+void print_latency_stats(const LatencyStats &l);
+
+#endif //LATENCY_H
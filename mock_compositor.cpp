@@ -0,0 +1,765 @@
+#include "mock_compositor.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <wayland-server.h>
+#include "wlr-screencopy-unstable-v1-server-protocol.h"
+#include "xdg-output-unstable-v1-server-protocol.h"
+
+#define MOCK_SCREENCOPY_VERSION 3
+#define MOCK_XDG_OUTPUT_VERSION 3
+#define MOCK_WL_OUTPUT_VERSION  4
+#define MOCK_NEVER_COPIED       UINT64_MAX
+
+// One client connection: newest content frame it has copied per output.
+struct MockClient {
+    MockCompositor *mc = nullptr;
+    wl_client *client = nullptr;
+    wl_listener destroyListener;
+    uint64_t lastSeq[MOCK_MAX_OUTPUTS];
+    MockClient *next = nullptr;
+};
+
+// One zwlr_screencopy_frame_v1.
+struct MockFrame {
+    MockCompositor *mc = nullptr;
+    wl_resource *resource = nullptr;
+    MockOutput *output = nullptr;       // null once served or failed
+    MockClient *client = nullptr;
+
+    // captured region, output coordinates
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool used = false;                  // copy already requested
+    bool withDamage = false;
+    wl_resource *buffer = nullptr;
+    wl_listener bufferDestroy;
+
+    MockFrame *next = nullptr;          // MockOutput::pending
+};
+
+static int64_t monotonic_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Clients
+// ---------------------------------------------------------------------------
+
+static void client_destroyed(wl_listener *listener, void *)
+{
+    MockClient *c = wl_container_of(listener, c, destroyListener);
+    MockClient **link = &c->mc->clients;
+    while (*link && *link != c)
+        link = &(*link)->next;
+    if (*link)
+        *link = c->next;
+    delete c;
+}
+
+static MockClient *mock_client_get(MockCompositor *mc, wl_client *client)
+{
+    for (MockClient *c = mc->clients; c; c = c->next)
+        if (c->client == client)
+            return c;
+
+    MockClient *c = new MockClient();
+    c->mc = mc;
+    c->client = client;
+    for (int i = 0; i < MOCK_MAX_OUTPUTS; ++i)
+        c->lastSeq[i] = MOCK_NEVER_COPIED;
+    c->destroyListener.notify = client_destroyed;
+    wl_client_add_destroy_listener(client, &c->destroyListener);
+    c->next = mc->clients;
+    mc->clients = c;
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// Content
+// ---------------------------------------------------------------------------
+
+static void output_step_content(MockOutput &out)
+{
+    MockDamage &d = out.history[(out.seq + 1) % MOCK_DAMAGE_HISTORY];
+    const int n = synthetic_source_step(out.content, d.rects);
+    d.seq = ++out.seq;
+    d.full = n < 0;
+    d.numRects = n < 0 ? 0 : n;
+}
+
+static bool intersect(const FrameRect &a, const MockFrame &f, FrameRect *out)
+{
+    const int x0 = a.x > f.x ? a.x : f.x;
+    const int y0 = a.y > f.y ? a.y : f.y;
+    const int x1 = a.x + a.width  < f.x + f.width  ? a.x + a.width  : f.x + f.width;
+    const int y1 = a.y + a.height < f.y + f.height ? a.y + a.height : f.y + f.height;
+    if (x1 <= x0 || y1 <= y0)
+        return false;
+    out->x = x0 - f.x;
+    out->y = y0 - f.y;
+    out->width  = x1 - x0;
+    out->height = y1 - y0;
+    return true;
+}
+
+// Damage since the client's last copy, in frame coordinates. Returns -1 when
+// the whole frame must be treated as damaged.
+static int collect_damage(const MockOutput &out, const MockFrame &f, uint64_t lastSeq,
+                          FrameRect *rects, int maxRects)
+{
+    if (lastSeq == MOCK_NEVER_COPIED || out.seq - lastSeq > MOCK_DAMAGE_HISTORY)
+        return -1;
+
+    int n = 0;
+    for (uint64_t s = lastSeq + 1; s <= out.seq; ++s) {
+        const MockDamage &d = out.history[s % MOCK_DAMAGE_HISTORY];
+        if (d.full)
+            return -1;
+        for (int i = 0; i < d.numRects; ++i) {
+            FrameRect r;
+            if (!intersect(d.rects[i], f, &r))
+                continue;
+            if (n == maxRects)
+                return -1;
+            rects[n++] = r;
+        }
+    }
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Screencopy frames
+// ---------------------------------------------------------------------------
+
+static void frame_unlink(MockFrame *f)
+{
+    if (f->output) {
+        MockFrame **link = &f->output->pending;
+        while (*link && *link != f)
+            link = &(*link)->next;
+        if (*link)
+            *link = f->next;
+        f->output = nullptr;
+    }
+    if (f->buffer) {
+        wl_list_remove(&f->bufferDestroy.link);
+        f->buffer = nullptr;
+    }
+    f->next = nullptr;
+}
+
+static void frame_fail(MockFrame *f)
+{
+    frame_unlink(f);
+    zwlr_screencopy_frame_v1_send_failed(f->resource);
+    f->mc->stats.framesFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void frame_buffer_destroyed(wl_listener *listener, void *)
+{
+    MockFrame *f = wl_container_of(listener, f, bufferDestroy);
+    wl_list_remove(&f->bufferDestroy.link);
+    f->buffer = nullptr;
+    frame_fail(f);
+}
+
+static void frame_serve(MockFrame *f, int64_t presentNs)
+{
+    MockOutput &out = *f->output;
+    MockCompositor *mc = f->mc;
+    uint64_t &lastSeq = f->client->lastSeq[out.index];
+
+    // sized before a mode change
+    if (f->x + f->width > out.cfg.width || f->y + f->height > out.cfg.height) {
+        frame_fail(f);
+        return;
+    }
+
+    // the compositor's copy: the region of the current output image
+    wl_shm_buffer *shm = wl_shm_buffer_get(f->buffer);
+    const int stride = wl_shm_buffer_get_stride(shm);
+    const SyntheticSource &src = out.content;
+    wl_shm_buffer_begin_access(shm);
+    uint8_t *dst = static_cast<uint8_t *>(wl_shm_buffer_get_data(shm));
+    for (int y = 0; y < f->height; ++y)
+        std::memcpy(dst + (size_t)y * stride,
+                    src.desktop + (size_t)(f->y + y) * src.stride + (size_t)f->x * 4,
+                    (size_t)f->width * 4);
+    wl_shm_buffer_end_access(shm);
+
+    zwlr_screencopy_frame_v1_send_flags(f->resource, 0);
+    if (f->withDamage) {
+        FrameRect rects[FRAME_MAX_DAMAGE_RECTS];
+        int n = collect_damage(out, *f, lastSeq, rects, FRAME_MAX_DAMAGE_RECTS);
+        if (n < 0) {
+            rects[0].x = rects[0].y = 0;
+            rects[0].width = f->width;
+            rects[0].height = f->height;
+            n = 1;
+        }
+        for (int i = 0; i < n; ++i)
+            zwlr_screencopy_frame_v1_send_damage(f->resource, (uint32_t)rects[i].x,
+                                                 (uint32_t)rects[i].y,
+                                                 (uint32_t)rects[i].width,
+                                                 (uint32_t)rects[i].height);
+    }
+
+    const uint64_t sec = (uint64_t)(presentNs / 1000000000ll);
+    zwlr_screencopy_frame_v1_send_ready(f->resource, (uint32_t)(sec >> 32),
+                                        (uint32_t)(sec & 0xffffffffu),
+                                        (uint32_t)(presentNs % 1000000000ll));
+    lastSeq = out.seq;
+
+    mc->stats.framesServed.fetch_add(1, std::memory_order_relaxed);
+    mc->stats.bytesCopied.fetch_add((uint64_t)f->width * (uint64_t)f->height * 4,
+                                    std::memory_order_relaxed);
+    frame_unlink(f);
+}
+
+static void frame_copy_common(wl_resource *resource, wl_resource *buffer, bool withDamage)
+{
+    MockFrame *f = static_cast<MockFrame *>(wl_resource_get_user_data(resource));
+    if (f->used) {
+        wl_resource_post_error(resource, ZWLR_SCREENCOPY_FRAME_V1_ERROR_ALREADY_USED,
+                               "frame already used");
+        return;
+    }
+    f->used = true;
+    if (!f->output)
+        return;     // already failed, the client will see that
+
+    wl_shm_buffer *shm = wl_shm_buffer_get(buffer);
+    if (!shm ||
+        (wl_shm_buffer_get_format(shm) != WL_SHM_FORMAT_XRGB8888 &&
+         wl_shm_buffer_get_format(shm) != WL_SHM_FORMAT_ARGB8888) ||
+        wl_shm_buffer_get_width(shm) != f->width ||
+        wl_shm_buffer_get_height(shm) != f->height ||
+        wl_shm_buffer_get_stride(shm) < f->width * 4) {
+        wl_resource_post_error(resource, ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
+                               "invalid buffer attributes");
+        return;
+    }
+
+    f->buffer = buffer;
+    f->withDamage = withDamage;
+    f->bufferDestroy.notify = frame_buffer_destroyed;
+    wl_resource_add_destroy_listener(buffer, &f->bufferDestroy);
+
+    // served on the output's next refresh, in request order
+    MockFrame **link = &f->output->pending;
+    while (*link)
+        link = &(*link)->next;
+    *link = f;
+}
+
+static void frame_copy(wl_client *, wl_resource *resource, wl_resource *buffer)
+{
+    frame_copy_common(resource, buffer, false);
+}
+
+static void frame_copy_with_damage(wl_client *, wl_resource *resource, wl_resource *buffer)
+{
+    frame_copy_common(resource, buffer, true);
+}
+
+static void resource_destroy(wl_client *, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+static const struct zwlr_screencopy_frame_v1_interface k_frameImpl = {
+    frame_copy,
+    resource_destroy,
+    frame_copy_with_damage,
+};
+
+static void frame_resource_destroyed(wl_resource *resource)
+{
+    MockFrame *f = static_cast<MockFrame *>(wl_resource_get_user_data(resource));
+    frame_unlink(f);
+    delete f;
+}
+
+// ---------------------------------------------------------------------------
+// Screencopy manager
+// ---------------------------------------------------------------------------
+
+static void capture(wl_client *client, wl_resource *manager, uint32_t id,
+                    wl_resource *outputResource, bool region,
+                    int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    MockCompositor *mc = static_cast<MockCompositor *>(wl_resource_get_user_data(manager));
+    wl_resource *resource = wl_resource_create(client, &zwlr_screencopy_frame_v1_interface,
+                                               wl_resource_get_version(manager), id);
+    if (!resource) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    MockFrame *f = new MockFrame();
+    f->mc = mc;
+    f->resource = resource;
+    f->client = mock_client_get(mc, client);
+    wl_resource_set_implementation(resource, &k_frameImpl, f, frame_resource_destroyed);
+
+    MockOutput *out = static_cast<MockOutput *>(wl_resource_get_user_data(outputResource));
+    f->output = out;
+    if (!out->global) {
+        frame_fail(f);      // unplugged
+        return;
+    }
+    f->width = out->cfg.width;
+    f->height = out->cfg.height;
+    if (region) {
+        // clip to the output
+        int x1 = x + width, y1 = y + height;
+        f->x = x < 0 ? 0 : x;
+        f->y = y < 0 ? 0 : y;
+        f->width  = (x1 < out->cfg.width  ? x1 : out->cfg.width)  - f->x;
+        f->height = (y1 < out->cfg.height ? y1 : out->cfg.height) - f->y;
+    }
+    if (f->width <= 0 || f->height <= 0) {
+        frame_fail(f);
+        return;
+    }
+
+    zwlr_screencopy_frame_v1_send_buffer(resource, WL_SHM_FORMAT_XRGB8888,
+                                         (uint32_t)f->width, (uint32_t)f->height,
+                                         (uint32_t)f->width * 4);
+    if (wl_resource_get_version(resource) >= ZWLR_SCREENCOPY_FRAME_V1_BUFFER_DONE_SINCE_VERSION)
+        zwlr_screencopy_frame_v1_send_buffer_done(resource);
+}
+
+static void manager_capture_output(wl_client *client, wl_resource *resource, uint32_t frame,
+                                   int32_t, wl_resource *output)
+{
+    capture(client, resource, frame, output, false, 0, 0, 0, 0);
+}
+
+static void manager_capture_output_region(wl_client *client, wl_resource *resource,
+                                          uint32_t frame, int32_t, wl_resource *output,
+                                          int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    capture(client, resource, frame, output, true, x, y, width, height);
+}
+
+static const struct zwlr_screencopy_manager_v1_interface k_screencopyImpl = {
+    manager_capture_output,
+    manager_capture_output_region,
+    resource_destroy,
+};
+
+static void screencopy_bind(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    wl_resource *resource = wl_resource_create(client, &zwlr_screencopy_manager_v1_interface,
+                                               (int)version, id);
+    if (!resource) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(resource, &k_screencopyImpl, data, nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// wl_output + xdg-output
+// ---------------------------------------------------------------------------
+
+static const struct wl_output_interface k_outputImpl = {
+    resource_destroy,   // release
+};
+
+static void output_resource_destroyed(wl_resource *resource)
+{
+    wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void output_send_mode(MockOutput *out, wl_resource *resource)
+{
+    // ~96 dpi
+    wl_output_send_geometry(resource, out->x, 0,
+                            out->cfg.width * 254 / 960, out->cfg.height * 254 / 960,
+                            WL_OUTPUT_SUBPIXEL_UNKNOWN, "vrdesktop", "mock output",
+                            WL_OUTPUT_TRANSFORM_NORMAL);
+    wl_output_send_mode(resource, WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED,
+                        out->cfg.width, out->cfg.height,
+                        (int32_t)(out->mc->cfg.refreshHz * 1000.0f));
+}
+
+static void output_bind(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    MockOutput *out = static_cast<MockOutput *>(data);
+    wl_resource *resource = wl_resource_create(client, &wl_output_interface, (int)version, id);
+    if (!resource) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(resource, &k_outputImpl, out, output_resource_destroyed);
+    wl_list_insert(&out->resources, wl_resource_get_link(resource));
+
+    output_send_mode(out, resource);
+    if (version >= WL_OUTPUT_SCALE_SINCE_VERSION)
+        wl_output_send_scale(resource, 1);
+    if (version >= WL_OUTPUT_NAME_SINCE_VERSION) {
+        wl_output_send_name(resource, out->cfg.name);
+        wl_output_send_description(resource, "vrdesktop mock output");
+    }
+    if (version >= WL_OUTPUT_DONE_SINCE_VERSION)
+        wl_output_send_done(resource);
+}
+
+static const struct zxdg_output_v1_interface k_xdgOutputImpl = {
+    resource_destroy,
+};
+
+static void xdg_output_manager_get_xdg_output(wl_client *client, wl_resource *manager,
+                                              uint32_t id, wl_resource *outputResource)
+{
+    MockOutput *out = static_cast<MockOutput *>(wl_resource_get_user_data(outputResource));
+    const int version = wl_resource_get_version(manager);
+    wl_resource *resource = wl_resource_create(client, &zxdg_output_v1_interface, version, id);
+    if (!resource) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(resource, &k_xdgOutputImpl, out, output_resource_destroyed);
+    wl_list_insert(&out->xdgResources, wl_resource_get_link(resource));
+
+    zxdg_output_v1_send_logical_position(resource, out->x, 0);
+    zxdg_output_v1_send_logical_size(resource, out->cfg.width, out->cfg.height);
+    if (version >= ZXDG_OUTPUT_V1_NAME_SINCE_VERSION) {
+        zxdg_output_v1_send_name(resource, out->cfg.name);
+        zxdg_output_v1_send_description(resource, "vrdesktop mock output");
+    }
+
+    // from version 3 on, wl_output.done closes the update
+    if (version < 3)
+        zxdg_output_v1_send_done(resource);
+    else if (wl_resource_get_version(outputResource) >= WL_OUTPUT_DONE_SINCE_VERSION)
+        wl_output_send_done(outputResource);
+}
+
+static const struct zxdg_output_manager_v1_interface k_xdgOutputManagerImpl = {
+    resource_destroy,
+    xdg_output_manager_get_xdg_output,
+};
+
+static void xdg_output_manager_bind(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    wl_resource *resource = wl_resource_create(client, &zxdg_output_manager_v1_interface,
+                                               (int)version, id);
+    if (!resource) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(resource, &k_xdgOutputManagerImpl, data, nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// Event loop
+// ---------------------------------------------------------------------------
+
+// Output refresh: advance the content when due, then serve pending frames.
+static int on_refresh(int fd, uint32_t, void *data)
+{
+    MockCompositor *mc = static_cast<MockCompositor *>(data);
+    uint64_t expirations = 0;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+
+    const int64_t now = monotonic_ns();
+    const double contentPerRefresh = mc->cfg.refreshHz > 0.0f ?
+        mc->cfg.contentFps / mc->cfg.refreshHz : 0.0;
+    mc->stats.refreshes.fetch_add(1, std::memory_order_relaxed);
+
+    for (int i = 0; i < mc->numOutputs; ++i) {
+        MockOutput &out = mc->outputs[i];
+
+        // at most one content frame per refresh, like a real output
+        out.contentDebt += contentPerRefresh;
+        if (out.contentDebt >= 1.0) {
+            out.contentDebt = out.contentDebt >= 2.0 ? 0.0 : out.contentDebt - 1.0;
+            output_step_content(out);
+        }
+
+        MockFrame *f = out.pending;
+        while (f) {
+            MockFrame *next = f->next;
+            if (!f->withDamage || f->client->lastSeq[out.index] != out.seq)
+                frame_serve(f, now);
+            f = next;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Mode changes and hotplug (server thread)
+// ---------------------------------------------------------------------------
+
+static void output_fail_pending(MockOutput &out)
+{
+    while (out.pending)
+        frame_fail(out.pending);
+}
+
+// The whole output counts as changed for every client.
+static void output_damage_all(MockOutput &out)
+{
+    MockDamage &d = out.history[(out.seq + 1) % MOCK_DAMAGE_HISTORY];
+    d = MockDamage();
+    d.seq = ++out.seq;
+    d.full = true;
+}
+
+static void output_resize(MockCompositor *mc, MockOutput &out, int width, int height)
+{
+    output_fail_pending(out);
+    synthetic_source_destroy(out.content);
+    if (!synthetic_source_init(out.content, width, height, mc->cfg.pattern, 0)) {
+        std::fprintf(stderr, "mock compositor: unable to resize output %d\n", out.index);
+        synthetic_source_init(out.content, out.cfg.width, out.cfg.height, mc->cfg.pattern, 0);
+        return;
+    }
+    out.cfg.width = width;
+    out.cfg.height = height;
+    output_damage_all(out);
+
+    // outputs stay side by side, so the ones to the right move
+    int x = 0;
+    for (int i = 0; i < mc->numOutputs; ++i) {
+        MockOutput &o = mc->outputs[i];
+        const bool moved = o.x != x;
+        o.x = x;
+        x += o.cfg.width;
+        if (&o != &out && !moved)
+            continue;
+
+        wl_resource *r;
+        wl_resource_for_each(r, &o.xdgResources) {
+            zxdg_output_v1_send_logical_position(r, o.x, 0);
+            zxdg_output_v1_send_logical_size(r, o.cfg.width, o.cfg.height);
+            if (wl_resource_get_version(r) < 3)
+                zxdg_output_v1_send_done(r);
+        }
+        wl_resource_for_each(r, &o.resources) {
+            output_send_mode(&o, r);
+            if (wl_resource_get_version(r) >= WL_OUTPUT_DONE_SINCE_VERSION)
+                wl_output_send_done(r);
+        }
+    }
+    mc->stats.modeChanges.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void output_set_plugged(MockCompositor *mc, MockOutput &out, bool plugged)
+{
+    if (plugged) {
+        out.global = wl_global_create(mc->display, &wl_output_interface,
+                                      MOCK_WL_OUTPUT_VERSION, &out, output_bind);
+        output_damage_all(out);
+    } else {
+        output_fail_pending(out);
+        // bound resources stay until their clients destroy them, inert
+        wl_global_destroy(out.global);
+        out.global = nullptr;
+    }
+    mc->stats.hotplugs.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void apply_output_changes(MockCompositor *mc)
+{
+    for (int i = 0; i < mc->numOutputs; ++i) {
+        MockOutput &out = mc->outputs[i];
+        const bool plugged = out.wantPlugged.load();
+        if (plugged != (out.global != nullptr))
+            output_set_plugged(mc, out, plugged);
+
+        const int w = out.wantWidth.load(), h = out.wantHeight.load();
+        if (w > 0 && h > 0 && (w != out.cfg.width || h != out.cfg.height))
+            output_resize(mc, out, w, h);
+    }
+}
+
+static int on_wake(int fd, uint32_t, void *data)
+{
+    uint64_t v;
+    if (read(fd, &v, sizeof(v)) < 0 && errno != EAGAIN)
+        std::fprintf(stderr, "mock compositor: wake read failed\n");
+    apply_output_changes(static_cast<MockCompositor *>(data));
+    return 0;
+}
+
+static void server_thread_func(MockCompositor *mc)
+{
+    while (mc->running.load()) {
+        wl_event_loop_dispatch(mc->loop, -1);
+        wl_display_flush_clients(mc->display);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------------
+
+static void mock_compositor_teardown(MockCompositor &mc)
+{
+    if (mc.display) {
+        wl_display_destroy_clients(mc.display);
+        if (mc.timerSource)
+            wl_event_source_remove(mc.timerSource);
+        if (mc.wakeSource)
+            wl_event_source_remove(mc.wakeSource);
+        wl_display_destroy(mc.display);     // also destroys the globals
+    }
+    if (mc.timerFd >= 0) close(mc.timerFd);
+    if (mc.wakeFd >= 0) close(mc.wakeFd);
+    for (int i = 0; i < mc.numOutputs; ++i)
+        synthetic_source_destroy(mc.outputs[i].content);
+
+    mc.display = nullptr;
+    mc.loop = nullptr;
+    mc.timerSource = mc.wakeSource = nullptr;
+    mc.timerFd = mc.wakeFd = -1;
+    mc.numOutputs = 0;
+}
+
+bool mock_compositor_start(MockCompositor &mc, const MockConfig &cfg)
+{
+    mc.cfg = cfg;
+    if (mc.cfg.refreshHz <= 0.0f)
+        mc.cfg.refreshHz = MOCK_DEFAULT_REFRESH_HZ;
+
+    mc.display = wl_display_create();
+    if (!mc.display) {
+        std::fprintf(stderr, "mock compositor: wl_display_create failed\n");
+        return false;
+    }
+    mc.loop = wl_display_get_event_loop(mc.display);
+
+    const char *socket = wl_display_add_socket_auto(mc.display);
+    if (!socket || wl_display_init_shm(mc.display) != 0) {
+        std::fprintf(stderr, "mock compositor: unable to set up the display socket\n");
+        mock_compositor_teardown(mc);
+        return false;
+    }
+    std::snprintf(mc.socket, sizeof(mc.socket), "%s", socket);
+
+    // outputs side by side, left to right
+    int x = 0;
+    for (int i = 0; i < mc.cfg.numOutputs && i < MOCK_MAX_OUTPUTS; ++i) {
+        MockOutput &out = mc.outputs[i];
+        out.mc = &mc;
+        out.index = i;
+        out.cfg = mc.cfg.outputs[i];
+        out.x = x;
+        x += out.cfg.width;
+        wl_list_init(&out.resources);
+        wl_list_init(&out.xdgResources);
+        out.wantWidth.store(out.cfg.width);
+        out.wantHeight.store(out.cfg.height);
+        out.wantPlugged.store(true);
+        if (!synthetic_source_init(out.content, out.cfg.width, out.cfg.height,
+                                   mc.cfg.pattern, 0)) {
+            mock_compositor_teardown(mc);
+            return false;
+        }
+        mc.numOutputs++;
+        out.global = wl_global_create(mc.display, &wl_output_interface,
+                                      MOCK_WL_OUTPUT_VERSION, &out, output_bind);
+    }
+    mc.screencopyGlobal = wl_global_create(mc.display, &zwlr_screencopy_manager_v1_interface,
+                                           MOCK_SCREENCOPY_VERSION, &mc, screencopy_bind);
+    mc.xdgOutputGlobal = wl_global_create(mc.display, &zxdg_output_manager_v1_interface,
+                                          MOCK_XDG_OUTPUT_VERSION, &mc, xdg_output_manager_bind);
+
+    // refresh timer and a wakeup for stopping the loop
+    mc.timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    mc.wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mc.timerFd < 0 || mc.wakeFd < 0) {
+        std::fprintf(stderr, "mock compositor: %s\n", std::strerror(errno));
+        mock_compositor_teardown(mc);
+        return false;
+    }
+    const int64_t periodNs = (int64_t)(1e9 / mc.cfg.refreshHz);
+    itimerspec its = {};
+    its.it_interval.tv_sec = periodNs / 1000000000ll;
+    its.it_interval.tv_nsec = periodNs % 1000000000ll;
+    its.it_value = its.it_interval;
+    timerfd_settime(mc.timerFd, 0, &its, nullptr);
+    mc.timerSource = wl_event_loop_add_fd(mc.loop, mc.timerFd, WL_EVENT_READABLE, on_refresh, &mc);
+    mc.wakeSource = wl_event_loop_add_fd(mc.loop, mc.wakeFd, WL_EVENT_READABLE, on_wake, &mc);
+
+    mc.running.store(true);
+    mc.thread = std::thread(server_thread_func, &mc);
+
+    std::fprintf(stderr, "Mock compositor on %s: %d output(s), %s, refresh %.0f Hz, "
+                 "content %.0f fps\n",
+                 mc.socket, mc.numOutputs, synthetic_pattern_name(mc.cfg.pattern),
+                 mc.cfg.refreshHz, mc.cfg.contentFps);
+    return true;
+}
+
+static void mock_compositor_poke(MockCompositor &mc)
+{
+    uint64_t one = 1;
+    if (write(mc.wakeFd, &one, sizeof(one)) < 0)
+        std::fprintf(stderr, "mock compositor: wake failed\n");
+}
+
+void mock_compositor_resize_output(MockCompositor &mc, int index, int width, int height)
+{
+    if (index < 0 || index >= mc.numOutputs)
+        return;
+    mc.outputs[index].wantWidth.store(width);
+    mc.outputs[index].wantHeight.store(height);
+    mock_compositor_poke(mc);
+}
+
+void mock_compositor_plug_output(MockCompositor &mc, int index, bool plugged)
+{
+    if (index < 0 || index >= mc.numOutputs)
+        return;
+    mc.outputs[index].wantPlugged.store(plugged);
+    mock_compositor_poke(mc);
+}
+
+void mock_compositor_stop(MockCompositor &mc)
+{
+    if (mc.running.exchange(false)) {
+        mock_compositor_poke(mc);
+        if (mc.thread.joinable())
+            mc.thread.join();
+    }
+    mock_compositor_teardown(mc);
+}
+
+void print_mock_stats(const MockCompositor &mc, double seconds)
+{
+    const MockStats &s = mc.stats;
+    const uint64_t served = s.framesServed.load();
+    std::fprintf(stderr,
+                 "Mock compositor: %llu frames served (%.1f fps), %llu failed, "
+                 "%.1f MB/s copied, %llu refreshes\n",
+                 (unsigned long long)served,
+                 seconds > 0.0 ? served / seconds : 0.0,
+                 (unsigned long long)s.framesFailed.load(),
+                 seconds > 0.0 ? s.bytesCopied.load() / seconds / 1e6 : 0.0,
+                 (unsigned long long)s.refreshes.load());
+    if (s.modeChanges.load() || s.hotplugs.load())
+        std::fprintf(stderr, "Mock compositor: %llu mode changes, %llu hotplugs\n",
+                     (unsigned long long)s.modeChanges.load(),
+                     (unsigned long long)s.hotplugs.load());
+}
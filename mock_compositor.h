@@ -0,0 +1,129 @@
+#ifndef MOCK_COMPOSITOR_H
+#define MOCK_COMPOSITOR_H
+
+// Stand-in Wayland compositor for capture benchmarks and CI.
+//
+// A minimal libwayland-server display advertising wl_shm, wl_output,
+// zxdg_output_manager_v1 (v3) and zwlr_screencopy_manager_v1 (v3). Each
+// output has a synthetic desktop (see synthetic_source.h) that changes by a
+// scripted damage pattern at a set rate. Outputs "refresh" on a timerfd:
+// every tick the pending screencopy frames are served, copy_with_damage ones
+// only once their client has damage it has not seen, with the damage rects
+// accumulated since its last copy and a CLOCK_MONOTONIC presentation time.
+//
+// The server runs its own event loop thread, so the real capture engine can
+// connect to it from the same process through WAYLAND_DISPLAY. Outputs can
+// be resized (a mode change) or unplugged and plugged back while it runs.
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <wayland-util.h>
+
+#include "synthetic_source.h"
+
+#define MOCK_MAX_OUTPUTS        4
+#define MOCK_DAMAGE_HISTORY     8       // content frames a client may fall behind
+#define MOCK_DEFAULT_REFRESH_HZ 60.0f
+
+struct wl_display;
+struct wl_event_loop;
+struct wl_event_source;
+struct wl_global;
+struct MockFrame;
+struct MockClient;
+
+struct MockOutputConfig {
+    char name[32] = "MOCK-1";
+    int width = 1920;
+    int height = 1080;
+};
+
+struct MockConfig {
+    MockOutputConfig outputs[MOCK_MAX_OUTPUTS];
+    int numOutputs = 1;
+    SyntheticPattern pattern = SYNTHETIC_BOX;
+    float refreshHz = MOCK_DEFAULT_REFRESH_HZ;
+    float contentFps = MOCK_DEFAULT_REFRESH_HZ;   // desktop changes per second, 0 = static
+};
+
+// Damage of one content frame.
+struct MockDamage {
+    uint64_t seq = 0;
+    bool full = false;
+    FrameRect rects[FRAME_MAX_DAMAGE_RECTS];
+    int numRects = 0;
+};
+
+struct MockCompositor;
+
+struct MockOutput {
+    MockCompositor *mc = nullptr;
+    int index = 0;
+    MockOutputConfig cfg;
+    int x = 0;                          // position in the compositor space
+    wl_global *global = nullptr;        // null while unplugged
+    wl_list resources;                  // bound wl_outputs
+    wl_list xdgResources;               // their xdg-outputs
+
+    // requested from other threads, applied on the server thread
+    std::atomic<int> wantWidth{0};
+    std::atomic<int> wantHeight{0};
+    std::atomic<bool> wantPlugged{true};
+
+    SyntheticSource content;
+    uint64_t seq = 0;                   // content frames produced so far
+    MockDamage history[MOCK_DAMAGE_HISTORY];
+    double contentDebt = 0.0;           // fractional content frames owed
+
+    MockFrame *pending = nullptr;       // frames waiting for the next refresh
+};
+
+struct MockStats {
+    std::atomic<uint64_t> framesServed{0};
+    std::atomic<uint64_t> framesFailed{0};
+    std::atomic<uint64_t> bytesCopied{0};
+    std::atomic<uint64_t> refreshes{0};
+    std::atomic<uint64_t> modeChanges{0};
+    std::atomic<uint64_t> hotplugs{0};   // unplugs and replugs
+};
+
+struct MockCompositor {
+    MockConfig cfg;
+    wl_display *display = nullptr;
+    wl_event_loop *loop = nullptr;
+    wl_event_source *timerSource = nullptr;
+    wl_event_source *wakeSource = nullptr;
+    wl_global *screencopyGlobal = nullptr;
+    wl_global *xdgOutputGlobal = nullptr;
+    int timerFd = -1;
+    int wakeFd = -1;
+    char socket[64] = {};               // WAYLAND_DISPLAY value clients use
+
+    MockOutput outputs[MOCK_MAX_OUTPUTS];
+    int numOutputs = 0;
+
+    // per client: newest content frame it has copied from each output
+    MockClient *clients = nullptr;
+
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    MockStats stats;
+};
+
+// Create the display, globals and listening socket and start the server
+// thread. Returns false (with nothing left running) on failure.
+bool mock_compositor_start(MockCompositor &mc, const MockConfig &cfg);
+void mock_compositor_stop(MockCompositor &mc);
+
+// From any thread: change an output's mode, or unplug / replug it. Pending
+// frames of the output fail; clients see the new mode and xdg-output
+// geometry, or the global going away and coming back.
+void mock_compositor_resize_output(MockCompositor &mc, int index, int width, int height);
+void mock_compositor_plug_output(MockCompositor &mc, int index, bool plugged);
+
+void print_mock_stats(const MockCompositor &mc, double seconds);
+
+#endif //MOCK_COMPOSITOR_H
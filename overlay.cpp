@@ -0,0 +1,298 @@
+#include "overlay.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#define OVERLAY_KEY  "vrdesktop.desktop"
+#define OVERLAY_NAME "VR Desktop"
+
+#define OVERLAY_STUB_FRAME_NS 11111111ll   // 90 Hz
+
+// ---------------------------------------------------------------------------
+// OpenVR backend
+// ---------------------------------------------------------------------------
+
+static bool openvr_check(vr::EVROverlayError err, const char *what)
+{
+    if (err == vr::VROverlayError_None)
+        return true;
+    std::fprintf(stderr, "%s failed: %s\n", what,
+                 vr::VROverlay()->GetOverlayErrorNameFromEnum(err));
+    return false;
+}
+
+static bool openvr_create(OverlayPanel &o, const char *key, const char *friendlyName)
+{
+    if (!vr::VROverlay()) {
+        std::fprintf(stderr, "OpenVR overlay interface unavailable\n");
+        return false;
+    }
+    if (!openvr_check(vr::VROverlay()->CreateOverlay(key, friendlyName, &o.handle),
+                      "CreateOverlay"))
+        return false;
+    return openvr_check(vr::VROverlay()->ShowOverlay(o.handle), "ShowOverlay");
+}
+
+static void openvr_destroy(OverlayPanel &o)
+{
+    vr::VROverlay()->DestroyOverlay(o.handle);
+}
+
+static bool openvr_set_width(OverlayPanel &o, float meters)
+{
+    return openvr_check(vr::VROverlay()->SetOverlayWidthInMeters(o.handle, meters),
+                        "SetOverlayWidthInMeters");
+}
+
+static bool openvr_set_curvature(OverlayPanel &o, float curvature)
+{
+    return openvr_check(vr::VROverlay()->SetOverlayCurvature(o.handle, curvature),
+                        "SetOverlayCurvature");
+}
+
+static bool openvr_set_transform(OverlayPanel &o, const vr::HmdMatrix34_t &m)
+{
+    return openvr_check(vr::VROverlay()->SetOverlayTransformAbsolute(
+                            o.handle, vr::TrackingUniverseStanding, &m),
+                        "SetOverlayTransformAbsolute");
+}
+
+static bool openvr_set_texture(OverlayPanel &o, const vr::Texture_t &tex,
+                               const vr::VRTextureBounds_t &bounds)
+{
+    vr::IVROverlay *ov = vr::VROverlay();
+    return openvr_check(ov->SetOverlayTextureBounds(o.handle, &bounds),
+                        "SetOverlayTextureBounds") &&
+           openvr_check(ov->SetOverlayTexture(o.handle, &tex), "SetOverlayTexture");
+}
+
+static bool openvr_head_pose(OverlayPanel &, vr::HmdMatrix34_t *absoluteFromHead)
+{
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    vr::VRSystem()->GetDeviceToAbsoluteTrackingPose(
+        vr::TrackingUniverseStanding, 0.0f, poses, vr::k_unMaxTrackedDeviceCount);
+
+    const vr::TrackedDevicePose_t &hmd = poses[vr::k_unTrackedDeviceIndex_Hmd];
+    if (!hmd.bPoseIsValid)
+        return false;
+    *absoluteFromHead = hmd.mDeviceToAbsoluteTracking;
+    return true;
+}
+
+static void openvr_wait_frame(OverlayPanel &, uint32_t timeoutMs)
+{
+    vr::VROverlay()->WaitFrameSync(timeoutMs);
+}
+
+static const OverlayOps k_openvrOps = {
+    "OpenVR",
+    openvr_create,
+    openvr_destroy,
+    openvr_set_width,
+    openvr_set_curvature,
+    openvr_set_transform,
+    openvr_set_texture,
+    openvr_head_pose,
+    openvr_wait_frame,
+};
+
+// ---------------------------------------------------------------------------
+// Stub backend (no headset): logs geometry, counts texture updates
+// ---------------------------------------------------------------------------
+
+static bool stub_create(OverlayPanel &o, const char *key, const char *friendlyName)
+{
+    o.handle = 1;
+    o.stubNextFrame = std::chrono::steady_clock::now();
+    std::fprintf(stderr, "[overlay stub] CreateOverlay(%s, \"%s\")\n", key, friendlyName);
+    return true;
+}
+
+static void stub_destroy(OverlayPanel &)
+{
+    std::fprintf(stderr, "[overlay stub] DestroyOverlay\n");
+}
+
+static bool stub_set_width(OverlayPanel &, float meters)
+{
+    std::fprintf(stderr, "[overlay stub] SetOverlayWidthInMeters(%.3f)\n", meters);
+    return true;
+}
+
+static bool stub_set_curvature(OverlayPanel &, float curvature)
+{
+    std::fprintf(stderr, "[overlay stub] SetOverlayCurvature(%.3f)\n", curvature);
+    return true;
+}
+
+static bool stub_set_transform(OverlayPanel &, const vr::HmdMatrix34_t &m)
+{
+    std::fprintf(stderr, "[overlay stub] SetOverlayTransformAbsolute(t=%.2f,%.2f,%.2f)\n",
+                 m.m[0][3], m.m[1][3], m.m[2][3]);
+    return true;
+}
+
+static bool stub_set_texture(OverlayPanel &, const vr::Texture_t &tex,
+                             const vr::VRTextureBounds_t &)
+{
+    return tex.handle != nullptr;
+}
+
+static bool stub_head_pose(OverlayPanel &, vr::HmdMatrix34_t *absoluteFromHead)
+{
+    // head at the origin looking down -Z
+    std::memset(absoluteFromHead, 0, sizeof(*absoluteFromHead));
+    for (int i = 0; i < 3; ++i)
+        absoluteFromHead->m[i][i] = 1.0f;
+    return true;
+}
+
+static void stub_wait_frame(OverlayPanel &o, uint32_t)
+{
+    o.stubNextFrame += std::chrono::nanoseconds(OVERLAY_STUB_FRAME_NS);
+    auto now = std::chrono::steady_clock::now();
+    if (o.stubNextFrame < now)
+        o.stubNextFrame = now;     // fell behind, don't try to catch up
+    std::this_thread::sleep_until(o.stubNextFrame);
+}
+
+static const OverlayOps k_stubOps = {
+    "stub",
+    stub_create,
+    stub_destroy,
+    stub_set_width,
+    stub_set_curvature,
+    stub_set_transform,
+    stub_set_texture,
+    stub_head_pose,
+    stub_wait_frame,
+};
+
+// ---------------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------------
+
+bool overlay_panel_init(OverlayPanel &o, OverlayBackend backend, int index)
+{
+    o = OverlayPanel();
+    if (backend == OVERLAY_BACKEND_OPENVR)
+        o.ops = &k_openvrOps;
+    else if (backend == OVERLAY_BACKEND_STUB)
+        o.ops = &k_stubOps;
+    else
+        return false;
+
+    // the first panel keeps the plain key, so existing bindings still apply
+    char key[64], name[64];
+    if (index == 0) {
+        std::snprintf(key, sizeof(key), "%s", OVERLAY_KEY);
+        std::snprintf(name, sizeof(name), "%s", OVERLAY_NAME);
+    } else {
+        std::snprintf(key, sizeof(key), "%s.%d", OVERLAY_KEY, index + 1);
+        std::snprintf(name, sizeof(name), "%s %d", OVERLAY_NAME, index + 1);
+    }
+    if (!o.ops->create(o, key, name)) {
+        o.ops = nullptr;
+        return false;
+    }
+    std::fprintf(stderr, "Overlay mode (%s backend)\n", o.ops->name);
+    return true;
+}
+
+void overlay_panel_destroy(OverlayPanel &o)
+{
+    if (!o.ops)
+        return;
+    o.ops->destroy(o);
+    o.ops = nullptr;
+    o.handle = vr::k_ulOverlayHandleInvalid;
+}
+
+bool overlay_panel_head_pose(OverlayPanel &o, float absoluteFromHeadRow[16])
+{
+    vr::HmdMatrix34_t m;
+    if (!o.ops || !o.ops->head_pose(o, &m))
+        return false;
+
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c)
+            absoluteFromHeadRow[r*4 + c] = m.m[r][c];
+    absoluteFromHeadRow[12] = absoluteFromHeadRow[13] = absoluteFromHeadRow[14] = 0.0f;
+    absoluteFromHeadRow[15] = 1.0f;
+    return true;
+}
+
+void overlay_panel_set_geometry(OverlayPanel &o, float widthMeters, float curvature,
+                                const float absoluteFromPanelRow[16])
+{
+    if (!o.ops)
+        return;
+
+    bool changed = false;
+    if (!o.haveGeometry || o.widthMeters != widthMeters) {
+        o.ops->set_width(o, widthMeters);
+        o.widthMeters = widthMeters;
+        changed = true;
+    }
+    if (!o.haveGeometry || o.curvature != curvature) {
+        o.ops->set_curvature(o, curvature);
+        o.curvature = curvature;
+        changed = true;
+    }
+    if (!o.haveGeometry || std::memcmp(o.poseRow, absoluteFromPanelRow, sizeof(o.poseRow)) != 0) {
+        vr::HmdMatrix34_t m;
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 4; ++c)
+                m.m[r][c] = absoluteFromPanelRow[r*4 + c];
+        o.ops->set_transform(o, m);
+        std::memcpy(o.poseRow, absoluteFromPanelRow, sizeof(o.poseRow));
+        changed = true;
+    }
+
+    o.haveGeometry = true;
+    if (changed)
+        o.stats.geometryUpdates++;
+}
+
+void overlay_panel_set_texture(OverlayPanel &o, GLuint tex, uint64_t seq)
+{
+    if (!o.ops || !tex || (tex == o.texture && seq == o.textureSeq))
+        return;
+
+    // rows are stored top-down, GL samples bottom-up: flip v
+    vr::VRTextureBounds_t bounds = { 0.0f, 1.0f, 1.0f, 0.0f };
+    vr::Texture_t t = {
+        (void*)(uintptr_t)tex,
+        vr::TextureType_OpenGL,
+        vr::ColorSpace_Auto
+    };
+
+    // the compositor reads the texture from its own context
+    glFlush();
+    if (o.ops->set_texture(o, t, bounds)) {
+        o.texture = tex;
+        o.textureSeq = seq;
+        o.stats.textureUpdates++;
+    }
+}
+
+void overlay_panel_wait_frame(OverlayPanel &o, uint32_t timeoutMs)
+{
+    if (!o.ops)
+        return;
+    o.ops->wait_frame(o, timeoutMs);
+    o.stats.frames++;
+}
+
+void print_overlay_stats(const OverlayPanel &o)
+{
+    const OverlayStats &s = o.stats;
+    std::fprintf(stderr,
+                 "Overlay: %llu frames, %llu texture updates (%.1f%% of frames), "
+                 "%llu geometry updates\n",
+                 (unsigned long long)s.frames,
+                 (unsigned long long)s.textureUpdates,
+                 s.frames ? 100.0 * (double)s.textureUpdates / (double)s.frames : 0.0,
+                 (unsigned long long)s.geometryUpdates);
+}
@@ -0,0 +1,94 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+// Desktop panel as an OpenVR overlay.
+//
+// Instead of rendering both eyes every headset frame, the desktop texture,
+// its width in meters, transform and curvature are handed to the compositor,
+// which draws and reprojects the panel itself. A texture is pushed only when
+// a new frame arrives and geometry only when it changes.
+//
+// Calls go through a small table of overlay operations: the OpenVR one
+// forwards to vr::VROverlay(), the stub one logs and counts calls so the
+// mode can be exercised without a headset or a running runtime.
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <openvr.h>
+
+enum OverlayBackend {
+    OVERLAY_BACKEND_NONE = 0,   // scene app, render the eyes ourselves
+    OVERLAY_BACKEND_OPENVR,
+    OVERLAY_BACKEND_STUB,
+};
+
+struct OverlayStats {
+    uint64_t frames = 0;            // wait_frame calls
+    uint64_t textureUpdates = 0;
+    uint64_t geometryUpdates = 0;
+};
+
+struct OverlayPanel;
+
+// The subset of IVROverlay the panel uses.
+struct OverlayOps {
+    const char *name;
+    bool (*create)(OverlayPanel &o, const char *key, const char *friendlyName);
+    void (*destroy)(OverlayPanel &o);
+    bool (*set_width)(OverlayPanel &o, float meters);
+    bool (*set_curvature)(OverlayPanel &o, float curvature);
+    bool (*set_transform)(OverlayPanel &o, const vr::HmdMatrix34_t &absoluteFromOverlay);
+    bool (*set_texture)(OverlayPanel &o, const vr::Texture_t &tex,
+                        const vr::VRTextureBounds_t &bounds);
+    bool (*head_pose)(OverlayPanel &o, vr::HmdMatrix34_t *absoluteFromHead);
+    void (*wait_frame)(OverlayPanel &o, uint32_t timeoutMs);
+};
+
+struct OverlayPanel {
+    const OverlayOps *ops = nullptr;
+    vr::VROverlayHandle_t handle = vr::k_ulOverlayHandleInvalid;
+
+    // last values pushed, so unchanged geometry is not resent
+    bool haveGeometry = false;
+    float widthMeters = 0.0f;
+    float curvature = 0.0f;
+    float poseRow[12] = {};
+    GLuint texture = 0;             // texture last handed to the compositor
+    uint64_t textureSeq = 0;        // ... and the frame it held then
+
+    // stub: paces wait_frame like a 90 Hz headset
+    std::chrono::steady_clock::time_point stubNextFrame;
+
+    OverlayStats stats;
+};
+
+// OpenVR must already be initialised as VRApplication_Overlay for the
+// OpenVR backend; the stub needs nothing. index tells the panels of several
+// outputs apart.
+bool overlay_panel_init(OverlayPanel &o, OverlayBackend backend, int index);
+void overlay_panel_destroy(OverlayPanel &o);
+
+// Absolute-from-head pose of the HMD; false if not tracking.
+bool overlay_panel_head_pose(OverlayPanel &o, float absoluteFromHeadRow[16]);
+
+// Width in meters, curvature in (0..1] of a full cylinder (0 = flat) and the
+// absolute-from-panel pose (row-major). Only sent when something changed.
+void overlay_panel_set_geometry(OverlayPanel &o, float widthMeters, float curvature,
+                                const float absoluteFromPanelRow[16]);
+
+// Hand over the desktop texture unless this texture with frame seq is what
+// the compositor already has. With several textures in turn each one is
+// pushed when it becomes current, even for the same frame.
+void overlay_panel_set_texture(OverlayPanel &o, GLuint tex, uint64_t seq);
+
+// Block until the compositor wants the next frame (or timeoutMs passes).
+void overlay_panel_wait_frame(OverlayPanel &o, uint32_t timeoutMs);
+
+void print_overlay_stats(const OverlayPanel &o);
+
+#endif //OVERLAY_H
@@ -0,0 +1,58 @@
+#include "panel_layout.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "renderer.h"
+
+void panel_layout_arrange(const PanelRect *rects, int count, float baseWidth,
+                          PanelPlacement *out)
+{
+    if (count <= 0 || rects[0].width <= 0)
+        return;
+
+    // meters per logical pixel, from the first output
+    const float scale = baseWidth / (float)rects[0].width;
+
+    int minX = rects[0].x, maxX = rects[0].x + rects[0].width;
+    int minY = rects[0].y, maxY = rects[0].y + rects[0].height;
+    for (int i = 1; i < count; ++i) {
+        if (rects[i].x < minX) minX = rects[i].x;
+        if (rects[i].y < minY) minY = rects[i].y;
+        if (rects[i].x + rects[i].width  > maxX) maxX = rects[i].x + rects[i].width;
+        if (rects[i].y + rects[i].height > maxY) maxY = rects[i].y + rects[i].height;
+    }
+    const float cx = 0.5f * (float)(minX + maxX);
+    const float cy = 0.5f * (float)(minY + maxY);
+
+    for (int i = 0; i < count; ++i) {
+        const PanelRect &r = rects[i];
+        PanelPlacement &p = out[i];
+        p.width  = (float)r.width * scale;
+        p.height = r.aspect > 0.0f ? p.width * r.aspect : (float)r.height * scale;
+        p.x =  ((float)r.x + 0.5f * (float)r.width  - cx) * scale;
+        p.y = -((float)r.y + 0.5f * (float)r.height - cy) * scale;
+    }
+}
+
+void panel_offset_row(const PanelPlacement &p, float baseWidth, bool curved, float out[16])
+{
+    std::memset(out, 0, 16 * sizeof(float));
+    out[0] = out[5] = out[10] = out[15] = 1.0f;
+    out[1*4 + 3] = p.y + p.nudgeY;
+
+    const float x = p.x + p.nudgeX;
+    if (!curved || baseWidth <= 0.0f) {
+        out[0*4 + 3] = x;
+        return;
+    }
+
+    // along the cylinder: a panel one base width to the right sits one arc
+    // further round, so equal monitors meet edge to edge
+    const float theta = x / baseWidth * PANEL_CURVE_ARC_DEGREES * (float)M_PI / 180.0f;
+    const float c = cosf(theta), s = sinf(theta);
+    out[0*4 + 0] =  c;
+    out[0*4 + 2] = -s;
+    out[2*4 + 0] =  s;
+    out[2*4 + 2] =  c;
+}
@@ -0,0 +1,42 @@
+#ifndef PANEL_LAYOUT_H
+#define PANEL_LAYOUT_H
+
+// One VR panel per captured output, arranged like the monitors.
+//
+// Outputs are placed by their xdg-output logical positions, scaled so the
+// first output is baseWidth meters wide, and centred on the bounding box of
+// the whole arrangement. Flat panels are translated within the plane; on the
+// curved surface the horizontal offset becomes a rotation around the
+// cylinder axis, so side-by-side monitors wrap around the viewer.
+
+#define PANEL_NUDGE_METERS 0.05f
+
+// Output rectangle in the compositor's logical space (y down).
+struct PanelRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    float aspect = 0.0f;        // captured height / width, 0 = from the rect
+};
+
+// A panel relative to the layout centre, in meters (y up).
+struct PanelPlacement {
+    float width = 0.0f;
+    float height = 0.0f;
+    float x = 0.0f;             // layout position of the centre
+    float y = 0.0f;
+    float nudgeX = 0.0f;        // user adjustments on top of it
+    float nudgeY = 0.0f;
+};
+
+// Place count panels from their output rectangles; every rectangle needs a
+// size, and the first sets the scale.
+void panel_layout_arrange(const PanelRect *rects, int count, float baseWidth,
+                          PanelPlacement *out);
+
+// plane<-panel (row-major) for a panel of a layout whose first panel is
+// baseWidth meters wide.
+void panel_offset_row(const PanelPlacement &p, float baseWidth, bool curved, float out[16]);
+
+#endif //PANEL_LAYOUT_H
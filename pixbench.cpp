@@ -0,0 +1,337 @@
+// pixbench.cpp
+// Checks and times the CPU pixel kernels (see pixel_kernels.h).
+// - Every kernel set this CPU can run is first compared against the scalar
+//   reference on random pixels, with odd widths, unaligned pointers and
+//   padded strides; any difference fails the run.
+// - Then each kernel is timed on a full frame and reported in GB/s of
+//   source data read.
+// - Prints one key=value summary line per kernel set on stdout for CI.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <vector>
+
+#include "pixel_kernels.h"
+
+#define PIXBENCH_DEFAULT_SECONDS 0.5f
+
+struct PixBenchOptions {
+    int width = 3840;
+    int height = 2160;
+    float seconds = PIXBENCH_DEFAULT_SECONDS;   // per kernel and set
+    bool checkOnly = false;
+};
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// xorshift, so runs are reproducible
+static uint32_t g_rng = 0x9e3779b9u;
+
+static uint32_t next_random()
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static void fill_random(uint8_t *p, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+        p[i] = (uint8_t)next_random();
+}
+
+// ----------------------------------------------------------------------
+// Correctness against the scalar reference
+// ----------------------------------------------------------------------
+
+#define CHECK_MAX_WIDTH 300
+#define CHECK_MAX_ROWS 9
+#define CHECK_PAD 40        // stride padding and guard bytes
+
+static bool check_copy_rows(const PixelKernels &k, int width, int rows, int offset)
+{
+    const PixelKernels &ref = pixel_kernels_scalar();
+    const size_t rowBytes = (size_t)width * 4 + (size_t)(offset & 3);
+    const size_t srcStride = rowBytes + CHECK_PAD;
+    const size_t dstStride = rowBytes + (size_t)offset;
+    std::vector<uint8_t> src(srcStride * rows + CHECK_PAD * 2);
+    std::vector<uint8_t> a(dstStride * rows + CHECK_PAD * 2), b(a.size());
+    fill_random(src.data(), src.size());
+    fill_random(a.data(), a.size());
+    b = a;
+
+    ref.copy_rows(a.data() + offset, dstStride, src.data() + offset, srcStride, rowBytes, rows);
+    k.copy_rows(b.data() + offset, dstStride, src.data() + offset, srcStride, rowBytes, rows);
+    return a == b;
+}
+
+static bool check_pixels(const PixelKernels &k, int pixels, int offset)
+{
+    const PixelKernels &ref = pixel_kernels_scalar();
+    // offset in bytes, so the words themselves are misaligned
+    std::vector<uint8_t> src((size_t)pixels * 4 + CHECK_PAD);
+    std::vector<uint8_t> a(src.size()), b(src.size());
+    fill_random(src.data(), src.size());
+    fill_random(a.data(), a.size());
+
+    uint32_t *s = reinterpret_cast<uint32_t *>(src.data() + offset);
+    b = a;
+    ref.swap_rb(reinterpret_cast<uint32_t *>(a.data() + offset), s, pixels);
+    k.swap_rb(reinterpret_cast<uint32_t *>(b.data() + offset), s, pixels);
+    if (a != b)
+        return false;
+
+    b = a;
+    ref.down_2101010(reinterpret_cast<uint32_t *>(a.data() + offset), s, pixels);
+    k.down_2101010(reinterpret_cast<uint32_t *>(b.data() + offset), s, pixels);
+    return a == b;
+}
+
+static bool check_tile_changed(const PixelKernels &k, int width, int rows, int offset)
+{
+    const size_t rowBytes = (size_t)width * 4;
+    const size_t stride = rowBytes + CHECK_PAD;
+    std::vector<uint8_t> a(stride * rows + CHECK_PAD), b;
+    fill_random(a.data(), a.size());
+    b = a;
+    const uint8_t *pa = a.data() + offset;
+    const uint8_t *pb = b.data() + offset;
+
+    if (k.tile_changed(pa, stride, pb, stride, rowBytes, rows))
+        return false;
+
+    // changes outside the tile (stride padding) must not count
+    for (int y = 0; y < rows; ++y)
+        b[offset + y * stride + rowBytes] ^= 0xff;
+    if (k.tile_changed(pa, stride, pb, stride, rowBytes, rows))
+        return false;
+
+    // a single flipped bit anywhere inside it must
+    for (int t = 0; t < 16; ++t) {
+        const size_t pos = (size_t)(next_random() % rows) * stride + next_random() % rowBytes;
+        b[offset + pos] ^= (uint8_t)(1u << (next_random() & 7));
+        if (!k.tile_changed(pa, stride, pb, stride, rowBytes, rows))
+            return false;
+        b[offset + pos] = a[offset + pos];
+    }
+    return true;
+}
+
+static bool check_tile_hash(const PixelKernels &k, int width, int rows, int offset)
+{
+    const PixelKernels &ref = pixel_kernels_scalar();
+    const size_t rowBytes = (size_t)width * 4;
+    const size_t stride = rowBytes + CHECK_PAD;
+    std::vector<uint8_t> a(stride * rows + CHECK_PAD);
+    fill_random(a.data(), a.size());
+    const uint8_t *p = a.data() + offset;
+
+    const uint64_t h = ref.tile_hash(p, stride, rowBytes, rows);
+    if (k.tile_hash(p, stride, rowBytes, rows) != h)
+        return false;
+
+    // padding is not part of the tile, any bit inside it is
+    a[offset + rowBytes] ^= 0xff;
+    if (k.tile_hash(p, stride, rowBytes, rows) != h)
+        return false;
+    const size_t pos = (size_t)(next_random() % rows) * stride + next_random() % rowBytes;
+    a[offset + pos] ^= (uint8_t)(1u << (next_random() & 7));
+    return k.tile_hash(p, stride, rowBytes, rows) != h;
+}
+
+static bool check_kernels(const PixelKernels &k)
+{
+    for (int width = 1; width <= CHECK_MAX_WIDTH; width += (width < 40 ? 1 : 37)) {
+        for (int rows = 1; rows <= CHECK_MAX_ROWS; rows += 4) {
+            for (int offset = 0; offset < 8; offset += 3) {
+                if (!check_copy_rows(k, width, rows, offset)) {
+                    fprintf(stderr, "%s copy_rows differs: width %d rows %d offset %d\n",
+                            k.name, width, rows, offset);
+                    return false;
+                }
+                if (!check_tile_changed(k, width, rows, offset)) {
+                    fprintf(stderr, "%s tile_changed wrong: width %d rows %d offset %d\n",
+                            k.name, width, rows, offset);
+                    return false;
+                }
+                if (!check_tile_hash(k, width, rows, offset)) {
+                    fprintf(stderr, "%s tile_hash wrong: width %d rows %d offset %d\n",
+                            k.name, width, rows, offset);
+                    return false;
+                }
+            }
+        }
+        for (int offset = 0; offset < 4; ++offset) {
+            if (!check_pixels(k, width, offset)) {
+                fprintf(stderr, "%s swap_rb / down_2101010 differ: %d pixels offset %d\n",
+                        k.name, width, offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------
+// Timing
+// ----------------------------------------------------------------------
+
+struct KernelRates {
+    double copyGBps = 0.0;
+    double swapGBps = 0.0;
+    double downGBps = 0.0;
+    double diffGBps = 0.0;
+    double hashGBps = 0.0;
+};
+
+// Runs fn until `seconds` have passed; GB/s for `bytes` per call.
+template <typename Fn>
+static double time_kernel(float seconds, size_t bytes, Fn fn)
+{
+    fn();   // warm the caches and page in the destination
+    const int64_t startNs = now_ns();
+    const int64_t endNs = startNs + (int64_t)(seconds * 1e9);
+    uint64_t calls = 0;
+    int64_t t;
+    do {
+        fn();
+        ++calls;
+        t = now_ns();
+    } while (t < endNs);
+    return (double)bytes * calls / (double)(t - startNs);
+}
+
+static KernelRates time_kernels(const PixelKernels &k, const PixBenchOptions &o,
+                                const uint8_t *frame, uint8_t *out)
+{
+    // the frame as a compositor lays it out: rows padded to 256 bytes,
+    // packed to a narrower tile like the PBO path does
+    const size_t rowBytes = (size_t)o.width * 4;
+    const size_t stride = (rowBytes + 255) & ~(size_t)255;
+    const size_t tileRow = rowBytes / 2;
+    const size_t pixels = (size_t)o.width * o.height;
+    const uint32_t *src = reinterpret_cast<const uint32_t *>(frame);
+    uint32_t *dst = reinterpret_cast<uint32_t *>(out);
+
+    KernelRates r;
+    r.copyGBps = time_kernel(o.seconds, tileRow * o.height, [&] {
+        k.copy_rows(out, tileRow, frame + rowBytes / 4, stride, tileRow, o.height);
+    });
+    r.swapGBps = time_kernel(o.seconds, pixels * 4, [&] { k.swap_rb(dst, src, pixels); });
+    r.downGBps = time_kernel(o.seconds, pixels * 4, [&] { k.down_2101010(dst, src, pixels); });
+
+    // unchanged tiles are the expensive case: every byte gets compared
+    std::memcpy(out, frame, stride * o.height);
+    volatile bool changed = false;
+    r.diffGBps = time_kernel(o.seconds, rowBytes * o.height, [&] {
+        changed = k.tile_changed(frame, stride, out, stride, rowBytes, o.height);
+    });
+    if (changed)
+        fprintf(stderr, "%s: identical frames reported as changed\n", k.name);
+
+    // hashed in the 64 px tiles the capture-side tile diff uses
+    const int tile = 64;
+    volatile uint64_t sum = 0;
+    r.hashGBps = time_kernel(o.seconds, rowBytes * o.height, [&] {
+        uint64_t acc = 0;
+        for (int y = 0; y < o.height; y += tile)
+            for (int x = 0; x < o.width; x += tile)
+                acc += k.tile_hash(frame + (size_t)y * stride + (size_t)x * 4, stride,
+                                   (size_t)(x + tile <= o.width ? tile : o.width - x) * 4,
+                                   y + tile <= o.height ? tile : o.height - y);
+        sum = acc;
+    });
+    (void)sum;
+    return r;
+}
+
+// ----------------------------------------------------------------------
+// documentation
+// ----------------------------------------------------------------------
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [OPTIONS]\n"
+        "\n"
+        "Check the CPU pixel kernels against the scalar reference, then time them.\n"
+        "\n"
+        "Options:\n"
+        "  --size <W>x<H>      Frame size for timing (default 3840x2160).\n"
+        "  --seconds <s>       Time spent on each kernel, per set (default %.1f).\n"
+        "  --check             Only run the correctness checks.\n",
+        prog, PIXBENCH_DEFAULT_SECONDS);
+}
+
+static bool parse_options(int argc, char **argv, PixBenchOptions &o)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--size") == 0 && more) {
+            if (std::sscanf(argv[++i], "%dx%d", &o.width, &o.height) != 2 ||
+                o.width <= 0 || o.height <= 0)
+                return false;
+        } else if (strcmp(argv[i], "--seconds") == 0 && more) {
+            o.seconds = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            o.checkOnly = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// main
+// ---------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    PixBenchOptions opt;
+    if (!parse_options(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    const PixelKernels *sets[PIXEL_KERNELS_MAX_SETS];
+    const int numSets = pixel_kernels_available(sets, PIXEL_KERNELS_MAX_SETS);
+    fprintf(stderr, "pixbench: %d kernel sets, dispatch picks %s\n",
+            numSets, pixel_kernels().name);
+
+    bool ok = true;
+    for (int i = 0; i < numSets; ++i) {
+        const bool good = check_kernels(*sets[i]);
+        fprintf(stderr, "Check %s: %s\n", sets[i]->name, good ? "ok" : "FAILED");
+        ok = ok && good;
+    }
+    if (!ok)
+        return 1;
+    if (opt.checkOnly)
+        return 0;
+
+    const size_t stride = ((size_t)opt.width * 4 + 255) & ~(size_t)255;
+    std::vector<uint8_t> frame(stride * opt.height), out(frame.size());
+    fill_random(frame.data(), frame.size());
+
+    for (int i = 0; i < numSets; ++i) {
+        const KernelRates r = time_kernels(*sets[i], opt, frame.data(), out.data());
+        fprintf(stderr, "%-7s copy_rows %6.2f GB/s  swap_rb %6.2f GB/s  "
+                "down_2101010 %6.2f GB/s  tile_changed %6.2f GB/s  tile_hash %6.2f GB/s\n",
+                sets[i]->name, r.copyGBps, r.swapGBps, r.downGBps, r.diffGBps, r.hashGBps);
+        printf("pixbench kernels=%s size=%dx%d copy_gbps=%.2f swap_gbps=%.2f "
+               "down_gbps=%.2f diff_gbps=%.2f hash_gbps=%.2f\n",
+               sets[i]->name, opt.width, opt.height,
+               r.copyGBps, r.swapGBps, r.downGBps, r.diffGBps, r.hashGBps);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "pixel_format.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define SWIZZLE_RGBA { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA }
+#define SWIZZLE_RGB1 { GL_RED, GL_GREEN, GL_BLUE, GL_ONE }     // X channel: opaque
+
+// Packed formats are little-endian words, so "ARGB8888" is B, G, R, A in
+// memory: GL_BGRA with a _REV type names the same bits.
+static const PixelFormat k_formats[] = {
+    // 8 bits per channel
+    { SHM_FORMAT_ARGB8888,          "ARGB8888", 4, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, SWIZZLE_RGBA },
+    { SHM_FORMAT_XRGB8888,          "XRGB8888", 4, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','B','2','4'),  "ABGR8888", 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','B','2','4'),  "XBGR8888", 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, SWIZZLE_RGB1 },
+    { SHM_FOURCC('R','A','2','4'),  "RGBA8888", 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,     SWIZZLE_RGBA },
+    { SHM_FOURCC('R','X','2','4'),  "RGBX8888", 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,     SWIZZLE_RGB1 },
+    { SHM_FOURCC('B','A','2','4'),  "BGRA8888", 4, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8,     SWIZZLE_RGBA },
+    { SHM_FOURCC('B','X','2','4'),  "BGRX8888", 4, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8,     SWIZZLE_RGB1 },
+    { SHM_FOURCC('R','G','2','4'),  "RGB888",   3, GL_RGB8,  GL_BGR,  GL_UNSIGNED_BYTE,            SWIZZLE_RGBA },
+    { SHM_FOURCC('B','G','2','4'),  "BGR888",   3, GL_RGB8,  GL_RGB,  GL_UNSIGNED_BYTE,            SWIZZLE_RGBA },
+
+    // 10 bits per channel: kept at 10 bits, not truncated
+    { SHM_FOURCC('A','R','3','0'),  "ARGB2101010", 4, GL_RGB10_A2, GL_BGRA, GL_UNSIGNED_INT_2_10_10_10_REV, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','R','3','0'),  "XRGB2101010", 4, GL_RGB10_A2, GL_BGRA, GL_UNSIGNED_INT_2_10_10_10_REV, SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','B','3','0'),  "ABGR2101010", 4, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','B','3','0'),  "XBGR2101010", 4, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, SWIZZLE_RGB1 },
+    { SHM_FOURCC('R','A','3','0'),  "RGBA1010102", 4, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_10_10_10_2,     SWIZZLE_RGBA },
+    { SHM_FOURCC('R','X','3','0'),  "RGBX1010102", 4, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_10_10_10_2,     SWIZZLE_RGB1 },
+    { SHM_FOURCC('B','A','3','0'),  "BGRA1010102", 4, GL_RGB10_A2, GL_BGRA, GL_UNSIGNED_INT_10_10_10_2,     SWIZZLE_RGBA },
+    { SHM_FOURCC('B','X','3','0'),  "BGRX1010102", 4, GL_RGB10_A2, GL_BGRA, GL_UNSIGNED_INT_10_10_10_2,     SWIZZLE_RGB1 },
+
+    // 16 bits per pixel
+    { SHM_FOURCC('R','G','1','6'),  "RGB565",   2, GL_RGB8,    GL_RGB,  GL_UNSIGNED_SHORT_5_6_5,       SWIZZLE_RGBA },
+    { SHM_FOURCC('B','G','1','6'),  "BGR565",   2, GL_RGB8,    GL_RGB,  GL_UNSIGNED_SHORT_5_6_5_REV,   SWIZZLE_RGBA },
+    { SHM_FOURCC('A','R','1','5'),  "ARGB1555", 2, GL_RGB5_A1, GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','R','1','5'),  "XRGB1555", 2, GL_RGB5_A1, GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV, SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','R','1','2'),  "ARGB4444", 2, GL_RGBA4,   GL_BGRA, GL_UNSIGNED_SHORT_4_4_4_4_REV, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','R','1','2'),  "XRGB4444", 2, GL_RGBA4,   GL_BGRA, GL_UNSIGNED_SHORT_4_4_4_4_REV, SWIZZLE_RGB1 },
+
+    // 16 bits per channel (HDR desktops)
+    { SHM_FOURCC('A','B','4','H'),  "ABGR16161616F", 8, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT,     SWIZZLE_RGBA },
+    { SHM_FOURCC('X','B','4','H'),  "XBGR16161616F", 8, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT,     SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','R','4','H'),  "ARGB16161616F", 8, GL_RGBA16F, GL_BGRA, GL_HALF_FLOAT,     SWIZZLE_RGBA },
+    { SHM_FOURCC('X','R','4','H'),  "XRGB16161616F", 8, GL_RGBA16F, GL_BGRA, GL_HALF_FLOAT,     SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','B','4','8'),  "ABGR16161616",  8, GL_RGBA16,  GL_RGBA, GL_UNSIGNED_SHORT, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','B','4','8'),  "XBGR16161616",  8, GL_RGBA16,  GL_RGBA, GL_UNSIGNED_SHORT, SWIZZLE_RGB1 },
+    { SHM_FOURCC('A','R','4','8'),  "ARGB16161616",  8, GL_RGBA16,  GL_BGRA, GL_UNSIGNED_SHORT, SWIZZLE_RGBA },
+    { SHM_FOURCC('X','R','4','8'),  "XRGB16161616",  8, GL_RGBA16,  GL_BGRA, GL_UNSIGNED_SHORT, SWIZZLE_RGB1 },
+};
+
+#define NUM_FORMATS (int)(sizeof(k_formats) / sizeof(k_formats[0]))
+
+const PixelFormat *pixel_format_lookup(uint32_t shmFormat)
+{
+    for (int i = 0; i < NUM_FORMATS; ++i)
+        if (k_formats[i].shmFormat == shmFormat)
+            return &k_formats[i];
+    return nullptr;
+}
+
+const PixelFormat *pixel_format_from_name(const char *name)
+{
+    for (int i = 0; i < NUM_FORMATS; ++i)
+        if (std::strcmp(k_formats[i].name, name) == 0)
+            return &k_formats[i];
+    return nullptr;
+}
+
+const char *pixel_format_name(uint32_t shmFormat, char *buf)
+{
+    if (const PixelFormat *f = pixel_format_lookup(shmFormat))
+        return f->name;
+    std::snprintf(buf, 32, "'%c%c%c%c' (0x%08x)",
+                  (char)(shmFormat & 0x7f), (char)((shmFormat >> 8) & 0x7f),
+                  (char)((shmFormat >> 16) & 0x7f), (char)((shmFormat >> 24) & 0x7f),
+                  shmFormat);
+    return buf;
+}
+
+bool pixel_format_unpack(const PixelFormat &f, int stride, int *rowLength, int *alignment)
+{
+    const int bpp = f.bytesPerPixel;
+    if (stride % bpp == 0) {
+        *rowLength = stride / bpp;
+        *alignment = stride % 8 == 0 ? 8 : stride % 4 == 0 ? 4 : stride % 2 == 0 ? 2 : 1;
+        return true;
+    }
+
+    // byte-component formats pad each row to the alignment
+    if (f.type != GL_UNSIGNED_BYTE)
+        return false;
+    const int pixels = stride / bpp;
+    for (int a = 2; a <= 8; a *= 2) {
+        if ((pixels * bpp + a - 1) / a * a == stride) {
+            *rowLength = pixels;
+            *alignment = a;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+// wl_shm pixel formats and how GL takes them as they are.
+//
+// Every entry maps a wl_shm_format to an upload format/type pair that reads
+// the bytes exactly as the compositor laid them out (little-endian packed
+// words), plus a texture swizzle for what the upload cannot express, such
+// as an X channel that must sample as opaque. No frame is ever reordered on
+// the CPU: the capture side only picks buffer formats found here.
+//
+// wl_shm formats are the DRM fourcc codes except ARGB8888 (0) and
+// XRGB8888 (1); they are spelled out so that nothing here needs the
+// Wayland headers.
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdint>
+
+#define SHM_FOURCC(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define SHM_FORMAT_ARGB8888 0u
+#define SHM_FORMAT_XRGB8888 1u
+
+struct PixelFormat {
+    uint32_t shmFormat;
+    const char *name;
+    int bytesPerPixel;
+    GLenum internalFormat;
+    GLenum format;                  // glTexSubImage2D format / type
+    GLenum type;
+    GLint swizzle[4];               // GL_TEXTURE_SWIZZLE_RGBA
+};
+
+// nullptr for formats GL cannot take without a CPU conversion.
+const PixelFormat *pixel_format_lookup(uint32_t shmFormat);
+
+// By name ("XRGB8888", ...), for command lines; nullptr if unknown.
+const PixelFormat *pixel_format_from_name(const char *name);
+
+// Name of any wl_shm format, known or not (fourcc text for unknown ones).
+// buf must hold at least 32 bytes.
+const char *pixel_format_name(uint32_t shmFormat, char *buf);
+
+// Unpack row length (in pixels) and alignment that step exactly `stride`
+// bytes per row. False if no GL unpack state does, e.g. a 3-byte format
+// with a stride padded to an odd multiple.
+bool pixel_format_unpack(const PixelFormat &f, int stride, int *rowLength, int *alignment);
+
+#endif //PIXEL_FORMAT_H
@@ -0,0 +1,535 @@
+#include "pixel_kernels.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define PIXEL_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar reference
+// ---------------------------------------------------------------------------
+
+// Also used by the vector sets: glibc's memcpy is already vectorised and
+// picks its own variant per CPU, and a hand-written loop did not beat it on
+// narrow or wide rows.
+static void copy_rows_scalar(uint8_t *dst, size_t dstStride,
+                             const uint8_t *src, size_t srcStride,
+                             size_t rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        std::memcpy(dst, src, rowBytes);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+static inline uint32_t swap_rb_px(uint32_t x)
+{
+    return (x & 0xff00ff00u) | ((x >> 16) & 0xffu) | ((x << 16) & 0xff0000u);
+}
+
+static inline uint32_t down_2101010_px(uint32_t x)
+{
+    // alpha 0..3 * 0x55, built from copies of the top two bits
+    const uint32_t a = x & 0xc0000000u;
+    return (a | (a >> 2) | (a >> 4) | (a >> 6)) |
+           ((x >> 6) & 0x00ff0000u) |
+           ((x >> 4) & 0x0000ff00u) |
+           ((x >> 2) & 0x000000ffu);
+}
+
+static void swap_rb_scalar(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+        dst[i] = swap_rb_px(src[i]);
+}
+
+static void down_2101010_scalar(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+        dst[i] = down_2101010_px(src[i]);
+}
+
+static bool tile_changed_scalar(const uint8_t *a, size_t aStride,
+                                const uint8_t *b, size_t bStride,
+                                size_t rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        if (std::memcmp(a, b, rowBytes) != 0)
+            return true;
+        a += aStride;
+        b += bStride;
+    }
+    return false;
+}
+
+// tile_hash: 16 lanes of 32-bit words, each row read in 64-byte blocks (the
+// last one zero-padded), every lane stepped with a multiply and xorshift;
+// the lanes are folded into 64 bits at the end. Defined by lane rather than
+// by register so that every set computes the same value.
+#define TILE_HASH_LANES 16
+#define TILE_HASH_BLOCK (TILE_HASH_LANES * 4)
+#define TILE_HASH_MUL   0x9e3779b1u
+
+static inline uint32_t tile_hash_step(uint32_t h, uint32_t w)
+{
+    h = (h ^ w) * TILE_HASH_MUL;
+    return h ^ (h >> 16);
+}
+
+static void tile_hash_seed(uint32_t *h)
+{
+    for (int i = 0; i < TILE_HASH_LANES; ++i)
+        h[i] = 0x811c9dc5u + (uint32_t)i * 0x9e3779b9u;
+}
+
+static uint64_t tile_hash_fold(const uint32_t *h, size_t rowBytes, int rows)
+{
+    uint64_t r = 0xcbf29ce484222325ull ^ rowBytes ^ ((uint64_t)rows << 32);
+    for (int i = 0; i < TILE_HASH_LANES; ++i) {
+        r = (r ^ h[i]) * 0x100000001b3ull;
+        r ^= r >> 29;
+    }
+    return r;
+}
+
+static void tile_hash_block_scalar(uint32_t *h, const uint8_t *p)
+{
+    for (int i = 0; i < TILE_HASH_LANES; ++i) {
+        uint32_t w;
+        std::memcpy(&w, p + i * 4, 4);
+        h[i] = tile_hash_step(h[i], w);
+    }
+}
+
+static uint64_t tile_hash_scalar(const uint8_t *p, size_t stride, size_t rowBytes, int rows)
+{
+    uint32_t h[TILE_HASH_LANES];
+    tile_hash_seed(h);
+    for (int y = 0; y < rows; ++y) {
+        size_t i = 0;
+        for (; i + TILE_HASH_BLOCK <= rowBytes; i += TILE_HASH_BLOCK)
+            tile_hash_block_scalar(h, p + i);
+        if (i < rowBytes) {
+            uint8_t tail[TILE_HASH_BLOCK] = {};
+            std::memcpy(tail, p + i, rowBytes - i);
+            tile_hash_block_scalar(h, tail);
+        }
+        p += stride;
+    }
+    return tile_hash_fold(h, rowBytes, rows);
+}
+
+static const PixelKernels k_scalar = {
+    "scalar", copy_rows_scalar, swap_rb_scalar, down_2101010_scalar, tile_changed_scalar,
+    tile_hash_scalar,
+};
+
+// ---------------------------------------------------------------------------
+// SSE2 (baseline on x86-64)
+// ---------------------------------------------------------------------------
+
+#if PIXEL_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void swap_rb_sse2(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    const __m128i keep = _mm_set1_epi32((int)0xff00ff00u);
+    const __m128i low  = _mm_set1_epi32(0xff);
+    const __m128i mid  = _mm_set1_epi32(0xff0000);
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i r = _mm_or_si128(_mm_and_si128(x, keep),
+                    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 16), low),
+                                 _mm_and_si128(_mm_slli_epi32(x, 16), mid)));
+        _mm_storeu_si128((__m128i *)(dst + i), r);
+    }
+    for (; i < pixels; ++i)
+        dst[i] = swap_rb_px(src[i]);
+}
+
+__attribute__((target("sse2")))
+static void down_2101010_sse2(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    const __m128i amask = _mm_set1_epi32((int)0xc0000000u);
+    const __m128i rmask = _mm_set1_epi32(0x00ff0000);
+    const __m128i gmask = _mm_set1_epi32(0x0000ff00);
+    const __m128i bmask = _mm_set1_epi32(0x000000ff);
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i a = _mm_and_si128(x, amask);
+        a = _mm_or_si128(_mm_or_si128(a, _mm_srli_epi32(a, 2)),
+                         _mm_or_si128(_mm_srli_epi32(a, 4), _mm_srli_epi32(a, 6)));
+        __m128i rgb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 6), rmask),
+                      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 4), gmask),
+                                   _mm_and_si128(_mm_srli_epi32(x, 2), bmask)));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(a, rgb));
+    }
+    for (; i < pixels; ++i)
+        dst[i] = down_2101010_px(src[i]);
+}
+
+__attribute__((target("sse2")))
+static bool tile_changed_sse2(const uint8_t *a, size_t aStride,
+                              const uint8_t *b, size_t bStride,
+                              size_t rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        __m128i diff = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 64 <= rowBytes; i += 64) {
+            __m128i d0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                       _mm_loadu_si128((const __m128i *)(b + i)));
+            __m128i d1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 16)),
+                                       _mm_loadu_si128((const __m128i *)(b + i + 16)));
+            __m128i d2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 32)),
+                                       _mm_loadu_si128((const __m128i *)(b + i + 32)));
+            __m128i d3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 48)),
+                                       _mm_loadu_si128((const __m128i *)(b + i + 48)));
+            diff = _mm_or_si128(diff, _mm_or_si128(_mm_or_si128(d0, d1), _mm_or_si128(d2, d3)));
+        }
+        for (; i + 16 <= rowBytes; i += 16)
+            diff = _mm_or_si128(diff, _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                    _mm_loadu_si128((const __m128i *)(b + i))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xffff ||
+            std::memcmp(a + i, b + i, rowBytes - i) != 0)
+            return true;
+        a += aStride;
+        b += bStride;
+    }
+    return false;
+}
+
+// SSE2 has no 32-bit low multiply: two 32x32->64 multiplies on the even
+// and odd lanes, low halves put back together
+__attribute__((target("sse2")))
+static inline __m128i mullo32_sse2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i tile_hash_step_sse2(__m128i h, const uint8_t *p, __m128i mul)
+{
+    h = mullo32_sse2(_mm_xor_si128(h, _mm_loadu_si128((const __m128i *)p)), mul);
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+}
+
+__attribute__((target("sse2")))
+static inline void tile_hash_block_sse2(__m128i *h, const uint8_t *p, __m128i mul)
+{
+    for (int k = 0; k < 4; ++k)
+        h[k] = tile_hash_step_sse2(h[k], p + k * 16, mul);
+}
+
+__attribute__((target("sse2")))
+static uint64_t tile_hash_sse2(const uint8_t *p, size_t stride, size_t rowBytes, int rows)
+{
+    uint32_t h[TILE_HASH_LANES];
+    tile_hash_seed(h);
+    const __m128i mul = _mm_set1_epi32((int)TILE_HASH_MUL);
+    __m128i hv[4];
+    for (int k = 0; k < 4; ++k)
+        hv[k] = _mm_loadu_si128((const __m128i *)(h + k * 4));
+    for (int y = 0; y < rows; ++y) {
+        size_t i = 0;
+        for (; i + TILE_HASH_BLOCK <= rowBytes; i += TILE_HASH_BLOCK)
+            tile_hash_block_sse2(hv, p + i, mul);
+        if (i < rowBytes) {
+            uint8_t tail[TILE_HASH_BLOCK] = {};
+            std::memcpy(tail, p + i, rowBytes - i);
+            tile_hash_block_sse2(hv, tail, mul);
+        }
+        p += stride;
+    }
+    for (int k = 0; k < 4; ++k)
+        _mm_storeu_si128((__m128i *)(h + k * 4), hv[k]);
+    return tile_hash_fold(h, rowBytes, rows);
+}
+
+static const PixelKernels k_sse2 = {
+    "sse2", copy_rows_scalar, swap_rb_sse2, down_2101010_sse2, tile_changed_sse2,
+    tile_hash_sse2,
+};
+
+// ---------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void swap_rb_avx2(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                           2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(x, order));
+    }
+    for (; i < pixels; ++i)
+        dst[i] = swap_rb_px(src[i]);
+}
+
+__attribute__((target("avx2")))
+static void down_2101010_avx2(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    const __m256i amask = _mm256_set1_epi32((int)0xc0000000u);
+    const __m256i rmask = _mm256_set1_epi32(0x00ff0000);
+    const __m256i gmask = _mm256_set1_epi32(0x0000ff00);
+    const __m256i bmask = _mm256_set1_epi32(0x000000ff);
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i a = _mm256_and_si256(x, amask);
+        a = _mm256_or_si256(_mm256_or_si256(a, _mm256_srli_epi32(a, 2)),
+                            _mm256_or_si256(_mm256_srli_epi32(a, 4), _mm256_srli_epi32(a, 6)));
+        __m256i rgb = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 6), rmask),
+                      _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 4), gmask),
+                                      _mm256_and_si256(_mm256_srli_epi32(x, 2), bmask)));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(a, rgb));
+    }
+    for (; i < pixels; ++i)
+        dst[i] = down_2101010_px(src[i]);
+}
+
+__attribute__((target("avx2")))
+static bool tile_changed_avx2(const uint8_t *a, size_t aStride,
+                              const uint8_t *b, size_t bStride,
+                              size_t rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        __m256i diff = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 128 <= rowBytes; i += 128) {
+            __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                          _mm256_loadu_si256((const __m256i *)(b + i)));
+            __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i + 32)),
+                                          _mm256_loadu_si256((const __m256i *)(b + i + 32)));
+            __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i + 64)),
+                                          _mm256_loadu_si256((const __m256i *)(b + i + 64)));
+            __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i + 96)),
+                                          _mm256_loadu_si256((const __m256i *)(b + i + 96)));
+            diff = _mm256_or_si256(diff, _mm256_or_si256(_mm256_or_si256(d0, d1),
+                                                         _mm256_or_si256(d2, d3)));
+        }
+        for (; i + 32 <= rowBytes; i += 32)
+            diff = _mm256_or_si256(diff,
+                                   _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                                    _mm256_loadu_si256((const __m256i *)(b + i))));
+        if (!_mm256_testz_si256(diff, diff) ||
+            std::memcmp(a + i, b + i, rowBytes - i) != 0)
+            return true;
+        a += aStride;
+        b += bStride;
+    }
+    return false;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i tile_hash_step_avx2(__m256i h, const uint8_t *p, __m256i mul)
+{
+    h = _mm256_mullo_epi32(_mm256_xor_si256(h, _mm256_loadu_si256((const __m256i *)p)), mul);
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+__attribute__((target("avx2")))
+static inline void tile_hash_block_avx2(__m256i *h, const uint8_t *p, __m256i mul)
+{
+    for (int k = 0; k < 2; ++k)
+        h[k] = tile_hash_step_avx2(h[k], p + k * 32, mul);
+}
+
+__attribute__((target("avx2")))
+static uint64_t tile_hash_avx2(const uint8_t *p, size_t stride, size_t rowBytes, int rows)
+{
+    uint32_t h[TILE_HASH_LANES];
+    tile_hash_seed(h);
+    const __m256i mul = _mm256_set1_epi32((int)TILE_HASH_MUL);
+    __m256i hv[2];
+    for (int k = 0; k < 2; ++k)
+        hv[k] = _mm256_loadu_si256((const __m256i *)(h + k * 8));
+    for (int y = 0; y < rows; ++y) {
+        size_t i = 0;
+        for (; i + TILE_HASH_BLOCK <= rowBytes; i += TILE_HASH_BLOCK)
+            tile_hash_block_avx2(hv, p + i, mul);
+        if (i < rowBytes) {
+            uint8_t tail[TILE_HASH_BLOCK] = {};
+            std::memcpy(tail, p + i, rowBytes - i);
+            tile_hash_block_avx2(hv, tail, mul);
+        }
+        p += stride;
+    }
+    for (int k = 0; k < 2; ++k)
+        _mm256_storeu_si256((__m256i *)(h + k * 8), hv[k]);
+    return tile_hash_fold(h, rowBytes, rows);
+}
+
+static const PixelKernels k_avx2 = {
+    "avx2", copy_rows_scalar, swap_rb_avx2, down_2101010_avx2, tile_changed_avx2,
+    tile_hash_avx2,
+};
+
+#endif // PIXEL_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// NEON (baseline on arm64)
+// ---------------------------------------------------------------------------
+
+#if PIXEL_KERNELS_NEON
+
+static void swap_rb_neon(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t px = vld4q_u8(reinterpret_cast<const uint8_t *>(src + i));
+        uint8x16_t t = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = t;
+        vst4q_u8(reinterpret_cast<uint8_t *>(dst + i), px);
+    }
+    for (; i < pixels; ++i)
+        dst[i] = swap_rb_px(src[i]);
+}
+
+static void down_2101010_neon(uint32_t *dst, const uint32_t *src, size_t pixels)
+{
+    const uint32x4_t amask = vdupq_n_u32(0xc0000000u);
+    const uint32x4_t rmask = vdupq_n_u32(0x00ff0000u);
+    const uint32x4_t gmask = vdupq_n_u32(0x0000ff00u);
+    const uint32x4_t bmask = vdupq_n_u32(0x000000ffu);
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        uint32x4_t x = vld1q_u32(src + i);
+        uint32x4_t a = vandq_u32(x, amask);
+        a = vorrq_u32(vorrq_u32(a, vshrq_n_u32(a, 2)),
+                      vorrq_u32(vshrq_n_u32(a, 4), vshrq_n_u32(a, 6)));
+        uint32x4_t rgb = vorrq_u32(vandq_u32(vshrq_n_u32(x, 6), rmask),
+                         vorrq_u32(vandq_u32(vshrq_n_u32(x, 4), gmask),
+                                   vandq_u32(vshrq_n_u32(x, 2), bmask)));
+        vst1q_u32(dst + i, vorrq_u32(a, rgb));
+    }
+    for (; i < pixels; ++i)
+        dst[i] = down_2101010_px(src[i]);
+}
+
+static bool tile_changed_neon(const uint8_t *a, size_t aStride,
+                              const uint8_t *b, size_t bStride,
+                              size_t rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        uint8x16_t diff = vdupq_n_u8(0);
+        size_t i = 0;
+        for (; i + 16 <= rowBytes; i += 16)
+            diff = vorrq_u8(diff, veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        if (vmaxvq_u8(diff) != 0 || std::memcmp(a + i, b + i, rowBytes - i) != 0)
+            return true;
+        a += aStride;
+        b += bStride;
+    }
+    return false;
+}
+
+static inline uint32x4_t tile_hash_step_neon(uint32x4_t h, const uint8_t *p, uint32x4_t mul)
+{
+    h = vmulq_u32(veorq_u32(h, vreinterpretq_u32_u8(vld1q_u8(p))), mul);
+    return veorq_u32(h, vshrq_n_u32(h, 16));
+}
+
+static inline void tile_hash_block_neon(uint32x4_t *h, const uint8_t *p, uint32x4_t mul)
+{
+    for (int k = 0; k < 4; ++k)
+        h[k] = tile_hash_step_neon(h[k], p + k * 16, mul);
+}
+
+static uint64_t tile_hash_neon(const uint8_t *p, size_t stride, size_t rowBytes, int rows)
+{
+    uint32_t h[TILE_HASH_LANES];
+    tile_hash_seed(h);
+    const uint32x4_t mul = vdupq_n_u32(TILE_HASH_MUL);
+    uint32x4_t hv[4];
+    for (int k = 0; k < 4; ++k)
+        hv[k] = vld1q_u32(h + k * 4);
+    for (int y = 0; y < rows; ++y) {
+        size_t i = 0;
+        for (; i + TILE_HASH_BLOCK <= rowBytes; i += TILE_HASH_BLOCK)
+            tile_hash_block_neon(hv, p + i, mul);
+        if (i < rowBytes) {
+            uint8_t tail[TILE_HASH_BLOCK] = {};
+            std::memcpy(tail, p + i, rowBytes - i);
+            tile_hash_block_neon(hv, tail, mul);
+        }
+        p += stride;
+    }
+    for (int k = 0; k < 4; ++k)
+        vst1q_u32(h + k * 4, hv[k]);
+    return tile_hash_fold(h, rowBytes, rows);
+}
+
+static const PixelKernels k_neon = {
+    "neon", copy_rows_scalar, swap_rb_neon, down_2101010_neon, tile_changed_neon,
+    tile_hash_neon,
+};
+
+#endif // PIXEL_KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+int pixel_kernels_available(const PixelKernels **out, int max)
+{
+    int n = 0;
+    if (n < max)
+        out[n++] = &k_scalar;
+#if PIXEL_KERNELS_X86
+    __builtin_cpu_init();
+    if (n < max && __builtin_cpu_supports("sse2"))
+        out[n++] = &k_sse2;
+    if (n < max && __builtin_cpu_supports("avx2"))
+        out[n++] = &k_avx2;
+#endif
+#if PIXEL_KERNELS_NEON
+    if (n < max)
+        out[n++] = &k_neon;
+#endif
+    return n;
+}
+
+static const PixelKernels *choose_kernels()
+{
+    const PixelKernels *sets[PIXEL_KERNELS_MAX_SETS];
+    const int n = pixel_kernels_available(sets, PIXEL_KERNELS_MAX_SETS);
+
+    const char *want = std::getenv("VRDESKTOP_KERNELS");
+    if (want && *want) {
+        for (int i = 0; i < n; ++i)
+            if (std::strcmp(sets[i]->name, want) == 0)
+                return sets[i];
+        std::fprintf(stderr, "Pixel kernels: \"%s\" not available, using %s\n",
+                     want, sets[n - 1]->name);
+    }
+    return sets[n - 1];
+}
+
+const PixelKernels &pixel_kernels()
+{
+    static const PixelKernels *chosen = choose_kernels();
+    return *chosen;
+}
+
+const PixelKernels &pixel_kernels_scalar()
+{
+    return k_scalar;
+}
@@ -0,0 +1,59 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+// Vectorised kernels for the CPU-side pixel work that is left: packing rows
+// out of a strided frame, red/blue swaps, 10-bit to 8-bit conversion,
+// checking whether a tile changed between two frames and hashing tiles so
+// that a frame can be compared with one that is no longer around.
+//
+// Each kernel has a scalar reference and SSE2 / AVX2 (x86) or NEON (arm64)
+// versions, except copy_rows, which is memcpy per row in every set.
+// pixel_kernels() picks the best set the CPU supports once, at first use;
+// VRDESKTOP_KERNELS=scalar|sse2|avx2|neon forces one (if the CPU has it).
+// Every set gives bit-identical results to the scalar one, which pixbench
+// checks before timing them.
+//
+// Pointers need no particular alignment. Pixels are 32-bit words in the
+// frame's byte order.
+
+#include <cstddef>
+#include <cstdint>
+
+#define PIXEL_KERNELS_MAX_SETS 4
+
+struct PixelKernels {
+    const char *name;
+
+    // rows x rowBytes from src (srcStride apart) to dst (dstStride apart)
+    void (*copy_rows)(uint8_t *dst, size_t dstStride,
+                      const uint8_t *src, size_t srcStride,
+                      size_t rowBytes, int rows);
+
+    // swap bytes 0 and 2 of every pixel: BGRA <-> RGBA, XRGB <-> XBGR
+    void (*swap_rb)(uint32_t *dst, const uint32_t *src, size_t pixels);
+
+    // 2:10:10:10 -> 8:8:8:8 keeping channel order (ARGB2101010 ->
+    // ARGB8888, ABGR2101010 -> ABGR8888): the top 8 bits of each 10-bit
+    // channel, alpha widened from 2 bits to 0x00/0x55/0xaa/0xff
+    void (*down_2101010)(uint32_t *dst, const uint32_t *src, size_t pixels);
+
+    // true if the rows x rowBytes tile differs between a and b
+    bool (*tile_changed)(const uint8_t *a, size_t aStride,
+                         const uint8_t *b, size_t bStride,
+                         size_t rowBytes, int rows);
+
+    // 64-bit hash of a rows x rowBytes tile, the same in every set. Not
+    // cryptographic, but any single changed 32-bit word changes it.
+    uint64_t (*tile_hash)(const uint8_t *p, size_t stride, size_t rowBytes, int rows);
+};
+
+// The set in use (dispatched on first call, then fixed).
+const PixelKernels &pixel_kernels();
+
+// The reference implementation.
+const PixelKernels &pixel_kernels_scalar();
+
+// Every set this CPU can run, scalar first. Returns how many were written.
+int pixel_kernels_available(const PixelKernels **out, int max);
+
+#endif //PIXEL_KERNELS_H
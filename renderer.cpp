@@ -0,0 +1,663 @@
+#include "renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "gl_util.h"
+
+// ---------------------------------------------------------------------------
+// Shaders
+// ---------------------------------------------------------------------------
+
+static const char *k_panelVertexShader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec3 aPos;\n"
+    "layout(location = 1) in vec2 aUv;\n"
+    "uniform mat4 uMvp;\n"
+    "uniform vec4 uUvRect;\n"
+    "out vec2 vUv;\n"
+    "void main() {\n"
+    "    vUv = aUv * uUvRect.xy + uUvRect.zw;\n"
+    "    gl_Position = uMvp * vec4(aPos, 1.0);\n"
+    "}\n";
+
+static const char *k_panelFragmentShader =
+    "#version 330 core\n"
+    "in vec2 vUv;\n"
+    "uniform sampler2D uTex;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = texture(uTex, vUv);\n"
+    "}\n";
+
+// uUvRect maps the mesh's frame UVs into the bound tile's stored area.
+
+// Per-eye MVP picked by view index (multiview) or instance (layered).
+static const char *k_stereoMultiviewVertexShader =
+    "#version 330 core\n"
+    "#extension GL_OVR_multiview2 : require\n"
+    "layout(num_views = 2) in;\n"
+    "layout(location = 0) in vec3 aPos;\n"
+    "layout(location = 1) in vec2 aUv;\n"
+    "uniform mat4 uMvp[2];\n"
+    "uniform vec4 uUvRect;\n"
+    "out vec2 vUv;\n"
+    "void main() {\n"
+    "    vUv = aUv * uUvRect.xy + uUvRect.zw;\n"
+    "    gl_Position = uMvp[gl_ViewID_OVR] * vec4(aPos, 1.0);\n"
+    "}\n";
+
+static const char *k_stereoInstancedVertexShader =
+    "#version 330 core\n"
+    "#extension %s : require\n"
+    "layout(location = 0) in vec3 aPos;\n"
+    "layout(location = 1) in vec2 aUv;\n"
+    "uniform mat4 uMvp[2];\n"
+    "uniform vec4 uUvRect;\n"
+    "out vec2 vUv;\n"
+    "void main() {\n"
+    "    vUv = aUv * uUvRect.xy + uUvRect.zw;\n"
+    "    gl_Position = uMvp[gl_InstanceID] * vec4(aPos, 1.0);\n"
+    "    gl_Layer = gl_InstanceID;\n"
+    "}\n";
+
+static GLuint compile_shader(GLenum type, const char *src)
+{
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, nullptr);
+    glCompileShader(sh);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(sh, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "Shader compile failed: %s\n", log);
+        glDeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+
+static GLuint link_program(const char *vs, const char *fs)
+{
+    GLuint v = compile_shader(GL_VERTEX_SHADER, vs);
+    GLuint f = compile_shader(GL_FRAGMENT_SHADER, fs);
+    if (!v || !f) {
+        if (v) glDeleteShader(v);
+        if (f) glDeleteShader(f);
+        return 0;
+    }
+
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, v);
+    glAttachShader(prog, f);
+    glLinkProgram(prog);
+    glDeleteShader(v);
+    glDeleteShader(f);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(prog, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "Shader link failed: %s\n", log);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// ---------------------------------------------------------------------------
+// Meshes (interleaved x, y, z, u, v)
+// ---------------------------------------------------------------------------
+
+static void push_vertex(std::vector<float> &v, float x, float y, float z, float s, float t)
+{
+    v.push_back(x);
+    v.push_back(y);
+    v.push_back(z);
+    v.push_back(s);
+    v.push_back(t);
+}
+
+// Point on the panel at frame UV (u, v); v = 0 is the top edge.
+static void panel_point(bool curved, float width, float height, float arcDegrees,
+                        float u, float v, float out[3])
+{
+    out[1] = (0.5f - v) * height;
+    if (curved) {
+        // planeWidth is the chord length; pick the radius so the chord
+        // spans the arc: chord = 2 * R * sin(theta/2)
+        const float halfArc = arcDegrees * (float)M_PI / 180.0f * 0.5f;
+        const float radius  = width / (2.0f * sinf(halfArc));
+        const float theta = -halfArc + u * 2.0f * halfArc;
+
+        // cylinder around Y, screen centred on -Z
+        out[0] =  radius * sinf(theta);
+        out[2] = -radius * cosf(theta);
+    } else {
+        out[0] = (u - 0.5f) * width;
+        out[2] = 0.0f;
+    }
+}
+
+// Frame UV bounds of tile i, or the whole frame untiled. Neighbouring tiles
+// compute their shared edge from the same integers, so it is bit-identical.
+static void tile_uv_bounds(const DesktopTexture *tiles, int i, float uv[4])
+{
+    if (!tiles) {
+        uv[0] = uv[1] = 0.0f;
+        uv[2] = uv[3] = 1.0f;
+        return;
+    }
+    const FrameRect &r = tiles->tiles[i].rect;
+    uv[0] = (float)r.x / (float)tiles->width;
+    uv[1] = (float)r.y / (float)tiles->height;
+    uv[2] = (float)(r.x + r.width)  / (float)tiles->width;
+    uv[3] = (float)(r.y + r.height) / (float)tiles->height;
+}
+
+void panel_mesh_update(PanelMesh &m, bool curved, float width, float height,
+                       float arcDegrees, int segments, const DesktopTexture *tiles)
+{
+    const int gridWidth  = tiles ? tiles->width : 0;
+    const int gridHeight = tiles ? tiles->height : 0;
+    const int gridTile   = tiles ? tiles->tiles[0].rect.width : 0;
+    if (m.vao && m.curved == curved && m.width == width && m.height == height &&
+        m.arcDegrees == arcDegrees && m.segments == segments &&
+        m.gridWidth == gridWidth && m.gridHeight == gridHeight && m.gridTile == gridTile)
+        return;
+
+    const int ranges = tiles ? tiles->numTiles : 1;
+    std::vector<float> verts;
+    verts.reserve((size_t)(segments + ranges + 1) * 4 * 5);
+
+    for (int i = 0; i < ranges; ++i) {
+        float uv[4];
+        tile_uv_bounds(tiles, i, uv);
+        m.first[i] = (GLint)(verts.size() / 5);
+
+        // a strip of columns across the tile; the cylinder keeps about the
+        // same column density as untiled, ending exactly on the tile edges
+        int cols = 1;
+        if (curved) {
+            cols = (int)ceilf((float)segments * (uv[2] - uv[0]) - 1e-3f);
+            if (cols < 1)
+                cols = 1;
+        }
+        for (int c = 0; c <= cols; ++c) {
+            float u = c == cols ? uv[2] : uv[0] + (uv[2] - uv[0]) * (float)c / (float)cols;
+            float top[3], bottom[3];
+            panel_point(curved, width, height, arcDegrees, u, uv[1], top);
+            panel_point(curved, width, height, arcDegrees, u, uv[3], bottom);
+            push_vertex(verts, top[0], top[1], top[2], u, uv[1]);
+            push_vertex(verts, bottom[0], bottom[1], bottom[2], u, uv[3]);
+        }
+        m.count[i] = (GLsizei)(verts.size() / 5) - m.first[i];
+    }
+
+    if (!m.vao) {
+        glGenVertexArrays(1, &m.vao);
+        glGenBuffers(1, &m.vbo);
+    }
+    glBindVertexArray(m.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(verts.size() * sizeof(float)),
+                 verts.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (const void *)(3 * sizeof(float)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m.vertexCount = (GLsizei)(verts.size() / 5);
+    m.mode = GL_TRIANGLE_STRIP;
+    m.numRanges = ranges;
+    m.curved = curved;
+    m.width = width;
+    m.height = height;
+    m.arcDegrees = arcDegrees;
+    m.segments = segments;
+    m.gridWidth = gridWidth;
+    m.gridHeight = gridHeight;
+    m.gridTile = gridTile;
+}
+
+// The pointer quad: frame UVs uv clipped to the panel, with texture
+// coordinates across the unclipped image. It moves most frames, so the few
+// vertices are streamed rather than kept.
+static bool cursor_mesh_update(Renderer &r, bool curved, float width, float height,
+                               const float uv[4])
+{
+    PanelMesh &m = r.cursorQuad;
+    if (m.vao && m.vertexCount && m.curved == curved && m.width == width && m.height == height &&
+        std::memcmp(r.cursorUv, uv, sizeof(r.cursorUv)) == 0)
+        return true;
+
+    const float u0 = std::max(uv[0], 0.0f), u1 = std::min(uv[2], 1.0f);
+    const float v0 = std::max(uv[1], 0.0f), v1 = std::min(uv[3], 1.0f);
+    if (u0 >= u1 || v0 >= v1 || uv[2] <= uv[0] || uv[3] <= uv[1])
+        return false;
+
+    const float arc = curved ? PANEL_CURVE_ARC_DEGREES : 0.0f;
+    int cols = 1;
+    if (curved) {
+        cols = (int)ceilf((float)PANEL_CURVE_SEGMENTS * (u1 - u0));
+        if (cols < 1)
+            cols = 1;
+    }
+    const float t0 = (v0 - uv[1]) / (uv[3] - uv[1]);
+    const float t1 = (v1 - uv[1]) / (uv[3] - uv[1]);
+    std::vector<float> verts;
+    verts.reserve((size_t)(cols + 1) * 2 * 5);
+    for (int c = 0; c <= cols; ++c) {
+        const float u = c == cols ? u1 : u0 + (u1 - u0) * (float)c / (float)cols;
+        const float s = (u - uv[0]) / (uv[2] - uv[0]);
+        float top[3], bottom[3];
+        panel_point(curved, width, height, arc, u, v0, top);
+        panel_point(curved, width, height, arc, u, v1, bottom);
+        push_vertex(verts, top[0], top[1], top[2], s, t0);
+        push_vertex(verts, bottom[0], bottom[1], bottom[2], s, t1);
+    }
+
+    if (!m.vao) {
+        glGenVertexArrays(1, &m.vao);
+        glGenBuffers(1, &m.vbo);
+        glBindVertexArray(m.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                              (const void *)(3 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(verts.size() * sizeof(float)),
+                 verts.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m.vertexCount = (GLsizei)(verts.size() / 5);
+    m.mode = GL_TRIANGLE_STRIP;
+    m.numRanges = 1;
+    m.first[0] = 0;
+    m.count[0] = m.vertexCount;
+    m.curved = curved;
+    m.width = width;
+    m.height = height;
+    std::memcpy(r.cursorUv, uv, sizeof(r.cursorUv));
+    return true;
+}
+
+void panel_mesh_destroy(PanelMesh &m)
+{
+    if (m.vbo) glDeleteBuffers(1, &m.vbo);
+    if (m.vao) glDeleteVertexArrays(1, &m.vao);
+    m.vbo = m.vao = 0;
+}
+
+// Frame UV -> tile UV for the shader: scale in xy, offset in zw.
+static void tile_uv_rect(const DesktopTexture &dt, const TextureTile &t, float out[4])
+{
+    out[0] = (float)dt.width  / (float)t.stored.width;
+    out[1] = (float)dt.height / (float)t.stored.height;
+    out[2] = -(float)t.stored.x / (float)t.stored.width;
+    out[3] = -(float)t.stored.y / (float)t.stored.height;
+}
+
+// Each range of the mesh with its tile of desktop, or the whole mesh with
+// tex when desktop is null.
+static void draw_ranges(Renderer &r, const PanelMesh &m, const DesktopTexture *desktop,
+                        GLuint tex, bool stereo)
+{
+    const GLint uUvRect = stereo ? r.uStereoUvRect : r.uUvRect;
+    const bool instanced = stereo && r.stereoPath == STEREO_PATH_INSTANCED;
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(m.vao);
+    for (int i = 0; i < m.numRanges; ++i) {
+        float rect[4] = { 1.0f, 1.0f, 0.0f, 0.0f };
+        GLuint t = tex;
+        if (desktop) {
+            const TextureTile &tile = desktop->tiles[i];
+            if (!tile.tex)
+                continue;       // never in view, never uploaded
+            t = tile.tex;
+            tile_uv_rect(*desktop, tile, rect);
+        }
+        glUniform4fv(uUvRect, 1, rect);
+        glBindTexture(GL_TEXTURE_2D, t);
+        if (instanced)
+            glDrawArraysInstanced(m.mode, m.first[i], m.count[i], 2);
+        else
+            glDrawArrays(m.mode, m.first[i], m.count[i]);
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static void draw_mesh(Renderer &r, const PanelMesh &m, const DesktopTexture *desktop,
+                      GLuint tex, const float mvpCol[16])
+{
+    glUseProgram(r.program);
+    glUniformMatrix4fv(r.uMvp, 1, GL_FALSE, mvpCol);
+    draw_ranges(r, m, desktop, tex, false);
+    glUseProgram(0);
+}
+
+static void draw_mesh_stereo(Renderer &r, const PanelMesh &m, const DesktopTexture *desktop,
+                             GLuint tex, const float mvpCol[2][16])
+{
+    glUseProgram(r.stereoProgram);
+    glUniformMatrix4fv(r.uStereoMvp, 2, GL_FALSE, &mvpCol[0][0]);
+    draw_ranges(r, m, desktop, tex, true);
+    glUseProgram(0);
+}
+
+// ---------------------------------------------------------------------------
+// Tile visibility
+// ---------------------------------------------------------------------------
+
+#define CULL_SAMPLES_CURVED 9   // points along each curved tile edge
+
+// True when every point is outside the same plane of the grown frustum.
+static bool points_outside(const float (*clip)[4], int n)
+{
+    const float k = 1.0f + PANEL_CULL_MARGIN;
+    for (int plane = 0; plane < 6; ++plane) {
+        bool allOut = true;
+        for (int i = 0; i < n && allOut; ++i) {
+            const float *c = clip[i];
+            float d;
+            switch (plane) {
+            case 0:  d = k * c[3] + c[0]; break;
+            case 1:  d = k * c[3] - c[0]; break;
+            case 2:  d = k * c[3] + c[1]; break;
+            case 3:  d = k * c[3] - c[1]; break;
+            case 4:  d = c[3] + c[2]; break;
+            default: d = c[3] - c[2]; break;
+            }
+            allOut = d < 0.0f;
+        }
+        if (allOut)
+            return true;
+    }
+    return false;
+}
+
+uint32_t renderer_visible_tiles(const DesktopTexture &desktop, const float mvpCol[][16],
+                                int numViews, float width, float height, bool curved)
+{
+    const float arc = curved ? PANEL_CURVE_ARC_DEGREES : 0.0f;
+    const int samples = curved ? CULL_SAMPLES_CURVED : 2;
+    uint32_t mask = 0;
+
+    for (int t = 0; t < desktop.numTiles; ++t) {
+        float uv[4];
+        tile_uv_bounds(&desktop, t, uv);
+
+        float local[CULL_SAMPLES_CURVED * 2][3];
+        int n = 0;
+        for (int i = 0; i < samples; ++i) {
+            float u = i == samples - 1 ? uv[2]
+                    : uv[0] + (uv[2] - uv[0]) * (float)i / (float)(samples - 1);
+            panel_point(curved, width, height, arc, u, uv[1], local[n++]);
+            panel_point(curved, width, height, arc, u, uv[3], local[n++]);
+        }
+
+        for (int v = 0; v < numViews; ++v) {
+            const float *m = mvpCol[v];
+            float clip[CULL_SAMPLES_CURVED * 2][4];
+            for (int i = 0; i < n; ++i)
+                for (int row = 0; row < 4; ++row)
+                    clip[i][row] = m[row] * local[i][0] + m[4 + row] * local[i][1] +
+                                   m[8 + row] * local[i][2] + m[12 + row];
+            if (!points_outside(clip, n)) {
+                mask |= 1u << t;
+                break;
+            }
+        }
+    }
+    return mask;
+}
+
+// ---------------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------------
+
+static void init_stereo(Renderer &r, void *(*getProc)(const char *name))
+{
+    if (gl_has_extension("GL_OVR_multiview2") && getProc) {
+        r.framebufferTextureMultiview = reinterpret_cast<PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC>(
+            getProc("glFramebufferTextureMultiviewOVR"));
+        if (r.framebufferTextureMultiview) {
+            r.stereoProgram = link_program(k_stereoMultiviewVertexShader, k_panelFragmentShader);
+            if (r.stereoProgram)
+                r.stereoPath = STEREO_PATH_MULTIVIEW;
+        }
+    }
+
+    if (!r.stereoProgram) {
+        const char *ext = nullptr;
+        if (gl_has_extension("GL_ARB_shader_viewport_layer_array"))
+            ext = "GL_ARB_shader_viewport_layer_array";
+        else if (gl_has_extension("GL_AMD_vertex_shader_layer"))
+            ext = "GL_AMD_vertex_shader_layer";
+
+        if (ext) {
+            char src[1024];
+            std::snprintf(src, sizeof(src), k_stereoInstancedVertexShader, ext);
+            r.stereoProgram = link_program(src, k_panelFragmentShader);
+            if (r.stereoProgram)
+                r.stereoPath = STEREO_PATH_INSTANCED;
+        }
+    }
+
+    if (r.stereoProgram) {
+        r.uStereoMvp = glGetUniformLocation(r.stereoProgram, "uMvp");
+        r.uStereoUvRect = glGetUniformLocation(r.stereoProgram, "uUvRect");
+        glUseProgram(r.stereoProgram);
+        glUniform1i(glGetUniformLocation(r.stereoProgram, "uTex"), 0);
+        glUseProgram(0);
+    }
+
+    std::fprintf(stderr, "Single-pass stereo: %s\n",
+                 r.stereoPath == STEREO_PATH_MULTIVIEW ? "OVR_multiview" :
+                 r.stereoPath == STEREO_PATH_INSTANCED ? "instanced layers" :
+                 "unsupported");
+}
+
+bool renderer_init(Renderer &r, void *(*getProc)(const char *name))
+{
+    r.program = link_program(k_panelVertexShader, k_panelFragmentShader);
+    if (!r.program)
+        return false;
+
+    r.uMvp = glGetUniformLocation(r.program, "uMvp");
+    r.uTex = glGetUniformLocation(r.program, "uTex");
+    r.uUvRect = glGetUniformLocation(r.program, "uUvRect");
+    glUseProgram(r.program);
+    glUniform1i(r.uTex, 0);
+    glUseProgram(0);
+
+    // preview quad lives in clip space, 80% of the window
+    panel_mesh_update(r.previewQuad, false, 1.6f, 1.6f, 0.0f, 0, nullptr);
+
+    init_stereo(r, getProc);
+    return true;
+}
+
+void renderer_destroy(Renderer &r)
+{
+    panel_mesh_destroy(r.previewQuad);
+    panel_mesh_destroy(r.hudQuad);
+    panel_mesh_destroy(r.cursorQuad);
+    if (r.program)
+        glDeleteProgram(r.program);
+    if (r.stereoProgram)
+        glDeleteProgram(r.stereoProgram);
+    r.program = r.stereoProgram = 0;
+    r.stereoPath = STEREO_PATH_NONE;
+}
+
+void renderer_draw_panel(Renderer &r, PanelMesh &m, const DesktopTexture &desktop,
+                         const float mvpCol[16], float width, float height, bool curved)
+{
+    if (!desktop.initialized)
+        return;
+
+    panel_mesh_update(m, curved, width, height,
+                      curved ? PANEL_CURVE_ARC_DEGREES : 0.0f,
+                      curved ? PANEL_CURVE_SEGMENTS : 0, &desktop);
+    draw_mesh(r, m, &desktop, 0, mvpCol);
+}
+
+void renderer_draw_panel_stereo(Renderer &r, PanelMesh &m, const DesktopTexture &desktop,
+                                const float mvpCol[2][16],
+                                float width, float height, bool curved)
+{
+    if (!desktop.initialized || r.stereoPath == STEREO_PATH_NONE)
+        return;
+
+    panel_mesh_update(m, curved, width, height,
+                      curved ? PANEL_CURVE_ARC_DEGREES : 0.0f,
+                      curved ? PANEL_CURVE_SEGMENTS : 0, &desktop);
+
+    draw_mesh_stereo(r, m, &desktop, 0, mvpCol);
+}
+
+void renderer_draw_hud(Renderer &r, GLuint tex, const float mvpCol[16],
+                       float width, float height)
+{
+    if (!tex)
+        return;
+
+    panel_mesh_update(r.hudQuad, false, width, height, 0.0f, 0, nullptr);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    draw_mesh(r, r.hudQuad, nullptr, tex, mvpCol);
+    glDisable(GL_BLEND);
+}
+
+void renderer_draw_hud_stereo(Renderer &r, GLuint tex, const float mvpCol[2][16],
+                              float width, float height)
+{
+    if (!tex || r.stereoPath == STEREO_PATH_NONE)
+        return;
+
+    panel_mesh_update(r.hudQuad, false, width, height, 0.0f, 0, nullptr);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    draw_mesh_stereo(r, r.hudQuad, nullptr, tex, mvpCol);
+    glDisable(GL_BLEND);
+}
+
+void renderer_draw_cursor(Renderer &r, GLuint tex, const float uv[4], const float mvpCol[16],
+                          float width, float height, bool curved)
+{
+    if (!tex || !cursor_mesh_update(r, curved, width, height, uv))
+        return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    draw_mesh(r, r.cursorQuad, nullptr, tex, mvpCol);
+    glDisable(GL_BLEND);
+}
+
+void renderer_draw_cursor_stereo(Renderer &r, GLuint tex, const float uv[4],
+                                 const float mvpCol[2][16],
+                                 float width, float height, bool curved)
+{
+    if (!tex || r.stereoPath == STEREO_PATH_NONE ||
+        !cursor_mesh_update(r, curved, width, height, uv))
+        return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    draw_mesh_stereo(r, r.cursorQuad, nullptr, tex, mvpCol);
+    glDisable(GL_BLEND);
+}
+
+bool stereo_target_init(StereoTarget &t, const Renderer &r, int width, int height)
+{
+    if (r.stereoPath == STEREO_PATH_NONE)
+        return false;
+
+    glGenTextures(1, &t.tex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, t.tex);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, 2,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &t.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, t.fbo);
+    if (r.stereoPath == STEREO_PATH_MULTIVIEW)
+        r.framebufferTextureMultiview(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.tex, 0, 0, 2);
+    else
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.tex, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::fprintf(stderr, "Stereo FBO incomplete (status=0x%x)\n", status);
+        stereo_target_destroy(t);
+        return false;
+    }
+
+    t.width = width;
+    t.height = height;
+    return true;
+}
+
+void stereo_target_destroy(StereoTarget &t)
+{
+    if (t.fbo) glDeleteFramebuffers(1, &t.fbo);
+    if (t.tex) glDeleteTextures(1, &t.tex);
+    t.fbo = t.tex = 0;
+    t.width = t.height = 0;
+}
+
+void renderer_draw_preview(Renderer &r, PanelMesh &mesh, const DesktopTexture &desktop,
+                           float width, float height, bool curved, float aspect)
+{
+    if (!desktop.initialized)
+        return;
+
+    if (!curved) {
+        float identity[16] = {
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 1,
+        };
+        panel_mesh_update(r.previewQuad, false, 1.6f, 1.6f, 0.0f, 0, &desktop);
+        draw_mesh(r, r.previewQuad, &desktop, 0, identity);
+        return;
+    }
+
+    // look at the cylinder from its axis, wide enough to see the whole arc
+    const float fovx = (PANEL_CURVE_ARC_DEGREES + 10.0f) * (float)M_PI / 180.0f;
+    const float fovy = 2.0f * atanf(tanf(fovx * 0.5f) / (aspect > 0.0f ? aspect : 1.0f));
+    float proj[16];
+    mat4_perspective_col(fovy, aspect, 0.05f, 100.0f, proj);
+    renderer_draw_panel(r, mesh, desktop, proj, width, height, true);
+}
+
+void mat4_perspective_col(float fovyRadians, float aspect, float zNear, float zFar,
+                          float out[16])
+{
+    const float f = 1.0f / tanf(fovyRadians * 0.5f);
+    std::memset(out, 0, 16 * sizeof(float));
+    out[0]  = f / aspect;
+    out[5]  = f;
+    out[10] = (zFar + zNear) / (zNear - zFar);
+    out[11] = -1.0f;
+    out[14] = (2.0f * zFar * zNear) / (zNear - zFar);
+}
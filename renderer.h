@@ -0,0 +1,148 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+// Core-profile desktop panel renderer.
+//
+// The flat plane, the cylinder segment and the preview quad are built once
+// into VAO/VBOs and only rebuilt when their size, arc, segment count or tile
+// grid changes. Each panel owns its mesh (outputs differ in size and tiles),
+// so one panel's draw never rebuilds another's. One textured shader draws
+// all of them; the caller passes a column-major model-view-projection
+// matrix.
+//
+// A tiled desktop texture (see texture_upload.h) is drawn one tile at a
+// time: the panel meshes are built with a vertex range per tile whose
+// vertices sit exactly on the tile edges, and a per-draw UV rect maps frame
+// coordinates into the tile's stored area, so the tiles meet without seams.
+//
+// Single-pass stereo draws both eyes into the two layers of a texture array
+// with one draw call: via OVR_multiview where available, otherwise instanced
+// with gl_Layer written from the vertex shader
+// (ARB_shader_viewport_layer_array / AMD_vertex_shader_layer).
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdint>
+#include "texture_upload.h"
+
+#define PANEL_CURVE_ARC_DEGREES 90.0f
+#define PANEL_CURVE_SEGMENTS    64
+#define PANEL_CULL_MARGIN       0.15f   // frustum grown by this much, for head motion until the upload
+
+struct PanelMesh {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLsizei vertexCount = 0;
+    GLenum mode = GL_TRIANGLE_STRIP;
+
+    // parameters the mesh was built with
+    bool curved = false;
+    float width  = 0.0f;
+    float height = 0.0f;
+    float arcDegrees = 0.0f;
+    int segments = 0;
+
+    // one vertex range per desktop tile (a single range when untiled)
+    int numRanges = 0;
+    GLint first[UPLOAD_MAX_TILES] = {};
+    GLsizei count[UPLOAD_MAX_TILES] = {};
+    int gridWidth = 0;              // tiled frame size and tile edge, 0 = untiled
+    int gridHeight = 0;
+    int gridTile = 0;
+};
+
+enum StereoPath {
+    STEREO_PATH_NONE = 0,       // single pass unsupported, draw each eye
+    STEREO_PATH_MULTIVIEW,
+    STEREO_PATH_INSTANCED,
+};
+
+struct Renderer {
+    GLuint program = 0;
+    GLint uMvp = -1;
+    GLint uTex = -1;
+    GLint uUvRect = -1;
+
+    // single-pass stereo
+    StereoPath stereoPath = STEREO_PATH_NONE;
+    GLuint stereoProgram = 0;
+    GLint uStereoMvp = -1;
+    GLint uStereoUvRect = -1;
+    PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC framebufferTextureMultiview = nullptr;
+
+    PanelMesh previewQuad;
+    PanelMesh hudQuad;
+    PanelMesh cursorQuad;
+    float cursorUv[4] = {};         // frame UVs cursorQuad was built for
+};
+
+// Both eyes as layers 0 (left) and 1 (right) of one texture array.
+struct StereoTarget {
+    GLuint tex = 0;
+    GLuint fbo = 0;
+    int width  = 0;
+    int height = 0;
+};
+
+// Needs a current core-profile (3.3+) context. getProc resolves extension
+// entry points (SDL_GL_GetProcAddress, eglGetProcAddress, ...).
+bool renderer_init(Renderer &r, void *(*getProc)(const char *name));
+void renderer_destroy(Renderer &r);
+
+// Build or rebuild the mesh if its parameters changed. With tiles, the mesh
+// gets one vertex range per tile of that texture; nullptr gives one range.
+void panel_mesh_update(PanelMesh &m, bool curved, float width, float height,
+                       float arcDegrees, int segments, const DesktopTexture *tiles);
+void panel_mesh_destroy(PanelMesh &m);
+
+// Draw the desktop panel (flat plane or cylinder segment, centred on -Z)
+// with the given column-major MVP, using (and if needed rebuilding) the
+// panel's own mesh. Tiles without storage are skipped.
+void renderer_draw_panel(Renderer &r, PanelMesh &mesh, const DesktopTexture &desktop,
+                         const float mvpCol[16], float width, float height, bool curved);
+
+// Single pass: draw the panel into both layers of the bound stereo target.
+// mvpCol[0] is the left eye, mvpCol[1] the right.
+void renderer_draw_panel_stereo(Renderer &r, PanelMesh &mesh, const DesktopTexture &desktop,
+                                const float mvpCol[2][16],
+                                float width, float height, bool curved);
+
+// Mask of the desktop's tiles inside any of the views' frusta (grown by
+// PANEL_CULL_MARGIN), for DesktopTexture::visibleTiles.
+uint32_t renderer_visible_tiles(const DesktopTexture &desktop, const float mvpCol[][16],
+                                int numViews, float width, float height, bool curved);
+
+// Stats HUD: a flat, alpha-blended quad of the given size centred on the
+// origin of whatever space mvpCol maps from.
+void renderer_draw_hud(Renderer &r, GLuint tex, const float mvpCol[16],
+                       float width, float height);
+void renderer_draw_hud_stereo(Renderer &r, GLuint tex, const float mvpCol[2][16],
+                              float width, float height);
+
+// Pointer layer (cursor_layer.h): the image in tex as a premultiplied,
+// alpha-blended quad lying on the panel over frame UVs uv = {u0, v0, u1, v1},
+// clipped to the panel. Draw it after the panel, with the panel's MVP.
+void renderer_draw_cursor(Renderer &r, GLuint tex, const float uv[4], const float mvpCol[16],
+                          float width, float height, bool curved);
+void renderer_draw_cursor_stereo(Renderer &r, GLuint tex, const float uv[4],
+                                 const float mvpCol[2][16],
+                                 float width, float height, bool curved);
+
+// Create the layered render target; false if single pass is unsupported.
+bool stereo_target_init(StereoTarget &t, const Renderer &r, int width, int height);
+void stereo_target_destroy(StereoTarget &t);
+
+// Draw the desktop into the current viewport for the SDL preview window;
+// a curved panel is drawn with its mesh.
+void renderer_draw_preview(Renderer &r, PanelMesh &mesh, const DesktopTexture &desktop,
+                           float width, float height, bool curved, float aspect);
+
+// Column-major perspective projection.
+void mat4_perspective_col(float fovyRadians, float aspect, float zNear, float zFar,
+                          float out[16]);
+
+#endif //RENDERER_H
@@ -0,0 +1,969 @@
+#include "screencopy.h"
+#include "pixel_format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+static int64_t monotonic_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------
+// Simple shm helper
+// ---------------------------------------------------------------------------
+
+static int create_shm_file(off_t size)
+{
+    char template_name[] = "/dev/shm/vrdesktop-XXXXXX";
+    int fd = mkstemp(template_name);
+    if (fd < 0) {
+        std::fprintf(stderr, "mkstemp failed: %s\n", std::strerror(errno));
+        return -1;
+    }
+
+    // we don't need the name anymore
+    unlink(template_name);
+
+    if (ftruncate(fd, size) < 0) {
+        std::fprintf(stderr, "ftruncate failed: %s\n", std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+// wl_shm buffers
+// ---------------------------------------------------------------------------
+
+static bool shm_buffer_create(shm_buffer *b, wl_shm *shm, uint32_t format,
+                              uint32_t width, uint32_t height, uint32_t stride)
+{
+    b->size = (size_t)stride * (size_t)height;
+    b->fd = create_shm_file(b->size);
+    if (b->fd < 0)
+        return false;
+
+    void *data = mmap(nullptr, b->size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED, b->fd, 0);
+    if (data == MAP_FAILED) {
+        std::fprintf(stderr, "mmap failed: %s\n", std::strerror(errno));
+        close(b->fd);
+        b->fd = -1;
+        return false;
+    }
+    b->data = static_cast<uint8_t *>(data);
+
+    b->pool = wl_shm_create_pool(shm, b->fd, (int)b->size);
+    b->buffer = wl_shm_pool_create_buffer(b->pool, 0, (int)width, (int)height,
+                                          (int)stride, format);
+    b->width = width;
+    b->height = height;
+    b->stride = stride;
+    b->format = format;
+    return true;
+}
+
+static void shm_buffer_destroy(shm_buffer *b)
+{
+    if (b->buffer)
+        wl_buffer_destroy(b->buffer);
+    if (b->pool)
+        wl_shm_pool_destroy(b->pool);
+    if (b->data)
+        munmap(b->data, b->size);
+    if (b->fd >= 0)
+        close(b->fd);
+    *b = shm_buffer();
+}
+
+// ---------------------------------------------------------------------------
+// Hotplug
+// ---------------------------------------------------------------------------
+
+static bool output_in_use(const screencopy_state *st, int output)
+{
+    for (int i = 0; i < st->num_streams; ++i)
+        if (st->streams[i].output == output)
+            return true;
+    return false;
+}
+
+// A (re)plugged output: streams that lost an output of the same name
+// capture from it again.
+static void reattach_streams(screencopy_state *st, int output)
+{
+    const char *name = st->outputs[output].name;
+    for (int i = 0; i < st->num_streams; ++i) {
+        capture_stream &s = st->streams[i];
+        if (!s.lost || s.output == output)
+            continue;
+        const char *old = st->outputs[s.output].name;
+        if (!old || std::strcmp(old, name) != 0)
+            continue;
+        std::fprintf(stderr, "Output %s is back, resuming capture\n", name);
+        s.output = output;
+        s.lost = false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// xdg-output listeners
+// ---------------------------------------------------------------------------
+
+static output_info *find_xdg_output(screencopy_state *st, zxdg_output_v1 *xdg_output)
+{
+    for (int i = 0; i < st->num_outputs; ++i)
+        if (st->outputs[i].xdg_output == xdg_output)
+            return &st->outputs[i];
+    return nullptr;
+}
+
+static void xdg_output_logical_position(void *data,
+                                        zxdg_output_v1 *xdg_output,
+                                        int32_t x, int32_t y)
+{
+    output_info *out = find_xdg_output(static_cast<screencopy_state *>(data), xdg_output);
+    if (out) {
+        out->x = x;
+        out->y = y;
+    }
+}
+
+static void xdg_output_logical_size(void *data,
+                                    zxdg_output_v1 *xdg_output,
+                                    int32_t width, int32_t height)
+{
+    output_info *out = find_xdg_output(static_cast<screencopy_state *>(data), xdg_output);
+    if (out) {
+        out->logical_width = width;
+        out->logical_height = height;
+    }
+}
+
+static void xdg_output_done(void *data,
+                            zxdg_output_v1 *xdg_output)
+{
+    (void)data; (void)xdg_output;
+}
+
+static void xdg_output_name(void *data,
+                            zxdg_output_v1 *xdg_output,
+                            const char *name)
+{
+    screencopy_state *st = static_cast<screencopy_state *>(data);
+    output_info *out = find_xdg_output(st, xdg_output);
+    if (out) {
+        free(out->name);
+        out->name = strdup(name);
+        std::fprintf(stderr, "Output %d name: %s\n", (int)(out - st->outputs), out->name);
+        reattach_streams(st, (int)(out - st->outputs));
+    }
+}
+
+static void xdg_output_description(void *data,
+                                   zxdg_output_v1 *xdg_output,
+                                   const char *description)
+{
+    (void)data; (void)xdg_output; (void)description;
+}
+
+static const zxdg_output_v1_listener xdg_output_listener = {
+    xdg_output_logical_position,
+    xdg_output_logical_size,
+    xdg_output_done,
+    xdg_output_name,
+    xdg_output_description,
+};
+
+static void setup_xdg_outputs(screencopy_state *st)
+{
+    if (!st->xdg_output_manager)
+        return;
+
+    for (int i = 0; i < st->num_outputs; ++i) {
+        if (!st->outputs[i].wl_output_obj || st->outputs[i].xdg_output)
+            continue;
+
+        st->outputs[i].xdg_output =
+            zxdg_output_manager_v1_get_xdg_output(
+                st->xdg_output_manager,
+                st->outputs[i].wl_output_obj);
+
+        zxdg_output_v1_add_listener(
+            st->outputs[i].xdg_output,
+            &xdg_output_listener,
+            st);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Wayland registry
+// ---------------------------------------------------------------------------
+
+static void registry_global(void *data,
+                            wl_registry *registry,
+                            uint32_t name,
+                            const char *interface,
+                            uint32_t version)
+{
+    screencopy_state *st = static_cast<screencopy_state *>(data);
+
+    if (std::strcmp(interface, wl_shm_interface.name) == 0) {
+        st->shm = static_cast<wl_shm *>(
+            wl_registry_bind(registry, name, &wl_shm_interface, 1));
+    } else if (std::strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0) {
+        st->screencopy_version = version < 3 ? version : 3;
+        st->screencopy_manager = static_cast<zwlr_screencopy_manager_v1 *>(
+            wl_registry_bind(registry, name, &zwlr_screencopy_manager_v1_interface,
+                             st->screencopy_version));
+    } else if (std::strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
+        st->xdg_output_manager = static_cast<zxdg_output_manager_v1 *>(
+            wl_registry_bind(registry, name, &zxdg_output_manager_v1_interface, 3));
+    } else if (std::strcmp(interface, wl_output_interface.name) == 0) {
+        // hotplugged outputs take the place of unplugged ones nothing
+        // captures any more
+        int index = -1;
+        for (int i = 0; i < st->num_outputs && index < 0; ++i)
+            if (!st->outputs[i].wl_output_obj && !output_in_use(st, i))
+                index = i;
+        if (index < 0 && st->num_outputs < MAX_OUTPUTS)
+            index = st->num_outputs++;
+        if (index < 0) {
+            std::fprintf(stderr, "Too many outputs, ignoring one\n");
+            return;
+        }
+
+        output_info &out = st->outputs[index];
+        free(out.name);
+        out = output_info();
+        out.global_name = name;
+        out.wl_output_obj = static_cast<wl_output *>(
+            wl_registry_bind(registry, name, &wl_output_interface, 2));
+        // its name (and any stream waiting for it) arrives on the xdg-output
+        setup_xdg_outputs(st);
+    }
+}
+
+static void registry_global_remove(void *data,
+                                   wl_registry *registry,
+                                   uint32_t name)
+{
+    screencopy_state *st = static_cast<screencopy_state *>(data);
+    (void)registry;
+
+    for (int i = 0; i < st->num_outputs; ++i) {
+        output_info &out = st->outputs[i];
+        if (!out.wl_output_obj || out.global_name != name)
+            continue;
+
+        std::fprintf(stderr, "Output %d (%s) unplugged\n", i, out.name ? out.name : "?");
+        for (int k = 0; k < st->num_streams; ++k)
+            if (st->streams[k].output == i)
+                st->streams[k].lost = true;
+
+        // the name stays so the output can be recognized when it returns;
+        // in-flight frames on it fail and give their slots back
+        if (out.xdg_output)
+            zxdg_output_v1_destroy(out.xdg_output);
+        wl_output_destroy(out.wl_output_obj);
+        out.xdg_output = nullptr;
+        out.wl_output_obj = nullptr;
+        return;
+    }
+}
+
+static const wl_registry_listener registry_listener = {
+    registry_global,
+    registry_global_remove
+};
+
+static bool add_stream(screencopy_state *st, int output, const capture_region *region)
+{
+    for (int i = 0; i < st->num_streams && !region; ++i)
+        if (st->streams[i].output == output && !st->streams[i].has_region)
+            return true;
+    if (st->num_streams >= SCREENCOPY_MAX_STREAMS) {
+        std::fprintf(stderr, "Only %d outputs can be captured at once\n",
+                     SCREENCOPY_MAX_STREAMS);
+        return false;
+    }
+
+    capture_stream &s = st->streams[st->num_streams++];
+    s = capture_stream();
+    s.st = st;
+    s.output = output;
+
+    const output_info &out = st->outputs[output];
+    if (region) {
+        s.has_region = true;
+        s.region = *region;
+        std::fprintf(stderr, "Capturing %dx%d at %d,%d of output \"%s\"\n",
+                     region->width, region->height, region->x, region->y,
+                     out.name ? out.name : "?");
+    } else if (out.name)
+        std::fprintf(stderr, "Capturing output \"%s\" (index %d) at %d,%d\n",
+                     out.name, output, out.x, out.y);
+    else
+        std::fprintf(stderr, "Capturing output %d (no name)\n", output);
+    return true;
+}
+
+static int find_output(const screencopy_state *st, const char *name, size_t len)
+{
+    for (int i = 0; i < st->num_outputs; ++i) {
+        const char *n = st->outputs[i].name;
+        if (n && std::strlen(n) == len && std::strncmp(n, name, len) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// The output under the region's centre; the region is clipped to it and
+// made relative to it.
+static void add_region(screencopy_state *st, const capture_region &r)
+{
+    const int32_t cx = r.x + r.width / 2;
+    const int32_t cy = r.y + r.height / 2;
+    for (int i = 0; i < st->num_outputs; ++i) {
+        const output_info &out = st->outputs[i];
+        if (out.logical_width <= 0 || out.logical_height <= 0 ||
+            cx < out.x || cx >= out.x + out.logical_width ||
+            cy < out.y || cy >= out.y + out.logical_height)
+            continue;
+
+        const int32_t x0 = std::max(r.x, out.x);
+        const int32_t y0 = std::max(r.y, out.y);
+        const int32_t x1 = std::min(r.x + r.width,  out.x + out.logical_width);
+        const int32_t y1 = std::min(r.y + r.height, out.y + out.logical_height);
+        capture_region local;
+        local.x = x0 - out.x;
+        local.y = y0 - out.y;
+        local.width  = x1 - x0;
+        local.height = y1 - y0;
+        add_stream(st, i, &local);
+        return;
+    }
+    std::fprintf(stderr, "No output under region %dx%d at %d,%d\n",
+                 r.width, r.height, r.x, r.y);
+}
+
+static void select_outputs(screencopy_state *st, const char *requested,
+                           const capture_region *regions, int num_regions)
+{
+    st->num_streams = 0;
+
+    if (num_regions > 0) {
+        for (int i = 0; i < num_regions; ++i)
+            add_region(st, regions[i]);
+    } else if (requested && std::strcmp(requested, "all") == 0) {
+        for (int i = 0; i < st->num_outputs; ++i)
+            add_stream(st, i, nullptr);
+    } else if (requested && st->xdg_output_manager) {
+        // comma-separated names, in the order given
+        const char *p = requested;
+        while (*p) {
+            const char *end = std::strchr(p, ',');
+            const size_t len = end ? (size_t)(end - p) : std::strlen(p);
+            if (len) {
+                int i = find_output(st, p, len);
+                if (i >= 0)
+                    add_stream(st, i, nullptr);
+                else
+                    std::fprintf(stderr, "Requested output \"%.*s\" not found\n", (int)len, p);
+            }
+            p += len + (end ? 1 : 0);
+        }
+    }
+
+    if (st->num_streams == 0) {
+        if (st->num_outputs > 0) {
+            std::fprintf(stderr, "Falling back to the first output.\n");
+            add_stream(st, 0, nullptr);
+        } else {
+            std::fprintf(stderr, "No wl_output objects found!\n");
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Screencopy frame listener (data is the capture_request)
+// ---------------------------------------------------------------------------
+
+// Allocate (or reuse) the slot's buffer for the chosen offer and start the copy.
+static void request_copy(capture_request *req, zwlr_screencopy_frame_v1 *frame)
+{
+    capture_stream *s = req->stream;
+    const uint32_t format = req->offer_format;
+    const uint32_t width  = req->offer_width;
+    const uint32_t height = req->offer_height;
+    const uint32_t stride = req->offer_stride;
+
+    // a mode change (or a region clipped by one)
+    req->resized = s->width && (s->width != width || s->height != height ||
+                                s->stride != stride || s->format != format);
+    if (req->resized)
+        std::fprintf(stderr, "screencopy: output %d now %ux%u\n", s->output, width, height);
+    s->format = format;
+    s->width  = width;
+    s->height = height;
+    s->stride = stride;
+
+    if (req->slot < 0 || req->slot >= s->num_buffers) {
+        req->failed = 1;
+        return;
+    }
+
+    // the slot is ours until it is published, so its buffer can be
+    // replaced without touching the frames the consumer still has
+    shm_buffer &b = s->buffers[req->slot];
+    if (b.buffer && (b.width != width || b.height != height ||
+                     b.stride != stride || b.format != format)) {
+        shm_buffer_destroy(&b);
+        s->reallocations++;
+    }
+    if (!b.buffer && !shm_buffer_create(&b, s->st->shm, format, width, height, stride)) {
+        req->failed = 1;
+        return;
+    }
+
+    // Ask compositor to copy into this request's buffer
+    if (req->with_damage)
+        zwlr_screencopy_frame_v1_copy_with_damage(frame, b.buffer);
+    else
+        zwlr_screencopy_frame_v1_copy(frame, b.buffer);
+}
+
+static void no_usable_format(capture_request *req)
+{
+    char name[32];
+    std::fprintf(stderr, "screencopy: no buffer format offered that uploads as is (first: %s)\n",
+                 pixel_format_name(req->first_format, name));
+    req->failed = 1;
+}
+
+static void frame_buffer(void *data,
+                         zwlr_screencopy_frame_v1 *frame,
+                         uint32_t format,
+                         uint32_t width,
+                         uint32_t height,
+                         uint32_t stride)
+{
+    capture_request *req = static_cast<capture_request *>(data);
+    if (req->num_offers++ == 0)
+        req->first_format = format;
+
+    if (!req->have_offer && pixel_format_lookup(format)) {
+        req->have_offer = true;
+        req->offer_format = format;
+        req->offer_width  = width;
+        req->offer_height = height;
+        req->offer_stride = stride;
+    }
+
+    // before v3 this is the only buffer event: copy now
+    if (req->stream->st->screencopy_version < ZWLR_SCREENCOPY_FRAME_V1_BUFFER_DONE_SINCE_VERSION) {
+        if (req->have_offer)
+            request_copy(req, frame);
+        else
+            no_usable_format(req);
+    }
+}
+
+static void frame_flags(void *data,
+                        zwlr_screencopy_frame_v1 *frame,
+                        uint32_t flags)
+{
+    (void)data; (void)frame; (void)flags;
+}
+
+static void frame_ready(void *data,
+                        zwlr_screencopy_frame_v1 *frame,
+                        uint32_t tv_sec_hi,
+                        uint32_t tv_sec_lo,
+                        uint32_t tv_nsec)
+{
+    capture_request *req = static_cast<capture_request *>(data);
+
+    uint64_t sec = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+    req->present_ns = (int64_t)sec * 1000000000ll + (int64_t)tv_nsec;
+    req->done = 1;
+    req->ready_ns = monotonic_ns();
+    zwlr_screencopy_frame_v1_destroy(frame);
+    req->frame = nullptr;
+}
+
+static void frame_failed(void *data,
+                         zwlr_screencopy_frame_v1 *frame)
+{
+    capture_request *req = static_cast<capture_request *>(data);
+
+    req->failed = 1;
+    req->done = 1;
+    zwlr_screencopy_frame_v1_destroy(frame);
+    req->frame = nullptr;
+}
+
+static void frame_damage(void *data,
+                         zwlr_screencopy_frame_v1 *frame,
+                         uint32_t x,
+                         uint32_t y,
+                         uint32_t width,
+                         uint32_t height)
+{
+    capture_request *req = static_cast<capture_request *>(data);
+    (void)frame;
+
+    if (req->num_damage >= FRAME_MAX_DAMAGE_RECTS) {
+        req->damage_overflow = true;
+        return;
+    }
+    FrameRect &r = req->damage[req->num_damage++];
+    r.x = (int)x;
+    r.y = (int)y;
+    r.width  = (int)width;
+    r.height = (int)height;
+}
+
+static void frame_linux_dmabuf(void *data,
+                               zwlr_screencopy_frame_v1 *frame,
+                               uint32_t format,
+                               uint32_t width,
+                               uint32_t height)
+{
+    (void)data; (void)frame; (void)format; (void)width; (void)height;
+}
+
+static void frame_buffer_done(void *data,
+                              zwlr_screencopy_frame_v1 *frame)
+{
+    // every buffer offer is in: copy into the one picked, if any
+    capture_request *req = static_cast<capture_request *>(data);
+    if (req->have_offer)
+        request_copy(req, frame);
+    else
+        no_usable_format(req);
+}
+
+static const zwlr_screencopy_frame_v1_listener frame_listener = {
+    frame_buffer,
+    frame_flags,
+    frame_ready,
+    frame_failed,
+    frame_damage,
+    frame_linux_dmabuf,
+    frame_buffer_done,
+};
+
+// ---------------------------------------------------------------------------
+// Event loop
+// ---------------------------------------------------------------------------
+
+static bool event_loop_add(screencopy_state *st, int fd, uint32_t events)
+{
+    epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(st->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::fprintf(stderr, "epoll_ctl failed: %s\n", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static bool event_loop_init(screencopy_state *st)
+{
+    st->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    st->wake_fd  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    st->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (st->epoll_fd < 0 || st->wake_fd < 0 || st->timer_fd < 0) {
+        std::fprintf(stderr, "event loop setup failed: %s\n", std::strerror(errno));
+        return false;
+    }
+
+    st->display_events = EPOLLIN;
+    return event_loop_add(st, wl_display_get_fd(st->display), st->display_events) &&
+           event_loop_add(st, st->wake_fd, EPOLLIN) &&
+           event_loop_add(st, st->timer_fd, EPOLLIN);
+}
+
+static void event_loop_destroy(screencopy_state *st)
+{
+    if (st->timer_fd >= 0) close(st->timer_fd);
+    if (st->wake_fd >= 0) close(st->wake_fd);
+    if (st->epoll_fd >= 0) close(st->epoll_fd);
+    st->timer_fd = st->wake_fd = st->epoll_fd = -1;
+}
+
+static void drain_fd(int fd)
+{
+    uint64_t count;
+    while (read(fd, &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+    }
+}
+
+int screencopy_wait(screencopy_state *st)
+{
+    const int display_fd = wl_display_get_fd(st->display);
+
+    while (wl_display_prepare_read(st->display) != 0) {
+        if (wl_display_dispatch_pending(st->display) < 0)
+            return -1;
+    }
+
+    // a full socket buffer has to drain before the rest of our requests
+    // go out, so also wait for the fd to become writable
+    uint32_t want = EPOLLIN;
+    if (wl_display_flush(st->display) < 0) {
+        if (errno != EAGAIN) {
+            wl_display_cancel_read(st->display);
+            return -1;
+        }
+        want |= EPOLLOUT;
+    }
+    if (want != st->display_events) {
+        epoll_event ev = {};
+        ev.events = want;
+        ev.data.fd = display_fd;
+        epoll_ctl(st->epoll_fd, EPOLL_CTL_MOD, display_fd, &ev);
+        st->display_events = want;
+    }
+
+    epoll_event events[3];
+    int n;
+    do {
+        n = epoll_wait(st->epoll_fd, events, 3, -1);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        wl_display_cancel_read(st->display);
+        return -1;
+    }
+
+    int result = 0;
+    bool readable = false;
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.fd == display_fd) {
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                wl_display_cancel_read(st->display);
+                return -1;
+            }
+            readable = (events[i].events & EPOLLIN) != 0;
+        } else if (events[i].data.fd == st->wake_fd) {
+            drain_fd(st->wake_fd);
+            result |= SCREENCOPY_EVENT_WAKE;
+        } else if (events[i].data.fd == st->timer_fd) {
+            drain_fd(st->timer_fd);
+            result |= SCREENCOPY_EVENT_TIMER;
+        }
+    }
+
+    if (readable) {
+        if (wl_display_read_events(st->display) < 0)
+            return -1;
+        result |= SCREENCOPY_EVENT_DISPLAY;
+    } else {
+        wl_display_cancel_read(st->display);
+    }
+    if (wl_display_dispatch_pending(st->display) < 0)
+        return -1;
+    return result;
+}
+
+void screencopy_arm_timer(screencopy_state *st, int64_t deadline_ns)
+{
+    // an all-zero it_value disarms; a deadline already passed fires at once
+    itimerspec spec = {};
+    if (deadline_ns > 0) {
+        spec.it_value.tv_sec  = deadline_ns / 1000000000ll;
+        spec.it_value.tv_nsec = deadline_ns % 1000000000ll;
+    }
+    timerfd_settime(st->timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void screencopy_wake(screencopy_state *st)
+{
+    uint64_t one = 1;
+    if (st->wake_fd >= 0 && write(st->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        std::fprintf(stderr, "screencopy: wakeup failed: %s\n", std::strerror(errno));
+}
+
+// ---------------------------------------------------------------------------
+// Connection
+// ---------------------------------------------------------------------------
+
+bool screencopy_connect(screencopy_state *st, const char *requested_outputs,
+                        const capture_region *regions, int num_regions)
+{
+    st->display = wl_display_connect(nullptr);
+    if (!st->display) {
+        std::fprintf(stderr, "Failed to connect to Wayland\n");
+        return false;
+    }
+
+    st->registry = wl_display_get_registry(st->display);
+    wl_registry_add_listener(st->registry, &registry_listener, st);
+    wl_display_roundtrip(st->display);
+
+    if (!st->shm || !st->screencopy_manager || st->num_outputs == 0) {
+        std::fprintf(stderr, "Wayland globals missing\n");
+        return false;
+    }
+
+    setup_xdg_outputs(st);
+    wl_display_roundtrip(st->display);
+
+    select_outputs(st, requested_outputs, regions, num_regions);
+    if (st->num_streams == 0)
+        return false;
+    for (int i = 0; i < st->num_streams; ++i) {
+        for (int j = 0; j < st->num_streams; ++j)
+            if (i != j && st->streams[i].output == st->streams[j].output)
+                st->streams[i].shared_output = true;
+        if (st->streams[i].shared_output)
+            std::fprintf(stderr, "Stream %d shares its output with another: plain copies\n", i);
+    }
+    return event_loop_init(st);
+}
+
+void screencopy_disconnect(screencopy_state *st)
+{
+    event_loop_destroy(st);
+    tile_diff_pool_stop(st->tile_diff_pool);
+    for (int i = 0; i < st->num_streams; ++i)
+        for (int b = 0; b < FRAME_HANDOFF_MAX_SLOTS; ++b)
+            shm_buffer_destroy(&st->streams[i].buffers[b]);
+    st->num_streams = 0;
+
+    for (int i = 0; i < st->num_outputs; i++) {
+        if (st->outputs[i].xdg_output)
+            zxdg_output_v1_destroy(st->outputs[i].xdg_output);
+        if (st->outputs[i].wl_output_obj)
+            wl_output_destroy(st->outputs[i].wl_output_obj);
+        free(st->outputs[i].name);
+        st->outputs[i] = output_info();
+    }
+    st->num_outputs = 0;
+
+    if (st->xdg_output_manager)
+        zxdg_output_manager_v1_destroy(st->xdg_output_manager);
+    if (st->screencopy_manager)
+        zwlr_screencopy_manager_v1_destroy(st->screencopy_manager);
+    if (st->shm)
+        wl_shm_destroy(st->shm);
+    if (st->registry)
+        wl_registry_destroy(st->registry);
+    if (st->display)
+        wl_display_disconnect(st->display);
+    st->xdg_output_manager = nullptr;
+    st->screencopy_manager = nullptr;
+    st->shm = nullptr;
+    st->registry = nullptr;
+    st->display = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Pipelined capture
+// ---------------------------------------------------------------------------
+
+void screencopy_set_in_flight(screencopy_state *st, int in_flight)
+{
+    if (in_flight < 1)
+        in_flight = 1;
+    if (in_flight > SCREENCOPY_MAX_IN_FLIGHT)
+        in_flight = SCREENCOPY_MAX_IN_FLIGHT;
+    for (int i = 0; i < st->num_streams; ++i) {
+        st->streams[i].max_in_flight = in_flight;
+        st->streams[i].num_buffers = in_flight + 2;
+    }
+}
+
+void screencopy_set_tile_diff(screencopy_state *st, int threads)
+{
+    tile_diff_pool_start(st->tile_diff_pool, threads);
+    for (int i = 0; i < st->num_streams; ++i)
+        st->streams[i].tile_diff.pool = &st->tile_diff_pool;
+    std::fprintf(stderr, "Tile diffing: %d px tiles, %d hashing threads\n",
+                 TILE_DIFF_TILE_SIZE, (int)st->tile_diff_pool.workers.size() + 1);
+}
+
+const output_info &screencopy_stream_output(const capture_stream *s)
+{
+    return s->st->outputs[s->output];
+}
+
+capture_region screencopy_stream_rect(const capture_stream *s)
+{
+    const output_info &out = screencopy_stream_output(s);
+    capture_region r;
+    if (out.logical_width <= 0 || out.logical_height <= 0)
+        return r;
+    if (s->has_region) {
+        r = s->region;
+        r.x += out.x;
+        r.y += out.y;
+    } else {
+        r.x = out.x;
+        r.y = out.y;
+        r.width = out.logical_width;
+        r.height = out.logical_height;
+    }
+    return r;
+}
+
+bool screencopy_parse_region(const char *spec, capture_region *out)
+{
+    capture_region r;
+    char tail;
+    if (std::sscanf(spec, "%d,%d,%dx%d%c", &r.x, &r.y, &r.width, &r.height, &tail) != 4 ||
+        r.width <= 0 || r.height <= 0)
+        return false;
+    *out = r;
+    return true;
+}
+
+bool screencopy_can_issue(const capture_stream *s, const FrameHandoff &h)
+{
+    return !s->lost && s->in_flight < s->max_in_flight && h.numFree > 0;
+}
+
+int screencopy_issue(capture_stream *s, FrameHandoff &h, bool with_damage)
+{
+    screencopy_state *st = s->st;
+    if (s->lost || s->in_flight >= s->max_in_flight)
+        return -1;
+
+    int slot = handoff_claim(h);
+    if (slot < 0)
+        return -1;
+
+    capture_request &req =
+        s->requests[(s->head + s->in_flight) % SCREENCOPY_MAX_IN_FLIGHT];
+    req = capture_request();
+    req.stream = s;
+    req.slot = slot;
+    req.with_damage = with_damage && !s->shared_output;
+    req.issue_ns = monotonic_ns();
+
+    const int32_t overlay_cursor = st->overlay_cursor ? 1 : 0;
+    if (s->has_region)
+        req.frame = zwlr_screencopy_manager_v1_capture_output_region(
+            st->screencopy_manager,
+            overlay_cursor,
+            st->outputs[s->output].wl_output_obj,
+            s->region.x, s->region.y, s->region.width, s->region.height
+        );
+    else
+        req.frame = zwlr_screencopy_manager_v1_capture_output(
+            st->screencopy_manager,
+            overlay_cursor,
+            st->outputs[s->output].wl_output_obj
+        );
+    zwlr_screencopy_frame_v1_add_listener(req.frame, &frame_listener, &req);
+    wl_display_flush(st->display);
+
+    s->in_flight++;
+    return 0;
+}
+
+int screencopy_collect(capture_stream *s, FrameHandoff &h,
+                       void (*on_published)(void *user, const capture_request &req),
+                       void *user)
+{
+    int published = 0;
+
+    // a later frame that finished first waits for the ones before it
+    while (s->in_flight > 0) {
+        capture_request &req = s->requests[s->head];
+        if (!req.done && !req.failed)
+            break;
+
+        if (req.frame) {
+            zwlr_screencopy_frame_v1_destroy(req.frame);
+            req.frame = nullptr;
+        }
+
+        if (req.failed) {
+            if (!s->lost)
+                std::fprintf(stderr, "screencopy: capture failed\n");
+            handoff_cancel(h, req.slot);
+        } else {
+            const shm_buffer &b = s->buffers[req.slot];
+            FrameSlot &f = h.slots[req.slot];
+            f.data   = b.data;
+            f.width  = (int)b.width;
+            f.height = (int)b.height;
+            f.stride = (int)b.stride;
+            f.format = b.format;
+            f.presentNs = req.present_ns;
+            f.readyNs = req.ready_ns;
+            const capture_region lr = screencopy_stream_rect(s);
+            f.logical = FrameRect{lr.x, lr.y, lr.width, lr.height};
+            f.fullDamage = !req.with_damage || req.damage_overflow || req.resized;
+            f.numDamage = f.fullDamage ? 0 : req.num_damage;
+            for (int i = 0; i < f.numDamage; ++i)
+                f.damage[i] = req.damage[i];
+            if (!tile_diff_frame(s->tile_diff, f)) {
+                // same pixels as the last published frame
+                handoff_cancel(h, req.slot);
+            } else {
+                handoff_publish(h, req.slot);
+                if (on_published)
+                    on_published(user, req);
+                published++;
+            }
+        }
+
+        req.slot = -1;
+        s->head = (s->head + 1) % SCREENCOPY_MAX_IN_FLIGHT;
+        s->in_flight--;
+    }
+    return published;
+}
+
+void screencopy_abort(capture_stream *s, FrameHandoff &h)
+{
+    while (s->in_flight > 0) {
+        capture_request &req = s->requests[s->head];
+        if (req.frame)
+            zwlr_screencopy_frame_v1_destroy(req.frame);
+        req.frame = nullptr;
+        handoff_cancel(h, req.slot);
+        req.slot = -1;
+        s->head = (s->head + 1) % SCREENCOPY_MAX_IN_FLIGHT;
+        s->in_flight--;
+    }
+    wl_display_flush(s->st->display);
+}
+
+int screencopy_capture_sync(capture_stream *s, FrameHandoff &h, bool with_damage)
+{
+    if (s->in_flight > 0 || screencopy_issue(s, h, with_damage) != 0)
+        return -1;
+
+    capture_request &req = s->requests[s->head];
+    while (!req.done && !req.failed) {
+        if (screencopy_wait(s->st) < 0) {
+            screencopy_abort(s, h);
+            return -1;
+        }
+    }
+    bool ok = !req.failed;
+    screencopy_collect(s, h, nullptr, nullptr);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,263 @@
+#ifndef SCREENCOPY_H
+#define SCREENCOPY_H
+
+// wlr-screencopy capture into the frame handoff.
+//
+// Captures are pipelined: up to max_in_flight frame objects are outstanding
+// at once, each copying into its own handoff slot's wl_shm buffer and
+// carrying its own done/failed/damage state. Completed frames are published
+// strictly in the order they were requested, so the compositor round trip of
+// one frame overlaps with the copies of the next.
+//
+// The capture thread sleeps in epoll on the Wayland fd (read through
+// wl_display_prepare_read / read_events), an eventfd other threads use to
+// wake it and a timerfd armed for the next paced request, so it never
+// blocks inside libwayland and never polls on a timeout. All outputs share
+// the one connection, so a single set covers any number of them.
+//
+// Each captured output is a capture_stream with its own buffer pool,
+// in-flight ring and handoff, so several monitors are captured side by side
+// and consumed (uploaded) independently. A stream can also capture just a
+// region of its output (capture_output_region), so the copy, the buffers
+// and the upload are sized by the region rather than the monitor.
+//
+// Of the buffer formats the compositor offers, the first one the uploader
+// takes without conversion (pixel_format.h) is used, and published frames
+// carry it.
+//
+// With tile diffing on (screencopy_set_tile_diff), frames that come without
+// usable damage get it from tile hashes instead, and unchanged ones are not
+// published (tile_diff.h).
+
+#include <cstddef>
+#include <cstdint>
+#include <wayland-client.h>
+#include "wlr-screencopy-unstable-v1-protocol.h"
+#include "xdg-output-unstable-v1-protocol.h"
+
+#include "frame_handoff.h"
+#include "tile_diff.h"
+
+#define MAX_OUTPUTS 16
+#define SCREENCOPY_MAX_STREAMS       4      // outputs captured at once
+#define SCREENCOPY_MAX_IN_FLIGHT     3
+#define SCREENCOPY_DEFAULT_IN_FLIGHT 2
+
+// ---------------------------------------------------------------------------
+// wl_shm buffer, one per handoff slot. The compositor copies straight into
+// these and the renderer uploads straight out of them, so a frame is never
+// copied on the CPU. Each is sized by the last frame captured into it: after
+// a mode change the buffers are replaced one at a time as their slots come
+// back to the producer, while the consumer keeps reading the old size from
+// the slot it holds.
+// ---------------------------------------------------------------------------
+
+struct shm_buffer {
+    int fd = -1;
+    size_t size = 0;            // stride * height
+    uint8_t *data = nullptr;
+    wl_shm_pool *pool = nullptr;
+    wl_buffer *buffer = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint32_t format = 0;
+};
+
+struct output_info {
+    wl_output *wl_output_obj = nullptr;     // null once unplugged
+    zxdg_output_v1 *xdg_output = nullptr;
+    uint32_t global_name = 0;   // wl_registry name, for global_remove
+    char *name = nullptr;      // e.g. "DP-3"
+
+    // xdg-output logical geometry in the compositor space (0 size: unknown);
+    // moves and mode changes rewrite it, see "Ownership" below
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t logical_width = 0;
+    int32_t logical_height = 0;
+};
+
+// A rectangle in the compositor's logical space (xdg-output coordinates).
+struct capture_region {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+struct screencopy_state;
+struct capture_stream;
+
+// One outstanding screencopy frame.
+struct capture_request {
+    capture_stream *stream = nullptr;
+    zwlr_screencopy_frame_v1 *frame = nullptr;
+    int slot = -1;              // handoff slot, and the buffer copied into
+    bool with_damage = false;
+    bool resized = false;       // first frame at a new size: damage is meaningless
+    int done = 0;
+    int failed = 0;
+
+    // v3 offers one buffer event per format before buffer_done; the first
+    // one the uploader takes as it is is kept
+    bool have_offer = false;
+    uint32_t offer_format = 0;
+    uint32_t offer_width = 0;
+    uint32_t offer_height = 0;
+    uint32_t offer_stride = 0;
+    int num_offers = 0;
+    uint32_t first_format = 0;  // for the error when none is usable
+
+    // copy_with_damage: the damaged boxes reported for this frame
+    FrameRect damage[FRAME_MAX_DAMAGE_RECTS];
+    int num_damage = 0;
+    bool damage_overflow = false;
+
+    int64_t issue_ns = 0;       // steady clock
+    int64_t ready_ns = 0;
+    int64_t present_ns = 0;     // compositor timestamp from frame_ready
+};
+
+// One captured output.
+struct capture_stream {
+    screencopy_state *st = nullptr;
+    int output = -1;            // index into st->outputs
+
+    // capture_output_region: part of the output, in its logical coordinates
+    bool has_region = false;
+    capture_region region;
+    // another stream captures the same output; the compositor tracks damage
+    // per client and output, so neither can use copy_with_damage
+    bool shared_output = false;
+    // the output was unplugged; nothing is issued until one with the same
+    // name comes back, and the consumer keeps its last frame meanwhile
+    bool lost = false;
+
+    // size the compositor last asked for; changes with the output's mode
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint32_t format = 0; // wl_shm_format
+
+    // one buffer per handoff slot (in flight + the two the handoff parks)
+    shm_buffer buffers[FRAME_HANDOFF_MAX_SLOTS];
+    int num_buffers = SCREENCOPY_DEFAULT_IN_FLIGHT + 2;
+    uint64_t reallocations = 0; // buffers replaced after a size change
+
+    // hashes of the last published frame, when tile diffing is on
+    TileDiff tile_diff;
+
+    // in-flight ring, oldest at head
+    capture_request requests[SCREENCOPY_MAX_IN_FLIGHT];
+    int max_in_flight = SCREENCOPY_DEFAULT_IN_FLIGHT;
+    int head = 0;
+    int in_flight = 0;
+};
+
+struct screencopy_state {
+    wl_display *display = nullptr;
+    wl_registry *registry = nullptr;
+    wl_shm *shm = nullptr;
+    zwlr_screencopy_manager_v1 *screencopy_manager = nullptr;
+    uint32_t screencopy_version = 0;
+    zxdg_output_manager_v1 *xdg_output_manager = nullptr;
+
+    output_info outputs[MAX_OUTPUTS];
+    int num_outputs = 0;
+
+    // selected outputs, in the order they were requested
+    capture_stream streams[SCREENCOPY_MAX_STREAMS];
+    int num_streams = 0;
+
+    // copy_with_damage: wait for changes and collect the damaged boxes
+    bool use_damage = false;
+
+    // draw the pointer into the captured frames; off when the cursor is
+    // drawn as its own layer (cursor_layer.h)
+    bool overlay_cursor = true;
+
+    // hashing threads of every stream's tile diff
+    TileDiffPool tile_diff_pool;
+
+    // event loop
+    int epoll_fd = -1;
+    int wake_fd = -1;           // eventfd
+    int timer_fd = -1;          // timerfd, CLOCK_MONOTONIC absolute
+    uint32_t display_events = 0;
+};
+
+// screencopy_wait() result bits
+#define SCREENCOPY_EVENT_DISPLAY 0x1
+#define SCREENCOPY_EVENT_WAKE    0x2
+#define SCREENCOPY_EVENT_TIMER   0x4
+
+// Connect to the Wayland display, bind the globals, open a stream for each
+// requested output and set up the event loop. requested_outputs is a
+// comma-separated list of output names or "all"; unknown names are skipped
+// and if none match the first output is used. If num_regions > 0 the
+// regions are captured instead, each from the output under its centre and
+// clipped to it. Returns false on failure.
+bool screencopy_connect(screencopy_state *st, const char *requested_outputs,
+                        const capture_region *regions, int num_regions);
+void screencopy_disconnect(screencopy_state *st);
+
+// Set the pipeline depth of every stream (clamped to
+// 1..SCREENCOPY_MAX_IN_FLIGHT) before the first capture; num_buffers follows it.
+void screencopy_set_in_flight(screencopy_state *st, int in_flight);
+
+// Derive damage from tile hashes for frames the compositor sends without
+// any and drop unchanged frames, hashing on `threads` threads (0 = one per
+// core). Call after connect; disconnect stops the threads.
+void screencopy_set_tile_diff(screencopy_state *st, int threads);
+
+// Ownership: once the capture thread runs, the outputs and streams are its
+// alone. Its Wayland callbacks rewrite output geometry (xdg-output), stream
+// size and format (buffer offers) and the output list (hotplug) at any time,
+// without locks. Other threads may read them only before that thread starts
+// or after it has been joined; while it runs, each published frame carries
+// a snapshot of what the render side needs (FrameSlot width, height, format
+// and logical).
+
+// The output a stream captures. Capture thread, see "Ownership".
+const output_info &screencopy_stream_output(const capture_stream *s);
+
+// What a stream captures in the compositor's logical space (0 size if the
+// compositor has no xdg-output). Capture thread, see "Ownership"; others
+// take FrameSlot::logical.
+capture_region screencopy_stream_rect(const capture_stream *s);
+
+// Parse "X,Y,WxH" (logical coordinates). False if malformed or empty.
+bool screencopy_parse_region(const char *spec, capture_region *out);
+
+// True if another request can be issued on the stream now (false while
+// its output is unplugged).
+bool screencopy_can_issue(const capture_stream *s, const FrameHandoff &h);
+
+// Issue one capture into a free slot of the stream's handoff. 0 on success.
+int screencopy_issue(capture_stream *s, FrameHandoff &h, bool with_damage);
+
+// Block until Wayland events, a wakeup or the timer, and dispatch whatever
+// arrived. Returns SCREENCOPY_EVENT_* bits, or -1 if the connection is gone.
+int screencopy_wait(screencopy_state *st);
+
+// Fire the timer at deadline_ns (steady clock); 0 disarms it.
+void screencopy_arm_timer(screencopy_state *st, int64_t deadline_ns);
+
+// Wake screencopy_wait() from any thread.
+void screencopy_wake(screencopy_state *st);
+
+// Publish finished requests in issue order (failed ones, and with tile
+// diffing unchanged ones, give their slot back). on_published, if set, sees
+// each one. Returns the number published.
+int screencopy_collect(capture_stream *s, FrameHandoff &h,
+                       void (*on_published)(void *user, const capture_request &req),
+                       void *user);
+
+// Drop everything still in flight on the stream and return the slots.
+void screencopy_abort(capture_stream *s, FrameHandoff &h);
+
+// One capture, start to finish (used for the first frame). 0 on success.
+int screencopy_capture_sync(capture_stream *s, FrameHandoff &h, bool with_damage);
+
+#endif //SCREENCOPY_H
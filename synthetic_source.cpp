@@ -0,0 +1,224 @@
+#include "synthetic_source.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "frame_pacer.h"
+#include "tile_diff.h"
+
+#define SYNTHETIC_BOX_SIZE   256
+#define SYNTHETIC_BOX_STEP   8      // pixels per frame
+#define SYNTHETIC_CELL_W     8
+#define SYNTHETIC_CELL_H     16
+#define SYNTHETIC_KEYS_PER_FRAME 4
+
+static const char *k_patternNames[] = { "full", "box", "typing" };
+
+// ---------------------------------------------------------------------------
+// Drawing (BGRA, 4 bytes per pixel)
+// ---------------------------------------------------------------------------
+
+static void fill_rect(SyntheticSource &s, const FrameRect &r, uint32_t bgra)
+{
+    for (int y = r.y; y < r.y + r.height; ++y) {
+        uint32_t *row = reinterpret_cast<uint32_t *>(s.desktop + (size_t)y * s.stride);
+        for (int x = r.x; x < r.x + r.width; ++x)
+            row[x] = bgra;
+    }
+}
+
+// background: a static gradient the box and glyphs are drawn over
+static void draw_background(SyntheticSource &s, uint32_t shift)
+{
+    for (int y = 0; y < s.height; ++y) {
+        uint32_t *row = reinterpret_cast<uint32_t *>(s.desktop + (size_t)y * s.stride);
+        for (int x = 0; x < s.width; ++x) {
+            uint32_t b = (uint32_t)(x + shift) & 0xff;
+            uint32_t g = (uint32_t)(y + shift) & 0xff;
+            row[x] = 0xff000000u | (0x40u << 16) | (g << 8) | b;
+        }
+    }
+}
+
+static void background_rect(SyntheticSource &s, const FrameRect &r)
+{
+    for (int y = r.y; y < r.y + r.height; ++y) {
+        uint32_t *row = reinterpret_cast<uint32_t *>(s.desktop + (size_t)y * s.stride);
+        for (int x = r.x; x < r.x + r.width; ++x)
+            row[x] = 0xff000000u | (0x40u << 16) | (((uint32_t)y & 0xff) << 8) | ((uint32_t)x & 0xff);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Patterns: update the desktop, report what changed
+// ---------------------------------------------------------------------------
+
+static int step_box(SyntheticSource &s, FrameRect *damage)
+{
+    const int size = SYNTHETIC_BOX_SIZE < s.height ? SYNTHETIC_BOX_SIZE : s.height;
+    const int span = s.width - size > 0 ? s.width - size : 1;
+
+    // bounce left/right, drifting down a little each pass
+    int pos = (int)((s.frame * SYNTHETIC_BOX_STEP) % (uint64_t)(2 * span));
+    FrameRect box;
+    box.x = pos < span ? pos : 2 * span - pos;
+    box.y = (int)((s.frame * SYNTHETIC_BOX_STEP / (uint64_t)(2 * span)) * 16 %
+                  (uint64_t)(s.height - size + 1));
+    box.width = size;
+    box.height = size;
+
+    int n = 0;
+    if (s.lastBox.width) {
+        background_rect(s, s.lastBox);
+        damage[n++] = s.lastBox;
+    }
+    fill_rect(s, box, 0xffe0e0e0u - (uint32_t)(s.frame & 0x3f));
+    damage[n++] = box;
+    s.lastBox = box;
+    return n;
+}
+
+static int step_typing(SyntheticSource &s, FrameRect *damage)
+{
+    const int cols = s.width / SYNTHETIC_CELL_W;
+    const int rows = s.height / SYNTHETIC_CELL_H;
+
+    int n = 0;
+    for (int k = 0; k < SYNTHETIC_KEYS_PER_FRAME && n < FRAME_MAX_DAMAGE_RECTS; ++k) {
+        FrameRect cell;
+        cell.x = s.cursorX * SYNTHETIC_CELL_W;
+        cell.y = s.cursorY * SYNTHETIC_CELL_H;
+        cell.width = SYNTHETIC_CELL_W;
+        cell.height = SYNTHETIC_CELL_H;
+
+        // a "glyph": two bars whose height depends on the key
+        background_rect(s, cell);
+        FrameRect bar = cell;
+        bar.width = 2;
+        bar.height = 4 + (int)((s.frame + (uint64_t)k) % 12);
+        bar.y = cell.y + cell.height - bar.height;
+        fill_rect(s, bar, 0xffffffffu);
+        bar.x += 4;
+        fill_rect(s, bar, 0xffffffffu);
+        damage[n++] = cell;
+
+        if (++s.cursorX >= cols) {
+            s.cursorX = 0;
+            if (++s.cursorY >= rows)
+                s.cursorY = 0;
+        }
+    }
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------------
+
+bool synthetic_source_init(SyntheticSource &s, int width, int height,
+                           SyntheticPattern pattern, int numBuffers)
+{
+    s = SyntheticSource();
+    s.pattern = pattern;
+    s.width = width;
+    s.height = height;
+    s.stride = width * 4;
+
+    const size_t size = (size_t)s.stride * (size_t)height;
+    s.desktop = static_cast<uint8_t *>(std::aligned_alloc(64, size));
+    if (!s.desktop) {
+        std::fprintf(stderr, "synthetic source: out of memory\n");
+        return false;
+    }
+    s.numBuffers = numBuffers < FRAME_HANDOFF_MAX_SLOTS ? numBuffers : FRAME_HANDOFF_MAX_SLOTS;
+    for (int i = 0; i < s.numBuffers; ++i) {
+        s.buffers[i] = static_cast<uint8_t *>(std::aligned_alloc(64, size));
+        if (!s.buffers[i]) {
+            std::fprintf(stderr, "synthetic source: out of memory\n");
+            synthetic_source_destroy(s);
+            return false;
+        }
+    }
+
+    draw_background(s, 0);
+    return true;
+}
+
+void synthetic_source_destroy(SyntheticSource &s)
+{
+    for (int i = 0; i < s.numBuffers; ++i)
+        std::free(s.buffers[i]);
+    std::free(s.desktop);
+    s = SyntheticSource();
+}
+
+int synthetic_source_step(SyntheticSource &s, FrameRect *damage)
+{
+    int n = -1;
+    switch (s.pattern) {
+    case SYNTHETIC_FULL:
+        draw_background(s, (uint32_t)s.frame);
+        break;
+    case SYNTHETIC_BOX:
+        n = step_box(s, damage);
+        break;
+    case SYNTHETIC_TYPING:
+        n = step_typing(s, damage);
+        break;
+    }
+    s.frame++;
+    return n;
+}
+
+bool synthetic_source_frame(SyntheticSource &s, FrameHandoff &h)
+{
+    int slot = handoff_claim(h);
+    if (slot < 0)
+        return false;
+
+    // the moment the "compositor" presents the new content
+    const int64_t presentNs = pacer_now_ns();
+
+    FrameRect damage[FRAME_MAX_DAMAGE_RECTS];
+    const int n = synthetic_source_step(s, damage);
+    const bool fullDamage = n < 0 || !s.reportDamage;
+    const int numDamage = fullDamage ? 0 : n;
+
+    // the screencopy copy: the whole output lands in the slot's buffer
+    std::memcpy(s.buffers[slot], s.desktop, (size_t)s.stride * (size_t)s.height);
+
+    FrameSlot &f = h.slots[slot];
+    f.data   = s.buffers[slot];
+    f.width  = s.width;
+    f.height = s.height;
+    f.stride = s.stride;
+    f.format = s.format;
+    f.presentNs = presentNs;
+    f.readyNs = pacer_now_ns();
+    f.fullDamage = fullDamage;
+    f.numDamage = numDamage;
+    for (int i = 0; i < numDamage; ++i)
+        f.damage[i] = damage[i];
+    if (s.tileDiff && !tile_diff_frame(*s.tileDiff, f))
+        handoff_cancel(h, slot);
+    else
+        handoff_publish(h, slot);
+    return true;
+}
+
+bool synthetic_pattern_from_name(const char *name, SyntheticPattern *out)
+{
+    for (int i = 0; i < (int)(sizeof(k_patternNames) / sizeof(k_patternNames[0])); ++i) {
+        if (std::strcmp(name, k_patternNames[i]) == 0) {
+            *out = (SyntheticPattern)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *synthetic_pattern_name(SyntheticPattern p)
+{
+    return k_patternNames[p];
+}
@@ -0,0 +1,64 @@
+#ifndef SYNTHETIC_SOURCE_H
+#define SYNTHETIC_SOURCE_H
+
+// Synthetic capture source for benchmarking.
+//
+// Stands in for the screencopy engine: it keeps a BGRA "desktop" in memory,
+// changes part of it every frame according to a damage pattern, copies the
+// whole image into a handoff slot like the compositor would and publishes
+// it with the same damage rects and timestamps a real capture carries. The
+// upload and render paths downstream cannot tell the difference.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_handoff.h"
+
+struct TileDiff;
+
+enum SyntheticPattern {
+    SYNTHETIC_FULL = 0,         // every pixel changes, no damage info
+    SYNTHETIC_BOX,              // a box moving across a static background
+    SYNTHETIC_TYPING,           // a few glyph-sized cells per frame
+};
+
+struct SyntheticSource {
+    SyntheticPattern pattern = SYNTHETIC_BOX;
+    int width  = 0;
+    int height = 0;
+    int stride = 0;
+    uint32_t format = 1;        // wl_shm_format frames are labelled with (XRGB8888)
+    bool reportDamage = true;   // false: publish every frame as fully damaged
+    TileDiff *tileDiff = nullptr;   // if set, runs on each frame before publishing
+
+    uint8_t *desktop = nullptr;                         // current content
+    uint8_t *buffers[FRAME_HANDOFF_MAX_SLOTS] = {};     // one per handoff slot
+    int numBuffers = 0;
+
+    uint64_t frame = 0;
+    FrameRect lastBox;
+    int cursorX = 0;
+    int cursorY = 0;
+};
+
+// Allocates the desktop and numBuffers frame buffers (one per handoff slot
+// for synthetic_source_frame, 0 if the caller copies out of desktop itself).
+// Returns false on allocation failure.
+bool synthetic_source_init(SyntheticSource &s, int width, int height,
+                           SyntheticPattern pattern, int numBuffers);
+void synthetic_source_destroy(SyntheticSource &s);
+
+// Advance the desktop by one frame. Writes the changed rects to damage (room
+// for FRAME_MAX_DAMAGE_RECTS) and returns how many, or -1 if every pixel
+// changed.
+int synthetic_source_step(SyntheticSource &s, FrameRect *damage);
+
+// Step, copy into a free slot of h and publish it (unless tileDiff finds it
+// unchanged). False if no slot was free.
+bool synthetic_source_frame(SyntheticSource &s, FrameHandoff &h);
+
+// "full", "box" or "typing"; false if the name is unknown.
+bool synthetic_pattern_from_name(const char *name, SyntheticPattern *out);
+const char *synthetic_pattern_name(SyntheticPattern p);
+
+#endif //SYNTHETIC_SOURCE_H
@@ -0,0 +1,849 @@
+#include "texture_upload.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "gl_util.h"
+#include "pixel_format.h"
+#include "pixel_kernels.h"
+
+// ---------------------------------------------------------------------------
+// Damage rect merging
+// ---------------------------------------------------------------------------
+
+static int64_t rect_area(const FrameRect &r)
+{
+    return (int64_t)r.width * (int64_t)r.height;
+}
+
+static FrameRect rect_union(const FrameRect &a, const FrameRect &b)
+{
+    int x0 = a.x < b.x ? a.x : b.x;
+    int y0 = a.y < b.y ? a.y : b.y;
+    int x1 = (a.x + a.width)  > (b.x + b.width)  ? (a.x + a.width)  : (b.x + b.width);
+    int y1 = (a.y + a.height) > (b.y + b.height) ? (a.y + a.height) : (b.y + b.height);
+
+    FrameRect r;
+    r.x = x0;
+    r.y = y0;
+    r.width  = x1 - x0;
+    r.height = y1 - y0;
+    return r;
+}
+
+static bool rects_near(const FrameRect &a, const FrameRect &b, int d)
+{
+    return a.x - d <= b.x + b.width  && b.x - d <= a.x + a.width &&
+           a.y - d <= b.y + b.height && b.y - d <= a.y + a.height;
+}
+
+int damage_merge(const FrameRect *in, int count,
+                 int frameWidth, int frameHeight,
+                 FrameRect *out, int maxOut, int mergeDistance)
+{
+    FrameRect rects[FRAME_MAX_DAMAGE_RECTS];
+    int n = 0;
+
+    for (int i = 0; i < count && n < FRAME_MAX_DAMAGE_RECTS; ++i) {
+        // clip to the frame
+        int x0 = in[i].x < 0 ? 0 : in[i].x;
+        int y0 = in[i].y < 0 ? 0 : in[i].y;
+        int x1 = in[i].x + in[i].width;
+        int y1 = in[i].y + in[i].height;
+        if (x1 > frameWidth)  x1 = frameWidth;
+        if (y1 > frameHeight) y1 = frameHeight;
+        if (x1 <= x0 || y1 <= y0)
+            continue;
+
+        FrameRect r;
+        r.x = x0;
+        r.y = y0;
+        r.width  = x1 - x0;
+        r.height = y1 - y0;
+
+        // fold into any neighbour, and keep folding while the grown rect
+        // now reaches others
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (int j = 0; j < n; ++j) {
+                if (rects_near(r, rects[j], mergeDistance)) {
+                    r = rect_union(r, rects[j]);
+                    rects[j] = rects[--n];
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        rects[n++] = r;
+    }
+
+    // too many: merge whichever pair wastes the fewest extra texels
+    while (n > maxOut && n > 1) {
+        int bestA = 0, bestB = 1;
+        int64_t bestCost = -1;
+        for (int a = 0; a < n; ++a) {
+            for (int b = a + 1; b < n; ++b) {
+                int64_t cost = rect_area(rect_union(rects[a], rects[b]))
+                             - rect_area(rects[a]) - rect_area(rects[b]);
+                if (bestCost < 0 || cost < bestCost) {
+                    bestCost = cost;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        rects[bestA] = rect_union(rects[bestA], rects[bestB]);
+        rects[bestB] = rects[--n];
+    }
+
+    for (int i = 0; i < n; ++i)
+        out[i] = rects[i];
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// PBO ring
+// ---------------------------------------------------------------------------
+
+static uint64_t now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void desktop_texture_init(DesktopTexture &dt, int pboDepth, int tileSize, MipMode mipmaps)
+{
+    if (pboDepth < 0)
+        pboDepth = 0;
+    if (pboDepth > UPLOAD_MAX_PBOS)
+        pboDepth = UPLOAD_MAX_PBOS;
+
+    // tile edges on whole texels of the smallest mip level (see header)
+    dt.tileBorder = mipmaps != MIP_OFF ? UPLOAD_MIP_BORDER : UPLOAD_TILE_BORDER;
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    dt.maxTileSize = (int)maxSize - 2 * dt.tileBorder;
+    dt.maxTileSize -= dt.maxTileSize % dt.tileBorder;
+    dt.tileSize = tileSize > 0 ? tileSize : UPLOAD_TILE_SIZE;
+    if (dt.tileSize > dt.maxTileSize)
+        dt.tileSize = dt.maxTileSize;
+    dt.tileSize -= dt.tileSize % dt.tileBorder;
+    if (dt.tileSize < dt.tileBorder)
+        dt.tileSize = dt.tileBorder;
+
+    dt.mipmaps = mipmaps;
+    if (mipmaps == MIP_DAMAGE)
+        glGenFramebuffers(2, dt.mipFbo);
+    if (mipmaps != MIP_OFF)
+        glGenQueries(2, dt.mipQuery);
+
+    dt.ring.depth = pboDepth;
+    dt.ring.next = 0;
+    dt.ring.persistent = pboDepth > 0 && gl_has_extension("GL_ARB_buffer_storage");
+    if (pboDepth > 0) {
+        glGenBuffers(pboDepth, dt.ring.pbo);
+        std::fprintf(stderr, "Upload PBO ring: %d buffers (%s)\n", pboDepth,
+                     dt.ring.persistent ? "persistent mapped" : "map per upload");
+    }
+}
+
+// Make sure ring entry i can hold `bytes`. Persistent storage is immutable,
+// so growing it means a new buffer object.
+static void pbo_reserve(PboRing &ring, int i, size_t bytes)
+{
+    if (ring.size[i] >= bytes)
+        return;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.pbo[i]);
+    if (ring.persistent) {
+        if (ring.mapped[i]) {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            ring.mapped[i] = nullptr;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &ring.pbo[i]);
+            glGenBuffers(1, &ring.pbo[i]);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.pbo[i]);
+        }
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, nullptr, flags);
+        ring.mapped[i] = static_cast<uint8_t *>(
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes, flags));
+    } else {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_DRAW);
+    }
+    ring.size[i] = bytes;
+}
+
+// Wait for the GPU to finish reading ring entry i from its last use.
+static void pbo_wait(PboRing &ring, int i, UploadStats &s)
+{
+    if (!ring.fence[i])
+        return;
+
+    GLenum r = glClientWaitSync(ring.fence[i], 0, 0);
+    if (r == GL_TIMEOUT_EXPIRED) {
+        uint64_t t0 = now_ns();
+        glClientWaitSync(ring.fence[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        uint64_t waited = now_ns() - t0;
+        s.fenceWaits++;
+        s.fenceWaitNs += waited;
+        if (waited > s.maxFenceWaitNs)
+            s.maxFenceWaitNs = waited;
+    }
+    glDeleteSync(ring.fence[i]);
+    ring.fence[i] = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Tiles
+// ---------------------------------------------------------------------------
+
+static bool rect_intersect(const FrameRect &a, const FrameRect &b, FrameRect *out)
+{
+    int x0 = a.x > b.x ? a.x : b.x;
+    int y0 = a.y > b.y ? a.y : b.y;
+    int x1 = (a.x + a.width)  < (b.x + b.width)  ? (a.x + a.width)  : (b.x + b.width);
+    int y1 = (a.y + a.height) < (b.y + b.height) ? (a.y + a.height) : (b.y + b.height);
+    if (x1 <= x0 || y1 <= y0)
+        return false;
+
+    out->x = x0;
+    out->y = y0;
+    out->width  = x1 - x0;
+    out->height = y1 - y0;
+    return true;
+}
+
+static void destroy_tiles(DesktopTexture &dt)
+{
+    for (int i = 0; i < dt.numTiles; ++i) {
+        if (dt.tiles[i].tex)
+            glDeleteTextures(1, &dt.tiles[i].tex);
+        dt.tiles[i] = TextureTile();
+    }
+    dt.numTiles = dt.tileCols = dt.tileRows = 0;
+    dt.staleTiles = 0;
+}
+
+// Split a width x height frame into tiles of dt.tileSize, larger ones if that
+// needs more than UPLOAD_MAX_TILES. No storage is allocated yet.
+static bool layout_tiles(DesktopTexture &dt, int width, int height)
+{
+    destroy_tiles(dt);
+
+    int size = dt.tileSize;
+    int cols = (width + size - 1) / size;
+    int rows = (height + size - 1) / size;
+    while (cols * rows > UPLOAD_MAX_TILES && size * 2 <= dt.maxTileSize) {
+        size *= 2;
+        cols = (width + size - 1) / size;
+        rows = (height + size - 1) / size;
+    }
+    if (cols * rows > UPLOAD_MAX_TILES) {
+        std::fprintf(stderr, "Desktop texture: %dx%d needs more than %d tiles of %d px\n",
+                     width, height, UPLOAD_MAX_TILES, size);
+        return false;
+    }
+
+    const FrameRect frame = { 0, 0, width, height };
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            TextureTile &t = dt.tiles[r * cols + c];
+            t.rect.x = c * size;
+            t.rect.y = r * size;
+            t.rect.width  = (c + 1) * size < width  ? size : width  - t.rect.x;
+            t.rect.height = (r + 1) * size < height ? size : height - t.rect.y;
+
+            FrameRect grown = t.rect;
+            grown.x -= dt.tileBorder;
+            grown.y -= dt.tileBorder;
+            grown.width  += 2 * dt.tileBorder;
+            grown.height += 2 * dt.tileBorder;
+            rect_intersect(grown, frame, &t.stored);
+        }
+    }
+    dt.numTiles = cols * rows;
+    dt.tileCols = cols;
+    dt.tileRows = rows;
+    dt.staleTiles = dt.numTiles >= 32 ? ~0u : (1u << dt.numTiles) - 1;
+    return true;
+}
+
+static int mip_size(int base, int level)
+{
+    int s = base >> level;
+    return s > 0 ? s : 1;
+}
+
+static void create_tile_storage(const DesktopTexture &dt, TextureTile &t)
+{
+    // every level the chain can hold down to 1x1, at most UPLOAD_MIP_LEVELS
+    t.levels = 1;
+    if (dt.mipmaps != MIP_OFF) {
+        int big = t.stored.width > t.stored.height ? t.stored.width : t.stored.height;
+        while (t.levels < UPLOAD_MIP_LEVELS && (big >> t.levels) > 0)
+            t.levels++;
+    }
+
+    const PixelFormat &pf = *dt.pixelFormat;
+    glGenTextures(1, &t.tex);
+    glBindTexture(GL_TEXTURE_2D, t.tex);
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, pf.swizzle);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    t.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, t.levels - 1);
+    GLfloat maxAniso = 0.0f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso);
+
+    for (int level = 0; level < t.levels; ++level)
+        glTexImage2D(GL_TEXTURE_2D, level, pf.internalFormat,
+                     mip_size(t.stored.width, level), mip_size(t.stored.height, level),
+                     0, pf.format, pf.type,
+                     nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// Upload
+// ---------------------------------------------------------------------------
+
+#define UPLOAD_MAX_PIECES (UPLOAD_MAX_RECTS * UPLOAD_MAX_TILES)
+
+// A damage rect clipped to one tile's stored area, in frame coordinates.
+struct TilePiece {
+    int tile;
+    FrameRect r;
+};
+
+static void bind_tile_for_piece(const DesktopTexture &dt, const TilePiece &p, int *bound)
+{
+    if (*bound != p.tile) {
+        glBindTexture(GL_TEXTURE_2D, dt.tiles[p.tile].tex);
+        *bound = p.tile;
+    }
+}
+
+// Unpack state that walks rows of the frame at its stride.
+static void unpack_frame_rows(const DesktopTexture &dt)
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, dt.unpackRowLength);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, dt.unpackAlignment);
+}
+
+// ... and rows packed back to back.
+static void unpack_packed_rows()
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+static void upload_pieces_direct(const DesktopTexture &dt, const FrameSlot *frame,
+                                 const TilePiece *pieces, int n)
+{
+    const PixelFormat &pf = *dt.pixelFormat;
+    int bound = -1;
+    unpack_frame_rows(dt);
+    for (int i = 0; i < n; ++i) {
+        const FrameRect &r = pieces[i].r;
+        const FrameRect &st = dt.tiles[pieces[i].tile].stored;
+        const uint8_t *src = frame->data
+                           + (size_t)r.y * (size_t)frame->stride
+                           + (size_t)r.x * (size_t)pf.bytesPerPixel;
+        bind_tile_for_piece(dt, pieces[i], &bound);
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        r.x - st.x, r.y - st.y,
+                        r.width, r.height,
+                        pf.format, pf.type,
+                        src);
+    }
+}
+
+// Copy the pieces into the next PBO and source the texture updates from it.
+// Full-width pieces keep the frame stride (one contiguous copy); narrower
+// ones are packed tightly row by row.
+static void upload_pieces_pbo(DesktopTexture &dt, const FrameSlot *frame,
+                              const TilePiece *pieces, int n)
+{
+    const PixelFormat &pf = *dt.pixelFormat;
+    const size_t bpp = (size_t)pf.bytesPerPixel;
+    PboRing &ring = dt.ring;
+    const int i = ring.next;
+    ring.next = (ring.next + 1) % ring.depth;
+
+    size_t need = 0;
+    for (int k = 0; k < n; ++k) {
+        const FrameRect &r = pieces[k].r;
+        if (r.width == frame->width)
+            need += (size_t)frame->stride * (size_t)r.height;
+        else
+            need += (size_t)r.width * bpp * (size_t)r.height;
+    }
+
+    pbo_wait(ring, i, dt.stats);
+    pbo_reserve(ring, i, need);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.pbo[i]);
+
+    uint8_t *dst = ring.mapped[i];
+    if (!ring.persistent) {
+        dst = static_cast<uint8_t *>(glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)need,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    }
+    if (!dst) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload_pieces_direct(dt, frame, pieces, n);
+        return;
+    }
+
+    size_t offsets[UPLOAD_MAX_PIECES];
+    size_t off = 0;
+    for (int k = 0; k < n; ++k) {
+        const FrameRect &r = pieces[k].r;
+        const uint8_t *src = frame->data
+                           + (size_t)r.y * (size_t)frame->stride
+                           + (size_t)r.x * bpp;
+        offsets[k] = off;
+        if (r.width == frame->width) {
+            size_t bytes = (size_t)frame->stride * (size_t)r.height;
+            std::memcpy(dst + off, src, bytes);
+            off += bytes;
+        } else {
+            size_t row = (size_t)r.width * bpp;
+            pixel_kernels().copy_rows(dst + off, row, src, (size_t)frame->stride, row, r.height);
+            off += row * (size_t)r.height;
+        }
+    }
+
+    if (!ring.persistent)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    int bound = -1;
+    for (int k = 0; k < n; ++k) {
+        const FrameRect &r = pieces[k].r;
+        const FrameRect &st = dt.tiles[pieces[k].tile].stored;
+        bind_tile_for_piece(dt, pieces[k], &bound);
+        if (r.width == frame->width)
+            unpack_frame_rows(dt);
+        else
+            unpack_packed_rows();
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        r.x - st.x, r.y - st.y,
+                        r.width, r.height,
+                        pf.format, pf.type,
+                        reinterpret_cast<const void *>((uintptr_t)offsets[k]));
+    }
+
+    ring.fence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// Clip the merged damage to each tile. Tiles out of view only become stale;
+// visible stale ones are written whole, creating their storage if needed.
+static int split_into_tiles(DesktopTexture &dt, const FrameRect *rects, int n, bool full,
+                            uint32_t visible, TilePiece *pieces)
+{
+    UploadStats &s = dt.stats;
+    int count = 0;
+    for (int t = 0; t < dt.numTiles; ++t) {
+        TextureTile &tile = dt.tiles[t];
+        const uint32_t bit = 1u << t;
+
+        TilePiece mine[UPLOAD_MAX_RECTS];
+        int m = 0;
+        if (full || (dt.staleTiles & bit)) {
+            mine[m].tile = t;
+            mine[m++].r = tile.stored;
+        } else {
+            for (int i = 0; i < n; ++i) {
+                mine[m].tile = t;
+                if (rect_intersect(rects[i], tile.stored, &mine[m].r))
+                    m++;
+            }
+        }
+        if (m == 0)
+            continue;
+
+        if (!(visible & bit)) {
+            if (!(dt.staleTiles & bit))
+                s.deferredTiles++;
+            dt.staleTiles |= bit;
+            continue;
+        }
+        if (dt.staleTiles & bit) {
+            if (!full)
+                s.tileRefreshes++;
+            dt.staleTiles &= ~bit;
+        }
+        if (!tile.tex)
+            create_tile_storage(dt, tile);
+        for (int i = 0; i < m; ++i)
+            pieces[count++] = mine[i];
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Mipmaps
+// ---------------------------------------------------------------------------
+
+// Rebuild level by level the part of tile t's chain below rect (tile-local
+// texels of level 0). Each destination texel is the 2:1 linear blit of the
+// four above it; an odd last row or column of a level is dropped, as the
+// floor-sized level below has no texel for it.
+static void mip_blit_rect(DesktopTexture &dt, const TextureTile &t, FrameRect r)
+{
+    int x0 = r.x, y0 = r.y, x1 = r.x + r.width, y1 = r.y + r.height;
+    for (int level = 1; level < t.levels; ++level) {
+        const int w = mip_size(t.stored.width, level);
+        const int h = mip_size(t.stored.height, level);
+        int dx0 = x0 >> 1, dy0 = y0 >> 1;
+        int dx1 = (x1 + 1) >> 1, dy1 = (y1 + 1) >> 1;
+        if (dx1 > w) dx1 = w;
+        if (dy1 > h) dy1 = h;
+        if (dx1 <= dx0 || dy1 <= dy0)
+            return;
+
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               t.tex, level - 1);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               t.tex, level);
+        glBlitFramebuffer(dx0 * 2, dy0 * 2, dx1 * 2, dy1 * 2,
+                          dx0, dy0, dx1, dy1,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        dt.stats.mipBlits++;
+
+        x0 = dx0; y0 = dy0; x1 = dx1; y1 = dy1;
+    }
+}
+
+// Fold the GPU time of the last rebuild into the stats once it is known
+// (never waits), and say whether the query is free to time this one.
+static bool mip_query_ready(DesktopTexture &dt)
+{
+    if (!dt.mipQuery[0])
+        return false;
+    if (!dt.mipQueryPending)
+        return true;
+
+    GLint available = 0;
+    glGetQueryObjectiv(dt.mipQuery[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 t0 = 0, t1 = 0;
+    glGetQueryObjectui64v(dt.mipQuery[0], GL_QUERY_RESULT, &t0);
+    glGetQueryObjectui64v(dt.mipQuery[1], GL_QUERY_RESULT, &t1);
+    const uint64_t ns = t1 > t0 ? t1 - t0 : 0;
+    dt.stats.mipTimed++;
+    dt.stats.mipGpuNs += ns;
+    if (ns > dt.stats.maxMipGpuNs)
+        dt.stats.maxMipGpuNs = ns;
+    dt.mipQueryPending = false;
+    return true;
+}
+
+// Bring the mip chains of the written tiles up to date. pieces are grouped
+// by tile, in frame coordinates.
+static void update_mipmaps(DesktopTexture &dt, const TilePiece *pieces, int n)
+{
+    if (dt.mipmaps == MIP_OFF || n == 0)
+        return;
+
+    const bool timed = mip_query_ready(dt);
+    if (timed)
+        glQueryCounter(dt.mipQuery[0], GL_TIMESTAMP);
+
+    GLint readFbo = 0, drawFbo = 0;
+    bool fbosBound = false;
+
+    for (int i = 0; i < n; ) {
+        const int t = pieces[i].tile;
+        int end = i;
+        int64_t area = 0;
+        while (end < n && pieces[end].tile == t)
+            area += rect_area(pieces[end++].r);
+
+        TextureTile &tile = dt.tiles[t];
+        if (tile.levels > 1) {
+            if (dt.mipmaps == MIP_FULL ||
+                area * 100 > rect_area(tile.stored) * UPLOAD_FULL_AREA_PCT) {
+                glBindTexture(GL_TEXTURE_2D, tile.tex);
+                glGenerateMipmap(GL_TEXTURE_2D);
+                dt.stats.mipTiles++;
+            } else {
+                if (!fbosBound) {
+                    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFbo);
+                    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFbo);
+                    glBindFramebuffer(GL_READ_FRAMEBUFFER, dt.mipFbo[0]);
+                    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dt.mipFbo[1]);
+                    fbosBound = true;
+                }
+                for (int k = i; k < end; ++k) {
+                    FrameRect r = pieces[k].r;
+                    r.x -= tile.stored.x;
+                    r.y -= tile.stored.y;
+                    mip_blit_rect(dt, tile, r);
+                }
+            }
+        }
+        i = end;
+    }
+
+    if (fbosBound) {
+        // leave no level attached, then restore the caller's framebuffers
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)readFbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)drawFbo);
+    }
+    if (timed) {
+        glQueryCounter(dt.mipQuery[1], GL_TIMESTAMP);
+        dt.mipQueryPending = true;
+    }
+}
+
+void upload_frame_to_texture(DesktopTexture &dt, const FrameSlot *frame, MissedDamage *missed)
+{
+    if (!frame || !frame->data || frame->width == 0 || frame->height == 0)
+        return;
+
+    UploadStats &s = dt.stats;
+
+    // formats GL cannot take as they are would need a CPU pass; not shown
+    const PixelFormat *pf = pixel_format_lookup(frame->format);
+    int rowLength = 0, alignment = 0;
+    if (!pf || !pixel_format_unpack(*pf, frame->stride, &rowLength, &alignment)) {
+        if (frame->format != dt.rejectedFormat) {
+            char name[32];
+            std::fprintf(stderr, "Desktop texture: no GL upload for %s at stride %d, frame dropped\n",
+                         pixel_format_name(frame->format, name), frame->stride);
+            dt.rejectedFormat = frame->format;
+        }
+        s.rejectedFrames++;
+        return;
+    }
+    dt.unpackRowLength = rowLength;
+    dt.unpackAlignment = alignment;
+    s.frames++;
+
+    // a new format needs storage of its internal format, like a new size
+    const bool resized = !dt.initialized || dt.width != frame->width ||
+                         dt.height != frame->height || dt.pixelFormat != pf;
+    // frames up to here are accounted for, the missed ones still to replay
+    const uint64_t lastSeq = missed ? missed->seq : dt.lastSeq;
+    // the frame this texture already accounts for, for tiles that came into view
+    const bool replay = !resized && frame->seq == lastSeq;
+
+    // damage is relative to seq - 1; anything we skipped is unknown
+    bool full = (missed && missed->full) ||
+                (!replay && (frame->fullDamage || frame->seq != lastSeq + 1));
+    uint32_t visible = dt.visibleTiles;
+
+    if (resized) {
+        // fresh objects instead of respecifying the old ones, which draws
+        // still queued against them would otherwise have to drain first
+        if (dt.initialized)
+            s.resizes++;
+        dt.initialized = false;
+        dt.pixelFormat = pf;
+        if (!layout_tiles(dt, frame->width, frame->height))
+            return;
+
+        dt.initialized = true;
+        dt.width  = frame->width;
+        dt.height = frame->height;
+        full = true;
+        // the renderer's mask was for the old grid
+        visible = ~0u;
+    }
+
+    FrameRect rects[UPLOAD_MAX_RECTS];
+    int n = 0;
+    if (!full) {
+        // replay damage this texture missed, then add the frame's own
+        FrameRect all[FRAME_MAX_DAMAGE_RECTS];
+        const int pending = missed ? missed->count : 0;
+        int count = pending;
+        for (int i = 0; i < count; ++i)
+            all[i] = missed->rects[i];
+        const int own = replay ? 0 : frame->numDamage;
+        for (int i = 0; i < own && count < FRAME_MAX_DAMAGE_RECTS; ++i)
+            all[count++] = frame->damage[i];
+        if (pending + own > FRAME_MAX_DAMAGE_RECTS)
+            full = true;
+
+        n = damage_merge(all, count,
+                         frame->width, frame->height,
+                         rects, UPLOAD_MAX_RECTS, UPLOAD_MERGE_DISTANCE);
+
+        int64_t area = 0;
+        for (int i = 0; i < n; ++i)
+            area += rect_area(rects[i]);
+        if (area * 100 > (int64_t)frame->width * frame->height * UPLOAD_FULL_AREA_PCT)
+            full = true;
+    }
+
+    TilePiece pieces[UPLOAD_MAX_PIECES];
+    const int numPieces = split_into_tiles(dt, rects, n, full, visible, pieces);
+
+    if (numPieces > 0 && dt.ring.depth > 0)
+        upload_pieces_pbo(dt, frame, pieces, numPieces);
+    else if (numPieces > 0)
+        upload_pieces_direct(dt, frame, pieces, numPieces);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    update_mipmaps(dt, pieces, numPieces);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    uint64_t bytes = 0;
+    for (int i = 0; i < numPieces; ++i)
+        bytes += (uint64_t)rect_area(pieces[i].r) * (uint64_t)pf->bytesPerPixel;
+    if (full) {
+        s.fullUploads++;
+    } else {
+        s.partialUploads++;
+        s.rects += (uint64_t)numPieces;
+    }
+
+    dt.lastSeq = frame->seq;
+    if (missed) {
+        missed->seq = frame->seq;
+        missed->count = 0;
+        missed->full = false;
+    }
+    dt.presentNs = frame->presentNs;
+    dt.readyNs = frame->readyNs;
+    dt.uploadNs = (int64_t)now_ns();
+    dt.logical = frame->logical;
+    s.lastFrameBytes = bytes;
+    s.bytes += bytes;
+    if (bytes > s.maxFrameBytes)
+        s.maxFrameBytes = bytes;
+}
+
+bool desktop_texture_needs_refresh(const DesktopTexture &dt)
+{
+    return dt.initialized && (dt.staleTiles & dt.visibleTiles) != 0;
+}
+
+void missed_damage_note(MissedDamage &m, const FrameSlot *frame)
+{
+    if (!frame || frame->seq == m.seq)
+        return;     // a replay of a frame already accounted for
+
+    if (frame->fullDamage || frame->seq != m.seq + 1) {
+        m.full = true;
+    } else if (!m.full) {
+        // merge as we go so the list stays short over many frames
+        FrameRect all[FRAME_MAX_DAMAGE_RECTS * 2];
+        int count = 0;
+        for (int i = 0; i < m.count; ++i)
+            all[count++] = m.rects[i];
+        for (int i = 0; i < frame->numDamage; ++i)
+            all[count++] = frame->damage[i];
+        m.count = damage_merge(all, count < FRAME_MAX_DAMAGE_RECTS ? count : FRAME_MAX_DAMAGE_RECTS,
+                               frame->width, frame->height,
+                               m.rects, UPLOAD_MAX_RECTS, UPLOAD_MERGE_DISTANCE);
+        if (count > FRAME_MAX_DAMAGE_RECTS)
+            m.full = true;
+    }
+    m.seq = frame->seq;
+}
+
+void desktop_texture_destroy(DesktopTexture &dt)
+{
+    PboRing &ring = dt.ring;
+    for (int i = 0; i < ring.depth; ++i) {
+        if (ring.fence[i])
+            glDeleteSync(ring.fence[i]);
+        ring.fence[i] = nullptr;
+        if (ring.mapped[i]) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.pbo[i]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            ring.mapped[i] = nullptr;
+        }
+        ring.size[i] = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (ring.depth > 0)
+        glDeleteBuffers(ring.depth, ring.pbo);
+    ring.depth = 0;
+
+    if (dt.mipFbo[0])
+        glDeleteFramebuffers(2, dt.mipFbo);
+    dt.mipFbo[0] = dt.mipFbo[1] = 0;
+    if (dt.mipQuery[0])
+        glDeleteQueries(2, dt.mipQuery);
+    dt.mipQuery[0] = dt.mipQuery[1] = 0;
+    dt.mipQueryPending = false;
+
+    destroy_tiles(dt);
+    dt.initialized = false;
+}
+
+bool parse_mip_mode(const char *s, MipMode *out)
+{
+    static const MipMode modes[] = { MIP_OFF, MIP_FULL, MIP_DAMAGE };
+    for (MipMode m : modes) {
+        if (std::strcmp(s, mip_mode_name(m)) == 0) {
+            *out = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *mip_mode_name(MipMode m)
+{
+    switch (m) {
+    case MIP_OFF:  return "off";
+    case MIP_FULL: return "full";
+    default:       return "damage";
+    }
+}
+
+void print_upload_stats(const UploadStats &s)
+{
+    double avg = s.frames ? (double)s.bytes / (double)s.frames : 0.0;
+    std::fprintf(stderr,
+                 "Uploads: %llu frames (%llu full, %llu partial, %llu rects), "
+                 "%.2f MB total, %.1f KB/frame avg, %.1f KB/frame max\n",
+                 (unsigned long long)s.frames,
+                 (unsigned long long)s.fullUploads,
+                 (unsigned long long)s.partialUploads,
+                 (unsigned long long)s.rects,
+                 (double)s.bytes / (1024.0 * 1024.0),
+                 avg / 1024.0,
+                 (double)s.maxFrameBytes / 1024.0);
+    if (s.resizes)
+        std::fprintf(stderr, "Texture resizes: %llu\n", (unsigned long long)s.resizes);
+    if (s.rejectedFrames)
+        std::fprintf(stderr, "Frames in unsupported formats: %llu\n",
+                     (unsigned long long)s.rejectedFrames);
+    if (s.deferredTiles)
+        std::fprintf(stderr, "Tiles out of view: %llu updates deferred, %llu tiles refreshed on return\n",
+                     (unsigned long long)s.deferredTiles,
+                     (unsigned long long)s.tileRefreshes);
+    if (s.mipTiles || s.mipBlits) {
+        std::fprintf(stderr, "Mipmaps: %llu tiles rebuilt whole, %llu damaged-area blits",
+                     (unsigned long long)s.mipTiles,
+                     (unsigned long long)s.mipBlits);
+        if (s.mipTimed)
+            std::fprintf(stderr, ", GPU %.3f ms avg, %.3f ms max",
+                         (double)s.mipGpuNs / (double)s.mipTimed / 1e6,
+                         (double)s.maxMipGpuNs / 1e6);
+        std::fprintf(stderr, "\n");
+    }
+    if (s.fenceWaits) {
+        std::fprintf(stderr,
+                     "PBO fence waits: %llu, %.3f ms avg, %.3f ms max\n",
+                     (unsigned long long)s.fenceWaits,
+                     (double)s.fenceWaitNs / (double)s.fenceWaits / 1e6,
+                     (double)s.maxFenceWaitNs / 1e6);
+    }
+}
@@ -0,0 +1,200 @@
+#ifndef TEXTURE_UPLOAD_H
+#define TEXTURE_UPLOAD_H
+
+// Desktop texture upload from handoff slots.
+//
+// A frame whose damage is known only uploads the damaged rectangles: nearby
+// rects are merged, the count is capped per frame, and each rect is uploaded
+// with GL_UNPACK_ROW_LENGTH set from the frame stride so it is read straight
+// out of the captured buffer.
+//
+// With a PBO ring the CPU copy goes into a pixel buffer object instead and
+// the texture update is sourced from it, so the driver copy no longer
+// stalls the render thread. Each ring entry is guarded by a fence and is
+// persistently mapped when ARB_buffer_storage is available.
+//
+// The desktop is stored as a grid of tiles, each its own texture no larger
+// than GL_MAX_TEXTURE_SIZE, so captures wider than the driver's limit still
+// fit. Damage is split per tile and only dirty tiles are written. Tiles the
+// renderer reports out of view skip their uploads (and, until first seen,
+// their storage) and are brought up to date whole once they come into view.
+//
+// Each tile keeps a short mip chain for trilinear + anisotropic sampling of a
+// zoomed-out panel. After an upload only the damaged area of each level is
+// rebuilt, by 2:1 linear blits from the level above; a tile whose damage
+// covers most of it is rebuilt with glGenerateMipmap instead. Every chain is
+// built from its own tile alone, so with mipmaps the tiles repeat
+// UPLOAD_MIP_BORDER texels of their neighbours rather than one: that is one
+// whole texel at the smallest level, and tile edges stay on multiples of it,
+// so each level samples across a tile edge like a single texture would.
+//
+// Frames are uploaded in their wl_shm format as captured (see
+// pixel_format.h): the GL format/type pair reads the compositor's bytes
+// directly and a texture swizzle covers X channels, so no frame is
+// converted on the CPU. A frame in another format gets new storage, like
+// one of another size.
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstddef>
+#include <cstdint>
+#include "frame_handoff.h"
+#include "pixel_format.h"
+
+#define UPLOAD_MERGE_DISTANCE 32     // px; rects closer than this are merged
+#define UPLOAD_MAX_RECTS      8      // sub-uploads per frame before merging harder
+#define UPLOAD_FULL_AREA_PCT  50     // merged damage above this % -> one full upload
+#define UPLOAD_MAX_PBOS       8
+#define UPLOAD_DEFAULT_PBOS   3
+#define UPLOAD_TILE_SIZE      2048   // default tile edge, px
+#define UPLOAD_TILE_BORDER    1      // texels each tile repeats from its neighbours
+#define UPLOAD_MAX_TILES      32     // one bit each in the tile masks
+#define UPLOAD_MIP_LEVELS     5      // levels per tile, base included
+#define UPLOAD_MIP_BORDER     (1 << (UPLOAD_MIP_LEVELS - 1))   // ... with mipmaps
+
+enum MipMode {
+    MIP_OFF = 0,                    // level 0 only, bilinear
+    MIP_FULL,                       // glGenerateMipmap on every written tile
+    MIP_DAMAGE,                     // rebuild only the damaged area of each level
+};
+
+struct UploadStats {
+    uint64_t frames = 0;
+    uint64_t fullUploads = 0;
+    uint64_t partialUploads = 0;
+    uint64_t rects = 0;
+    uint64_t bytes = 0;             // total texel bytes handed to GL
+    uint64_t lastFrameBytes = 0;
+    uint64_t maxFrameBytes = 0;
+    uint64_t resizes = 0;           // storage replaced for a new frame size or format
+    uint64_t rejectedFrames = 0;    // formats GL cannot take as they are
+    uint64_t deferredTiles = 0;     // dirty tiles skipped while out of view
+    uint64_t tileRefreshes = 0;     // ... and uploaded whole on coming back
+
+    // mipmap maintenance
+    uint64_t mipTiles = 0;          // tiles whose chain was rebuilt whole
+    uint64_t mipBlits = 0;          // damaged-area blits, one per rect and level
+    uint64_t mipTimed = 0;          // frames with a GPU time below
+    uint64_t mipGpuNs = 0;
+    uint64_t maxMipGpuNs = 0;
+
+    // PBO ring fences
+    uint64_t fenceWaits = 0;        // fences that had not signalled yet
+    uint64_t fenceWaitNs = 0;
+    uint64_t maxFenceWaitNs = 0;
+};
+
+struct PboRing {
+    int depth = 0;                  // 0 = upload from client memory
+    bool persistent = false;
+    int next = 0;
+    GLuint pbo[UPLOAD_MAX_PBOS] = {};
+    GLsync fence[UPLOAD_MAX_PBOS] = {};
+    uint8_t *mapped[UPLOAD_MAX_PBOS] = {};   // persistent mappings
+    size_t size[UPLOAD_MAX_PBOS] = {};
+};
+
+// One tile of a desktop texture. The stored area repeats a border of the
+// neighbouring tiles' texels, so linear filtering across a tile edge samples
+// the same texels a single texture would, at every mip level.
+struct TextureTile {
+    GLuint tex = 0;                 // 0 until the tile is first uploaded
+    int levels = 1;                 // mip levels allocated
+    FrameRect rect;                 // frame area the tile draws
+    FrameRect stored;               // rect plus the border: what tex holds
+};
+
+// For multi-buffered textures: damage from frames that went into another
+// texture since this one was last written. Kept by the uploader next to the
+// texture rather than in it, so noting a frame never writes a texture the
+// renderer may be drawing.
+struct MissedDamage {
+    uint64_t seq = 0;               // newest frame accounted for
+    FrameRect rects[FRAME_MAX_DAMAGE_RECTS];
+    int count = 0;
+    bool full = false;
+};
+
+struct DesktopTexture {
+    bool initialized = false;
+    int width  = 0;
+    int height = 0;
+    uint64_t lastSeq = 0;           // newest frame whose damage is accounted for
+
+    // pixel format of the storage, and unpack state for its frames' stride
+    const PixelFormat *pixelFormat = nullptr;
+    int unpackRowLength = 0;
+    int unpackAlignment = 4;
+    uint32_t rejectedFormat = ~0u;  // last format reported as unsupported
+
+    // timestamps of the frame last uploaded into this texture (steady clock)
+    int64_t presentNs = 0;
+    int64_t readyNs = 0;
+    int64_t uploadNs = 0;
+    FrameRect logical;              // ... and what it shows (FrameSlot::logical)
+
+    // Tile grid of the current frame size. Tiles without their bit in
+    // visibleTiles (set by the renderer) are not written; staleTiles marks
+    // the ones whose content is older than lastSeq.
+    int tileSize = UPLOAD_TILE_SIZE;    // a multiple of tileBorder
+    int tileBorder = UPLOAD_TILE_BORDER;
+    int maxTileSize = 0;            // GL_MAX_TEXTURE_SIZE less the borders
+    TextureTile tiles[UPLOAD_MAX_TILES];
+    int numTiles = 0;
+    int tileCols = 0;
+    int tileRows = 0;
+    uint32_t visibleTiles = ~0u;
+    uint32_t staleTiles = 0;
+
+    // mip rebuilds: read/draw framebuffers for the blits and GPU timestamps
+    // taken before and after
+    MipMode mipmaps = MIP_DAMAGE;
+    GLuint mipFbo[2] = {};
+    GLuint mipQuery[2] = {};
+    bool mipQueryPending = false;
+
+    PboRing ring;
+    UploadStats stats;
+};
+
+// Needs a current GL context. depth 0 keeps uploads from client memory;
+// tileSize 0 picks UPLOAD_TILE_SIZE (either way capped by the driver).
+void desktop_texture_init(DesktopTexture &dt, int pboDepth, int tileSize, MipMode mipmaps);
+
+// "off", "full" or "damage"; false for anything else.
+bool parse_mip_mode(const char *s, MipMode *out);
+const char *mip_mode_name(MipMode m);
+
+// Clip the rects to the frame, merge ones within mergeDistance of each other
+// and keep merging the cheapest pairs until at most maxOut remain.
+// Returns the number of rects written to out.
+int damage_merge(const FrameRect *in, int count,
+                 int frameWidth, int frameHeight,
+                 FrameRect *out, int maxOut, int mergeDistance);
+
+// Create the tiles on first use, then upload the frame's damage
+// (or the whole frame when damage is unknown or frames were skipped) to the
+// visible tiles. A frame of another size gets new texture objects; the old
+// ones are released once the GPU is done sampling them, so nothing waits.
+// Passing the frame dt already holds again only brings stale tiles that are
+// now visible up to date. missed (nullptr if dt is the only texture) is the
+// damage dt has not seen yet; it is replayed here and cleared.
+void upload_frame_to_texture(DesktopTexture &dt, const FrameSlot *frame, MissedDamage *missed);
+
+// True when a visible tile is stale, i.e. re-uploading the current frame
+// would change what is drawn.
+bool desktop_texture_needs_refresh(const DesktopTexture &dt);
+
+// Record that `frame` was uploaded to another texture, so its damage is
+// replayed the next time the one m belongs to is written.
+void missed_damage_note(MissedDamage &m, const FrameSlot *frame);
+
+void desktop_texture_destroy(DesktopTexture &dt);
+
+void print_upload_stats(const UploadStats &s);
+
+#endif //TEXTURE_UPLOAD_H
@@ -0,0 +1,299 @@
+#include "tile_diff.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "pixel_format.h"
+#include "pixel_kernels.h"
+
+static int64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------
+// Hashing, one band of tile rows at a time
+// ---------------------------------------------------------------------------
+
+static void hash_band(TileDiffPool &pool, int band)
+{
+    TileDiff &td = *pool.job;
+    const FrameSlot &f = *pool.frame;
+    const PixelKernels &k = pixel_kernels();
+    const int bpp = pool.bytesPerPixel;
+    const int y0 = band * TILE_DIFF_TILE_SIZE;
+    const int rows = std::min(TILE_DIFF_TILE_SIZE, f.height - y0);
+    const uint8_t *line = f.data + (size_t)y0 * (size_t)f.stride;
+
+    for (int c = 0; c < td.cols; ++c) {
+        const int i = band * td.cols + c;
+        if (!td.rehash[i])
+            continue;
+        const int x0 = c * TILE_DIFF_TILE_SIZE;
+        const int w = std::min(TILE_DIFF_TILE_SIZE, f.width - x0);
+        const uint64_t h = k.tile_hash(line + (size_t)x0 * bpp, (size_t)f.stride,
+                                       (size_t)w * bpp, rows);
+        td.dirty[i] = h != td.hashes[i];
+        td.hashes[i] = h;
+    }
+}
+
+static void run_bands(TileDiffPool &pool)
+{
+    const int bands = pool.job->rows;
+    int band;
+    while ((band = pool.nextBand.fetch_add(1)) < bands)
+        hash_band(pool, band);
+}
+
+static void worker_func(TileDiffPool *pool)
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(pool->lock);
+    for (;;) {
+        pool->wake.wait(lock, [&] { return pool->quit || pool->generation != seen; });
+        if (pool->quit)
+            return;
+        seen = pool->generation;
+
+        lock.unlock();
+        run_bands(*pool);
+        lock.lock();
+        if (--pool->busy == 0)
+            pool->done.notify_one();
+    }
+}
+
+// Hash every tile marked in td.rehash, on the pool and the calling thread.
+static void hash_tiles(TileDiffPool &pool, TileDiff &td, const FrameSlot &f, int bytesPerPixel)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        pool.job = &td;
+        pool.frame = &f;
+        pool.bytesPerPixel = bytesPerPixel;
+        pool.nextBand.store(0);
+        pool.busy = (int)pool.workers.size();
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+
+    run_bands(pool);
+
+    // every worker has to check in, so none is still reading f afterwards
+    std::unique_lock<std::mutex> lock(pool.lock);
+    pool.done.wait(lock, [&] { return pool.busy == 0; });
+    pool.job = nullptr;
+    pool.frame = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Dirty tiles -> damage rects
+// ---------------------------------------------------------------------------
+
+// Adds tile columns [c0, c1) of band to rects: grows a rect of the same
+// columns that ends at this band, else starts a new one. False if full.
+static bool add_span(FrameRect *rects, int *n, int c0, int c1, int band)
+{
+    const int x = c0 * TILE_DIFF_TILE_SIZE;
+    const int w = (c1 - c0) * TILE_DIFF_TILE_SIZE;
+    const int y = band * TILE_DIFF_TILE_SIZE;
+    for (int i = 0; i < *n; ++i) {
+        FrameRect &r = rects[i];
+        if (r.x == x && r.width == w && r.y + r.height == y) {
+            r.height += TILE_DIFF_TILE_SIZE;
+            return true;
+        }
+    }
+    if (*n == FRAME_MAX_DAMAGE_RECTS)
+        return false;
+    rects[(*n)++] = FrameRect{x, y, w, TILE_DIFF_TILE_SIZE};
+    return true;
+}
+
+// Every run of dirty tiles in a band, merged down the bands where the runs
+// line up; if that takes too many rects, one span per band from its first
+// to its last dirty tile, and failing that their bounding box.
+static int tiles_to_rects(const TileDiff &td, FrameRect *rects)
+{
+    int n = 0;
+    bool fits = true;
+    for (int b = 0; b < td.rows && fits; ++b) {
+        const uint8_t *row = &td.dirty[(size_t)b * td.cols];
+        for (int c = 0; c < td.cols && fits; ) {
+            if (!row[c]) {
+                ++c;
+                continue;
+            }
+            int end = c + 1;
+            while (end < td.cols && row[end])
+                ++end;
+            fits = add_span(rects, &n, c, end, b);
+            c = end;
+        }
+    }
+    if (fits)
+        return n;
+
+    n = 0;
+    fits = true;
+    int minCol = td.cols, maxCol = 0, minBand = td.rows, maxBand = 0;
+    for (int b = 0; b < td.rows; ++b) {
+        const uint8_t *row = &td.dirty[(size_t)b * td.cols];
+        int first = -1, last = -1;
+        for (int c = 0; c < td.cols; ++c) {
+            if (row[c]) {
+                if (first < 0)
+                    first = c;
+                last = c;
+            }
+        }
+        if (first < 0)
+            continue;
+        if (fits)
+            fits = add_span(rects, &n, first, last + 1, b);
+        minCol = std::min(minCol, first);
+        maxCol = std::max(maxCol, last + 1);
+        minBand = std::min(minBand, b);
+        maxBand = std::max(maxBand, b + 1);
+    }
+    if (fits)
+        return n;
+
+    rects[0] = FrameRect{minCol * TILE_DIFF_TILE_SIZE, minBand * TILE_DIFF_TILE_SIZE,
+                         (maxCol - minCol) * TILE_DIFF_TILE_SIZE,
+                         (maxBand - minBand) * TILE_DIFF_TILE_SIZE};
+    return 1;
+}
+
+static bool covers_frame(const FrameSlot &f)
+{
+    for (int i = 0; i < f.numDamage; ++i) {
+        const FrameRect &r = f.damage[i];
+        if (r.x <= 0 && r.y <= 0 && r.x + r.width >= f.width && r.y + r.height >= f.height)
+            return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+void tile_diff_pool_start(TileDiffPool &pool, int threads)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    const int workers = std::max(0, std::min(threads - 1, TILE_DIFF_MAX_WORKERS));
+    pool.quit = false;
+    for (int i = 0; i < workers; ++i)
+        pool.workers.emplace_back(worker_func, &pool);
+}
+
+void tile_diff_pool_stop(TileDiffPool &pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        pool.quit = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread &t : pool.workers)
+        t.join();
+    pool.workers.clear();
+}
+
+TileDiffPool::~TileDiffPool()
+{
+    tile_diff_pool_stop(*this);
+}
+
+bool tile_diff_frame(TileDiff &td, FrameSlot &f)
+{
+    if (!td.pool || !f.data || f.width <= 0 || f.height <= 0)
+        return true;
+    const int64_t startNs = steady_ns();
+
+    const PixelFormat *pf = pixel_format_lookup(f.format);
+    const int bpp = pf ? pf->bytesPerPixel : 4;
+
+    // new size or format: nothing to compare with
+    const bool fresh = td.hashes.empty() || f.width != td.width ||
+                       f.height != td.height || f.format != td.format;
+    if (fresh) {
+        td.width = f.width;
+        td.height = f.height;
+        td.format = f.format;
+        td.cols = (f.width + TILE_DIFF_TILE_SIZE - 1) / TILE_DIFF_TILE_SIZE;
+        td.rows = (f.height + TILE_DIFF_TILE_SIZE - 1) / TILE_DIFF_TILE_SIZE;
+        const size_t n = (size_t)td.cols * td.rows;
+        td.hashes.assign(n, 0);
+        td.rehash.assign(n, 1);
+        td.dirty.assign(n, 0);
+    }
+
+    const bool full = f.fullDamage || covers_frame(f);
+    if (full || fresh) {
+        std::fill(td.rehash.begin(), td.rehash.end(), 1);
+    } else {
+        // trust the compositor; only keep the hashes under its damage current
+        std::fill(td.rehash.begin(), td.rehash.end(), 0);
+        for (int i = 0; i < f.numDamage; ++i) {
+            const FrameRect &r = f.damage[i];
+            const int c0 = std::max(0, r.x / TILE_DIFF_TILE_SIZE);
+            const int r0 = std::max(0, r.y / TILE_DIFF_TILE_SIZE);
+            const int c1 = std::min(td.cols, (r.x + r.width + TILE_DIFF_TILE_SIZE - 1) / TILE_DIFF_TILE_SIZE);
+            const int r1 = std::min(td.rows, (r.y + r.height + TILE_DIFF_TILE_SIZE - 1) / TILE_DIFF_TILE_SIZE);
+            for (int b = r0; b < r1; ++b)
+                for (int c = c0; c < c1; ++c)
+                    td.rehash[(size_t)b * td.cols + c] = 1;
+        }
+    }
+
+    hash_tiles(*td.pool, td, f, bpp);
+
+    uint64_t hashed = 0, dirty = 0;
+    for (size_t i = 0; i < td.rehash.size(); ++i) {
+        hashed += td.rehash[i];
+        dirty += td.rehash[i] & td.dirty[i];
+    }
+    td.framesHashed++;
+    td.tilesHashed += hashed;
+    td.tilesDirty += fresh ? hashed : dirty;
+    td.hashNs += steady_ns() - startNs;
+
+    if (fresh) {
+        f.fullDamage = true;
+        f.numDamage = 0;
+        return true;
+    }
+    if (!full)
+        return true;
+    if (dirty == 0) {
+        td.unchangedFrames++;
+        return false;
+    }
+
+    // the rects are tile-aligned; clip the right and bottom edge tiles
+    f.numDamage = tiles_to_rects(td, f.damage);
+    for (int i = 0; i < f.numDamage; ++i) {
+        FrameRect &r = f.damage[i];
+        r.width = std::min(r.width, f.width - r.x);
+        r.height = std::min(r.height, f.height - r.y);
+    }
+    f.fullDamage = false;
+    return true;
+}
+
+void print_tile_diff_stats(const TileDiff &td)
+{
+    if (!td.framesHashed)
+        return;
+    std::fprintf(stderr, "Tile diff: %llu frames hashed, %llu unchanged and dropped, "
+                 "%.1f%% of hashed tiles dirty, %.2f ms per frame\n",
+                 (unsigned long long)td.framesHashed,
+                 (unsigned long long)td.unchangedFrames,
+                 td.tilesHashed ? 100.0 * (double)td.tilesDirty / (double)td.tilesHashed : 0.0,
+                 (double)td.hashNs / 1e6 / (double)td.framesHashed);
+}
@@ -0,0 +1,86 @@
+#ifndef TILE_DIFF_H
+#define TILE_DIFF_H
+
+// CPU damage tracking for compositors that report none.
+//
+// Some compositors send full-frame damage with every frame, or cannot do
+// copy_with_damage at all. With tile diffing on, the capture side hashes
+// each new frame in TILE_DIFF_TILE_SIZE tiles (pixel_kernels().tile_hash),
+// compares the hashes with those of the last published frame and replaces
+// the full damage with the tiles that changed. A frame where nothing changed
+// is not published at all, so the upload and mip paths never see it.
+//
+// Frames that do carry compositor damage are trusted as they are; only the
+// tiles under their rects are rehashed, to keep the hashes current.
+//
+// Hashing is split into bands of tile rows shared between the calling
+// (capture) thread and a small worker pool; the pool is shared by all
+// captured outputs.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_handoff.h"
+
+#define TILE_DIFF_TILE_SIZE   64
+#define TILE_DIFF_MAX_WORKERS 8
+
+struct TileDiffPool;
+
+// Per captured output: the hashes of the last published frame.
+struct TileDiff {
+    TileDiffPool *pool = nullptr;       // nullptr = tile diffing off
+
+    int width = 0;                      // frame the hashes belong to
+    int height = 0;
+    uint32_t format = 0;
+    int cols = 0;
+    int rows = 0;
+    std::vector<uint64_t> hashes;
+    std::vector<uint8_t> rehash;        // tiles to hash this frame
+    std::vector<uint8_t> dirty;         // ... and those that changed
+
+    // capture thread only; read them after it has stopped
+    uint64_t framesHashed = 0;
+    uint64_t unchangedFrames = 0;       // not published
+    uint64_t tilesHashed = 0;
+    uint64_t tilesDirty = 0;
+    int64_t hashNs = 0;
+};
+
+struct TileDiffPool {
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool quit = false;
+    uint64_t generation = 0;            // bumped per frame handed out
+    int busy = 0;                       // workers still on this frame
+
+    // the frame being hashed
+    TileDiff *job = nullptr;
+    const FrameSlot *frame = nullptr;
+    int bytesPerPixel = 4;
+    std::atomic<int> nextBand{0};
+
+    // stops the workers if nobody did, so an early exit does not abort
+    ~TileDiffPool();
+};
+
+// threads: hashing threads including the caller (0 = one per core, up to
+// TILE_DIFF_MAX_WORKERS + 1).
+void tile_diff_pool_start(TileDiffPool &pool, int threads);
+void tile_diff_pool_stop(TileDiffPool &pool);
+
+// Hash f and, if it carries full damage, replace that with the tiles that
+// changed since the last frame that went through here. Returns false if
+// nothing changed: the caller should not publish the frame.
+bool tile_diff_frame(TileDiff &td, FrameSlot &f);
+
+void print_tile_diff_stats(const TileDiff &td);
+
+#endif //TILE_DIFF_H
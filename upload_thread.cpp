@@ -0,0 +1,222 @@
+#include "upload_thread.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+static const uint32_t UPLOAD_FRESH = 0x80000000u;
+static const uint32_t UPLOAD_NEW_FRAME = 0x40000000u;    // ... holding a capture not shown yet
+
+// The back texture has a stale tile that is now in view.
+static bool refresh_wanted(const UploadThread *ut)
+{
+    const DesktopTexture &back = ut->tex[ut->back];
+    return ut->current && back.initialized &&
+           (back.staleTiles & ut->visibleTiles.load(std::memory_order_relaxed)) != 0;
+}
+
+static void upload_thread_func(UploadThread *ut)
+{
+    if (!ut->make_current(ut->user)) {
+        std::fprintf(stderr, "Upload thread: unable to make GL context current\n");
+        ut->running.store(false);
+        ut->initState.store(-1);
+        return;
+    }
+
+    // split the PBO budget between the two textures
+    int perTexture = (ut->pboDepth + 1) / 2;
+    desktop_texture_init(ut->tex[0], perTexture, ut->tileSize, ut->mipmaps);
+    desktop_texture_init(ut->tex[1], perTexture, ut->tileSize, ut->mipmaps);
+    ut->initState.store(1);
+
+    FrameHandoff &h = *ut->handoff;
+
+    while (ut->running.load()) {
+        // sleep until there is both a new frame (or tiles to catch up) and a
+        // texture to put it in; the renderer pokes the same condition when it
+        // frees a texture or the view changes
+        {
+            std::unique_lock<std::mutex> lock(h.waitLock);
+            h.waitCond.wait_for(lock, std::chrono::milliseconds(100), [ut, &h] {
+                return !ut->running.load() ||
+                       (ut->backFree.load(std::memory_order_acquire) &&
+                        (handoff_pending(h) || refresh_wanted(ut)));
+            });
+        }
+        if (!ut->running.load() || !ut->backFree.load(std::memory_order_acquire))
+            continue;
+
+        // the acquired slot stays ours until the next acquire, so the
+        // current frame can be uploaded again for tiles that come into view
+        const FrameSlot *frame = handoff_acquire(h);
+        const bool newFrame = frame != nullptr;
+        if (frame)
+            ut->current = frame;
+        else if (refresh_wanted(ut))
+            frame = ut->current;
+        else
+            continue;
+
+        const int b = ut->back;
+        if (ut->released[b]) {
+            glWaitSync(ut->released[b], 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(ut->released[b]);
+            ut->released[b] = nullptr;
+        }
+
+        ut->tex[b].visibleTiles = ut->visibleTiles.load(std::memory_order_relaxed);
+        upload_frame_to_texture(ut->tex[b], frame, &ut->missed[b]);
+        missed_damage_note(ut->missed[1 - b], frame);
+
+        ut->ready[b] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();   // the fence must reach the GPU before another context waits on it
+
+        ut->backFree.store(false, std::memory_order_relaxed);
+        ut->published.store((uint32_t)b | UPLOAD_FRESH | (newFrame ? UPLOAD_NEW_FRAME : 0),
+                            std::memory_order_release);
+        ut->back = 1 - b;
+        ut->uploads.fetch_add(1, std::memory_order_relaxed);
+        ut->uploadBytes.fetch_add(ut->tex[b].stats.lastFrameBytes, std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (ut->ready[i])
+            glDeleteSync(ut->ready[i]);
+        if (ut->released[i])
+            glDeleteSync(ut->released[i]);
+        ut->ready[i] = ut->released[i] = nullptr;
+        desktop_texture_destroy(ut->tex[i]);
+    }
+    glFinish();
+    ut->release_current(ut->user);
+}
+
+bool upload_thread_start(UploadThread &ut, FrameHandoff &h, int pboDepth, int tileSize,
+                         MipMode mipmaps,
+                         bool (*make_current)(void *user),
+                         void (*release_current)(void *user),
+                         void *user)
+{
+    ut.handoff = &h;
+    ut.current = nullptr;
+    ut.pboDepth = pboDepth;
+    ut.tileSize = tileSize;
+    ut.mipmaps = mipmaps;
+    ut.make_current = make_current;
+    ut.release_current = release_current;
+    ut.user = user;
+    ut.back = 0;
+    ut.missed[0] = ut.missed[1] = MissedDamage();
+    ut.front = -1;
+    ut.frontFrames = 0;
+    ut.backHeld = false;
+    ut.published.store(0);
+    ut.backFree.store(true);
+    ut.visibleTiles.store(~0u);
+    ut.initState.store(0);
+    ut.running.store(true);
+    ut.thread = std::thread(upload_thread_func, &ut);
+
+    while (ut.initState.load() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (ut.initState.load() < 0) {
+        ut.thread.join();
+        return false;
+    }
+    return true;
+}
+
+void upload_thread_stop(UploadThread &ut)
+{
+    ut.running.store(false);
+    if (ut.handoff)
+        handoff_wake(*ut.handoff);
+    if (ut.thread.joinable())
+        ut.thread.join();
+    ut.front = -1;
+}
+
+// Render thread: tex[idx] (none if -1) may be written again once the draws
+// queued against it are done.
+static void release_back(UploadThread &ut, int idx)
+{
+    if (idx >= 0) {
+        ut.released[idx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+    }
+    ut.backFree.store(true, std::memory_order_release);
+    handoff_wake(*ut.handoff);
+}
+
+const DesktopTexture *upload_thread_front(UploadThread &ut)
+{
+    uint32_t p = ut.published.load(std::memory_order_acquire);
+    if (p & UPLOAD_FRESH) {
+        const int idx = (int)(p & 1u);
+        if (p & UPLOAD_NEW_FRAME)
+            ut.frontFrames++;
+
+        // the upload thread will not publish again until backFree is set
+        ut.published.store((uint32_t)idx, std::memory_order_relaxed);
+
+        glWaitSync(ut.ready[idx], 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(ut.ready[idx]);
+        ut.ready[idx] = nullptr;
+
+        const int old = ut.front;
+        ut.front = idx;
+        if (old >= 0 && ut.holdBack)
+            ut.backHeld = true;
+        else
+            release_back(ut, old);
+    }
+    return ut.front >= 0 ? &ut.tex[ut.front] : nullptr;
+}
+
+const DesktopTexture *upload_thread_held(const UploadThread &ut)
+{
+    return ut.backHeld ? &ut.tex[1 - ut.front] : nullptr;
+}
+
+void upload_thread_release_back(UploadThread &ut)
+{
+    if (!ut.backHeld)
+        return;
+    ut.backHeld = false;
+    release_back(ut, 1 - ut.front);
+}
+
+void upload_thread_set_visible(UploadThread &ut, uint32_t visibleTiles)
+{
+    if (ut.visibleTiles.exchange(visibleTiles, std::memory_order_relaxed) != visibleTiles)
+        handoff_wake(*ut.handoff);
+}
+
+UploadStats upload_thread_stats(const UploadThread &ut)
+{
+    UploadStats s = ut.tex[0].stats;
+    const UploadStats &o = ut.tex[1].stats;
+    s.frames         += o.frames;
+    s.fullUploads    += o.fullUploads;
+    s.partialUploads += o.partialUploads;
+    s.rects          += o.rects;
+    s.bytes          += o.bytes;
+    s.resizes        += o.resizes;
+    s.rejectedFrames += o.rejectedFrames;
+    s.deferredTiles  += o.deferredTiles;
+    s.tileRefreshes  += o.tileRefreshes;
+    s.mipTiles       += o.mipTiles;
+    s.mipBlits       += o.mipBlits;
+    s.mipTimed       += o.mipTimed;
+    s.mipGpuNs       += o.mipGpuNs;
+    if (o.maxMipGpuNs > s.maxMipGpuNs)
+        s.maxMipGpuNs = o.maxMipGpuNs;
+    s.fenceWaits     += o.fenceWaits;
+    s.fenceWaitNs    += o.fenceWaitNs;
+    if (o.maxFrameBytes > s.maxFrameBytes)
+        s.maxFrameBytes = o.maxFrameBytes;
+    if (o.maxFenceWaitNs > s.maxFenceWaitNs)
+        s.maxFenceWaitNs = o.maxFenceWaitNs;
+    return s;
+}
@@ -0,0 +1,94 @@
+#ifndef UPLOAD_THREAD_H
+#define UPLOAD_THREAD_H
+
+// Texture upload on its own thread and GL context.
+//
+// The thread owns a context shared with the renderer. It takes frames from
+// the capture handoff and uploads them into whichever of two desktop
+// textures the renderer is not sampling, then publishes that texture with a
+// fence. The renderer waits on the fence on the GPU (never the CPU) and
+// hands the previous texture back with a fence of its own, so neither
+// context can touch a texture the other still has commands queued against.
+//
+// A texture handed to a compositor that samples it on its own schedule (an
+// overlay) can be held: the renderer then gives the previous texture back
+// only once the compositor has moved on from it.
+//
+// The renderer reports which tiles are in view; when a tile the textures
+// skipped comes back into view the thread re-uploads it from the frame it
+// still holds, without waiting for the desktop to change.
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "frame_handoff.h"
+#include "texture_upload.h"
+
+struct UploadThread {
+    DesktopTexture tex[2];
+    GLsync ready[2] = {};       // upload -> render: tex[i] fully written
+    GLsync released[2] = {};    // render -> upload: last draw from tex[i] queued before this
+
+    std::atomic<uint32_t> published{0};     // index | fresh bit
+    std::atomic<bool> backFree{true};       // renderer has let go of the other texture
+    std::atomic<uint32_t> visibleTiles{~0u};
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> uploads{0};
+    std::atomic<uint64_t> uploadBytes{0};   // live copy of stats.bytes for the HUD
+    std::atomic<int> initState{0};          // 1 = context current, -1 = failed
+
+    int back = 0;               // upload thread
+    MissedDamage missed[2];     // ... and damage tex[i] has not seen: kept here, since
+                                // only tex[back] is ever written by the thread
+    int front = -1;             // render thread
+    uint64_t frontFrames = 0;   // ... swaps to a texture with a new capture
+    bool holdBack = false;      // ... set before starting: swaps keep the old front
+    bool backHeld = false;      // ... until upload_thread_release_back
+
+    FrameHandoff *handoff = nullptr;
+    const FrameSlot *current = nullptr;     // upload thread: last acquired frame
+    int pboDepth = 0;
+    int tileSize = 0;
+    MipMode mipmaps = MIP_DAMAGE;
+
+    // make the upload context current on the calling thread / release it
+    bool (*make_current)(void *user) = nullptr;
+    void (*release_current)(void *user) = nullptr;
+    void *user = nullptr;
+
+    std::thread thread;
+};
+
+// Starts the thread, which makes its context current itself. Returns false
+// (with no thread left running) if that fails.
+bool upload_thread_start(UploadThread &ut, FrameHandoff &h, int pboDepth, int tileSize,
+                         MipMode mipmaps,
+                         bool (*make_current)(void *user),
+                         void (*release_current)(void *user),
+                         void *user);
+
+// Stops the thread and frees its GL objects (inside the upload context).
+void upload_thread_stop(UploadThread &ut);
+
+// Render thread, once per frame: switch to the newest uploaded texture if
+// there is one. Returns the texture to draw, or nullptr before the first
+// upload has landed. A switch to a new capture (not a tile refresh of the
+// one shown) bumps ut.frontFrames.
+const DesktopTexture *upload_thread_front(UploadThread &ut);
+
+// Render thread, with holdBack: the texture shown before the last swap,
+// still out of the upload rotation, or nullptr.
+const DesktopTexture *upload_thread_held(const UploadThread &ut);
+
+// Render thread, with holdBack: nothing reads the held texture any more,
+// hand it back to the upload thread.
+void upload_thread_release_back(UploadThread &ut);
+
+// Render thread: the desktop tiles currently in view (all by default).
+void upload_thread_set_visible(UploadThread &ut, uint32_t visibleTiles);
+
+// Combined upload stats of both textures.
+UploadStats upload_thread_stats(const UploadThread &ut);
+
+#endif //UPLOAD_THREAD_H
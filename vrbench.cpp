@@ -0,0 +1,687 @@
+// vrbench.cpp
+// Headless benchmark of the frame path: synthetic capture -> handoff ->
+// texture upload -> stereo render -> null eye submit.
+// - Runs on an offscreen EGL context (Mesa llvmpipe or any driver with
+//   EGL_MESA_platform_surfaceless); no compositor, window or headset.
+// - Prints capture / upload / render throughput and latency percentiles,
+//   plus one key=value summary line on stdout for CI to track.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "frame_handoff.h"
+#include "pixel_format.h"
+#include "synthetic_source.h"
+#include "tile_diff.h"
+#include "texture_upload.h"
+#include "upload_thread.h"
+#include "renderer.h"
+#include "frame_pacer.h"
+#include "latency.h"
+#include "cursor_layer.h"
+
+#define BENCH_DEFAULT_SECONDS  5.0f
+#define BENCH_DEFAULT_FPS      60.0f
+#define BENCH_DEFAULT_REFRESH  90.0f
+#define BENCH_HANDOFF_SLOTS    4        // in flight + the two the handoff parks
+#define BENCH_PANEL_DISTANCE   1.5f
+#define BENCH_CURSOR_HZ        1000.0f  // a gaming mouse's report rate
+#define BENCH_CURSOR_SIZE      24
+#define BENCH_EYE_SEPARATION   0.064f
+#define BENCH_UNSHOWN_FRAMES   2        // uploading + published, not swapped in yet
+#define BENCH_FRESH_TOLERANCE  0.25     // --compare-upload: allowed fresh fps difference
+
+struct BenchOptions {
+    int width = 1920;
+    int height = 1080;
+    SyntheticPattern pattern = SYNTHETIC_BOX;
+    float captureFps = BENCH_DEFAULT_FPS;       // 0 = as fast as slots free up
+    float refreshHz = BENCH_DEFAULT_REFRESH;    // 0 = render unpaced
+    float seconds = BENCH_DEFAULT_SECONDS;
+    int eyeWidth = 1440;
+    int eyeHeight = 1600;
+    int pboRingDepth = UPLOAD_DEFAULT_PBOS;
+    bool uploadThread = true;
+    bool singlePass = true;
+    bool curved = false;
+    int tileSize = 0;                           // 0 = UPLOAD_TILE_SIZE
+    float yawDegrees = 0.0f;                    // head turned away from the panel
+    MipMode mipmaps = MIP_DAMAGE;
+    const PixelFormat *format = pixel_format_lookup(SHM_FORMAT_XRGB8888);
+    bool reportDamage = true;
+    bool tileDiff = false;
+    bool cursor = false;
+    bool compareUpload = false;                 // run inline, then threaded
+};
+
+struct BenchResult {
+    bool threaded = false;
+    double freshFps = 0.0;
+};
+
+// capture thread -> render loop
+static FrameHandoff g_frameHandoff;
+static FramePacer g_framePacer;
+static std::atomic<bool> g_captureRunning{false};
+static std::atomic<bool> g_cursorRunning{false};
+
+// ----------------------------------------------------------------------
+// Offscreen EGL contexts (main + shared upload context)
+// ----------------------------------------------------------------------
+
+struct BenchContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext main = EGL_NO_CONTEXT;
+    EGLContext upload = EGL_NO_CONTEXT;
+};
+
+static EGLDisplay open_display()
+{
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                          EGL_DEFAULT_DISPLAY, nullptr);
+        if (d != EGL_NO_DISPLAY && eglInitialize(d, nullptr, nullptr))
+            return d;
+    }
+
+    EGLDisplay d = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (d != EGL_NO_DISPLAY && eglInitialize(d, nullptr, nullptr))
+        return d;
+    return EGL_NO_DISPLAY;
+}
+
+static bool create_contexts(BenchContext &bc)
+{
+    bc.display = open_display();
+    if (bc.display == EGL_NO_DISPLAY) {
+        fprintf(stderr, "EGL: no display\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "EGL: desktop OpenGL unavailable\n");
+        return false;
+    }
+
+    // same core 3.3 profile the viewer asks SDL for
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    bc.main = eglCreateContext(bc.display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (bc.main == EGL_NO_CONTEXT) {
+        fprintf(stderr, "EGL: unable to create a core 3.3 context (0x%x)\n", eglGetError());
+        return false;
+    }
+    if (!eglMakeCurrent(bc.display, EGL_NO_SURFACE, EGL_NO_SURFACE, bc.main)) {
+        fprintf(stderr, "EGL: surfaceless contexts unsupported (0x%x)\n", eglGetError());
+        return false;
+    }
+
+    bc.upload = eglCreateContext(bc.display, EGL_NO_CONFIG_KHR, bc.main, attribs);
+    return true;
+}
+
+static void destroy_contexts(BenchContext &bc)
+{
+    if (bc.display == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(bc.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (bc.upload != EGL_NO_CONTEXT)
+        eglDestroyContext(bc.display, bc.upload);
+    if (bc.main != EGL_NO_CONTEXT)
+        eglDestroyContext(bc.display, bc.main);
+    eglTerminate(bc.display);
+}
+
+static bool upload_context_make_current(void *user)
+{
+    BenchContext *bc = static_cast<BenchContext *>(user);
+    return eglMakeCurrent(bc->display, EGL_NO_SURFACE, EGL_NO_SURFACE, bc->upload);
+}
+
+static void upload_context_release(void *user)
+{
+    BenchContext *bc = static_cast<BenchContext *>(user);
+    eglMakeCurrent(bc->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+static void *egl_get_proc(const char *name)
+{
+    return reinterpret_cast<void *>(eglGetProcAddress(name));
+}
+
+// ----------------------------------------------------------------------
+// Null eye submit: stands in for IVRCompositor::Submit. A real compositor
+// samples the eye textures once the GPU has finished them, so the frame
+// counts as taken when a fence placed after the eye rendering signals.
+// ----------------------------------------------------------------------
+
+static void null_submit(LatencyStats &l)
+{
+    const int64_t submitNs = pacer_now_ns();
+    GLsync done = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glClientWaitSync(done, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    glDeleteSync(done);
+    latency_record(l, LATENCY_SUBMIT_TO_VSYNC, pacer_now_ns() - submitNs);
+}
+
+// ----------------------------------------------------------------------
+// Capture thread: synthetic frames at the requested rate
+// ----------------------------------------------------------------------
+
+static void capture_thread_func(SyntheticSource *src, float fps)
+{
+    const int64_t periodNs = fps > 0.0f ? (int64_t)(1e9 / fps) : 0;
+    int64_t next = pacer_now_ns();
+
+    while (g_captureRunning.load()) {
+        if (periodNs) {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(next)));
+            next += periodNs;
+            const int64_t now = pacer_now_ns();
+            if (next < now)
+                next = now;     // fell behind, don't try to catch up
+        }
+
+        const int64_t start = pacer_now_ns();
+        if (synthetic_source_frame(*src, g_frameHandoff))
+            frame_pacer_capture_done(g_framePacer, start, pacer_now_ns());
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// ----------------------------------------------------------------------
+// Cursor thread: a pointer circling the desktop, sent like a mouse would
+// ----------------------------------------------------------------------
+
+static void cursor_thread_func(int fd, int width, int height)
+{
+    // white arrow with a black edge, premultiplied ARGB8888
+    uint32_t image[BENCH_CURSOR_SIZE * BENCH_CURSOR_SIZE] = {};
+    for (int y = 0; y < BENCH_CURSOR_SIZE; ++y)
+        for (int x = 0; x <= y * 2 / 3; ++x)
+            image[y * BENCH_CURSOR_SIZE + x] =
+                (x == 0 || x == y * 2 / 3 || y == BENCH_CURSOR_SIZE - 1) ? 0xff000000u : 0xffffffffu;
+    bool imageSent = false;
+
+    const int64_t periodNs = (int64_t)(1e9 / BENCH_CURSOR_HZ);
+    const int64_t startNs = pacer_now_ns();
+    int64_t next = startNs;
+    while (g_cursorRunning.load()) {
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+            std::chrono::nanoseconds(next)));
+        next += periodNs;
+
+        // one turn every two seconds; a full socket drops this position,
+        // the next tick sends a newer one
+        const int64_t now = pacer_now_ns();
+        const double a = (double)(now - startNs) / 1e9 * M_PI;
+        const int x = (int)(width * (0.5 + 0.35 * cos(a)));
+        const int y = (int)(height * (0.5 + 0.35 * sin(a)));
+        if (!imageSent)
+            imageSent = cursor_send_image(fd, BENCH_CURSOR_SIZE, BENCH_CURSOR_SIZE, 0, 0, 1, image);
+        cursor_send_position(fd, x, y, now);
+    }
+}
+
+// ----------------------------------------------------------------------
+// Rendering
+// ----------------------------------------------------------------------
+
+// clip<-plane for one eye: the panel at BENCH_PANEL_DISTANCE, with the head
+// turned yaw radians to the right of it
+static void eye_mvp_col(const float projCol[16], float eyeX, float yaw, float out[16])
+{
+    // proj * translate(-eyeX, 0, 0) * rotateY(yaw) * translate(0, 0, -distance)
+    const float c = cosf(yaw), s = sinf(yaw);
+    const float viewCol[16] = {
+        c,    0.0f, -s,   0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        s,    0.0f, c,    0.0f,
+        -eyeX - s * BENCH_PANEL_DISTANCE, 0.0f, -c * BENCH_PANEL_DISTANCE, 1.0f,
+    };
+    for (int col = 0; col < 4; ++col)
+        for (int r = 0; r < 4; ++r)
+            out[col * 4 + r] = projCol[r] * viewCol[col * 4] +
+                               projCol[4 + r] * viewCol[col * 4 + 1] +
+                               projCol[8 + r] * viewCol[col * 4 + 2] +
+                               projCol[12 + r] * viewCol[col * 4 + 3];
+}
+
+static void record_frame_latency(LatencyStats &l, const DesktopTexture &t, int64_t submitNs)
+{
+    latency_record(l, LATENCY_CAPTURE_TO_COPY, t.readyNs - t.presentNs);
+    latency_record(l, LATENCY_COPY_TO_UPLOAD, t.uploadNs - t.readyNs);
+    latency_record(l, LATENCY_UPLOAD_TO_SUBMIT, submitNs - t.uploadNs);
+}
+
+// ----------------------------------------------------------------------
+// documentation
+// ----------------------------------------------------------------------
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [OPTIONS]\n"
+        "\n"
+        "Headless benchmark of capture -> upload -> render -> submit.\n"
+        "\n"
+        "Options:\n"
+        "  --size <W>x<H>      Synthetic desktop size (default 1920x1080).\n"
+        "  --pattern <name>    Damage pattern: full, box, typing (default box).\n"
+        "  --fps <n>           Synthetic capture rate, 0 = unthrottled (default 60).\n"
+        "  --refresh <hz>      Null headset refresh, 0 = unpaced (default 90).\n"
+        "  --eye <W>x<H>       Per-eye render target (default 1440x1600).\n"
+        "  --seconds <s>       Run time (default 5).\n"
+        "  --pbo-ring <n>      Upload PBO ring depth, 0 = client memory.\n"
+        "  --inline-upload     Upload on the render thread.\n"
+        "  --two-pass          Render each eye with its own draw.\n"
+        "  --tile-size <n>     Desktop texture tile edge in px (default %d).\n"
+        "  --yaw <deg>         Turn the head this far right of the panel, so\n"
+        "                      tiles out of view skip their uploads.\n"
+        "  --mipmaps <mode>    off | full (glGenerateMipmap) | damage (default).\n"
+        "  --format <name>     wl_shm format the frames are labelled with, any\n"
+        "                      32-bit one (default XRGB8888).\n"
+        "  --no-damage         Publish frames without damage rects, like a\n"
+        "                      compositor that has none.\n"
+        "  --tile-diff         Damage from tile hashes for such frames.\n"
+        "  --cursor            Draw a pointer moved at %.0f Hz through the\n"
+        "                      cursor layer socket, independent of --fps.\n"
+        "  --compare-upload    Run inline, then threaded upload, and fail if\n"
+        "                      their fresh frame rates differ by over %.0f%%.\n"
+        "  -c                  Curved panel.\n",
+        prog, UPLOAD_TILE_SIZE, BENCH_CURSOR_HZ, BENCH_FRESH_TOLERANCE * 100.0);
+}
+
+static bool parse_size(const char *s, int *w, int *h)
+{
+    return std::sscanf(s, "%dx%d", w, h) == 2 && *w > 0 && *h > 0;
+}
+
+static bool parse_options(int argc, char **argv, BenchOptions &o)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--size") == 0 && more) {
+            if (!parse_size(argv[++i], &o.width, &o.height))
+                return false;
+        } else if (strcmp(argv[i], "--pattern") == 0 && more) {
+            if (!synthetic_pattern_from_name(argv[++i], &o.pattern))
+                return false;
+        } else if (strcmp(argv[i], "--fps") == 0 && more) {
+            o.captureFps = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--refresh") == 0 && more) {
+            o.refreshHz = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--eye") == 0 && more) {
+            if (!parse_size(argv[++i], &o.eyeWidth, &o.eyeHeight))
+                return false;
+        } else if (strcmp(argv[i], "--seconds") == 0 && more) {
+            o.seconds = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--pbo-ring") == 0 && more) {
+            o.pboRingDepth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--inline-upload") == 0) {
+            o.uploadThread = false;
+        } else if (strcmp(argv[i], "--two-pass") == 0) {
+            o.singlePass = false;
+        } else if (strcmp(argv[i], "--tile-size") == 0 && more) {
+            o.tileSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--yaw") == 0 && more) {
+            o.yawDegrees = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--mipmaps") == 0 && more) {
+            if (!parse_mip_mode(argv[++i], &o.mipmaps))
+                return false;
+        } else if (strcmp(argv[i], "--format") == 0 && more) {
+            // the synthetic desktop is drawn in 32-bit words
+            o.format = pixel_format_from_name(argv[++i]);
+            if (!o.format || o.format->bytesPerPixel != 4)
+                return false;
+        } else if (strcmp(argv[i], "--no-damage") == 0) {
+            o.reportDamage = false;
+        } else if (strcmp(argv[i], "--tile-diff") == 0) {
+            o.tileDiff = true;
+        } else if (strcmp(argv[i], "--cursor") == 0) {
+            o.cursor = true;
+        } else if (strcmp(argv[i], "--compare-upload") == 0) {
+            o.compareUpload = true;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            o.curved = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// main
+// ---------------------------------------------------------------------------
+
+// One run with the contexts, renderer and eye targets main set up.
+// Returns the exit status.
+static int run_bench(const BenchOptions &opt, BenchContext &bc, Renderer &renderer,
+                     StereoTarget &stereoTarget, const GLuint eyeFbo[2], BenchResult *out)
+{
+    // ---------------- Capture + upload ----------------
+    frame_pacer_init(g_framePacer, opt.captureFps > 0.0f ? opt.captureFps : PACER_DEFAULT_HZ, false);
+    handoff_init(g_frameHandoff, BENCH_HANDOFF_SLOTS);
+
+    SyntheticSource source;
+    if (!synthetic_source_init(source, opt.width, opt.height, opt.pattern,
+                               g_frameHandoff.numSlots))
+        return 1;
+    source.format = opt.format->shmFormat;
+    source.reportDamage = opt.reportDamage;
+    TileDiffPool tileDiffPool;
+    TileDiff tileDiff;
+    if (opt.tileDiff) {
+        tile_diff_pool_start(tileDiffPool, 0);
+        tileDiff.pool = &tileDiffPool;
+        source.tileDiff = &tileDiff;
+    }
+
+    UploadThread uploader;
+    bool threadedUpload = opt.uploadThread && bc.upload != EGL_NO_CONTEXT &&
+        upload_thread_start(uploader, g_frameHandoff, opt.pboRingDepth, opt.tileSize, opt.mipmaps,
+                            upload_context_make_current, upload_context_release, &bc);
+    DesktopTexture desktop;
+    if (!threadedUpload)
+        desktop_texture_init(desktop, opt.pboRingDepth, opt.tileSize, opt.mipmaps);
+
+    fprintf(stderr,
+            "vrbench: %dx%d %s %s at %.0f fps, eyes %dx%d %s at %.0f Hz, %s upload, %d PBOs, "
+            "mipmaps %s\n",
+            opt.width, opt.height, opt.format->name, synthetic_pattern_name(opt.pattern),
+            opt.captureFps,
+            opt.eyeWidth, opt.eyeHeight, opt.singlePass ? "single pass" : "two pass",
+            opt.refreshHz, threadedUpload ? "threaded" : "inline", opt.pboRingDepth,
+            mip_mode_name(opt.mipmaps));
+
+    g_captureRunning.store(true);
+    std::thread captureThread(capture_thread_func, &source, opt.captureFps);
+
+    // the synthetic desktop's logical space is its pixels
+    CursorLayer cursor;
+    int cursorFd = -1;
+    std::thread cursorThread;
+    if (opt.cursor) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/vrbench-cursor-%d", (int)getpid());
+        if (cursor_layer_open(cursor, path))
+            cursorFd = cursor_sender_connect(path);
+        if (cursorFd < 0) {
+            fprintf(stderr, "vrbench: cursor socket unavailable\n");
+        } else {
+            g_cursorRunning.store(true);
+            cursorThread = std::thread(cursor_thread_func, cursorFd, opt.width, opt.height);
+        }
+    }
+
+    // ---------------- Render loop ----------------
+    float proj[16];
+    mat4_perspective_col(100.0f * (float)M_PI / 180.0f,
+                         (float)opt.eyeWidth / (float)opt.eyeHeight, 0.1f, 100.0f, proj);
+    float mvpCol[2][16];
+    const float yaw = opt.yawDegrees * (float)M_PI / 180.0f;
+    eye_mvp_col(proj, -0.5f * BENCH_EYE_SEPARATION, yaw, mvpCol[0]);
+    eye_mvp_col(proj, +0.5f * BENCH_EYE_SEPARATION, yaw, mvpCol[1]);
+
+    const float planeWidth = 1.5f;
+    const float planeHeight = planeWidth * (float)opt.height / (float)opt.width;
+
+    LatencyStats latency;
+    const DesktopTexture *shown = nullptr;
+    const FrameSlot *current = nullptr;
+    PanelMesh panelMesh;
+    uint64_t shownFrames = 0;       // new captures shown has switched to
+    uint64_t submittedFrames = 0;
+    const int64_t periodNs = opt.refreshHz > 0.0f ? (int64_t)(1e9 / opt.refreshHz) : 0;
+    const int64_t startNs = pacer_now_ns();
+    const int64_t endNs = startNs + (int64_t)(opt.seconds * 1e9);
+    int64_t nextVsync = startNs;
+
+    while (pacer_now_ns() < endNs) {
+        if (periodNs) {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(nextVsync)));
+            nextVsync += periodNs;
+            const int64_t now = pacer_now_ns();
+            if (nextVsync < now)
+                nextVsync = now;
+        }
+
+        if (threadedUpload) {
+            shown = upload_thread_front(uploader);
+            shownFrames = uploader.frontFrames;
+        } else {
+            FrameSlot *frame = handoff_acquire(g_frameHandoff);
+            if (frame) {
+                current = frame;
+                shownFrames++;
+            }
+            if (frame || (current && desktop_texture_needs_refresh(desktop))) {
+                upload_frame_to_texture(desktop, current, nullptr);
+                shown = &desktop;
+            }
+        }
+        if (!shown) {
+            if (!periodNs)
+                handoff_wait(g_frameHandoff, 10);
+            continue;
+        }
+
+        // the view is fixed, but the tile grid follows the frame size
+        const uint32_t visible = renderer_visible_tiles(*shown, mvpCol, 2, planeWidth,
+                                                        planeHeight, opt.curved);
+        if (threadedUpload)
+            upload_thread_set_visible(uploader, visible);
+        else
+            desktop.visibleTiles = visible;
+
+        float cursorUv[4];
+        cursor_layer_poll(cursor);
+        const bool drawCursor = cursor_layer_uv(cursor, 0, 0, opt.width, opt.height, cursorUv);
+
+        if (opt.singlePass) {
+            glBindFramebuffer(GL_FRAMEBUFFER, stereoTarget.fbo);
+            glViewport(0, 0, stereoTarget.width, stereoTarget.height);
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            renderer_draw_panel_stereo(renderer, panelMesh, *shown, mvpCol,
+                                       planeWidth, planeHeight, opt.curved);
+            if (drawCursor)
+                renderer_draw_cursor_stereo(renderer, cursor.tex, cursorUv, mvpCol,
+                                            planeWidth, planeHeight, opt.curved);
+        } else {
+            for (int eye = 0; eye < 2; ++eye) {
+                glBindFramebuffer(GL_FRAMEBUFFER, eyeFbo[eye]);
+                glViewport(0, 0, opt.eyeWidth, opt.eyeHeight);
+                glClearColor(0.f, 0.f, 0.f, 1.f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                renderer_draw_panel(renderer, panelMesh, *shown, mvpCol[eye],
+                                    planeWidth, planeHeight, opt.curved);
+                if (drawCursor)
+                    renderer_draw_cursor(renderer, cursor.tex, cursorUv, mvpCol[eye],
+                                         planeWidth, planeHeight, opt.curved);
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (drawCursor)
+            cursor_layer_drawn(cursor, pacer_now_ns());
+
+        const bool fresh = shownFrames != submittedFrames;
+        if (fresh)
+            record_frame_latency(latency, *shown, pacer_now_ns());
+        null_submit(latency);
+        frame_pacer_frame(g_framePacer, fresh);
+        submittedFrames = shownFrames;
+    }
+    const double secs = (double)(pacer_now_ns() - startNs) / 1e9;
+
+    // ---------------- Results ----------------
+    g_captureRunning.store(false);
+    if (captureThread.joinable())
+        captureThread.join();
+    g_cursorRunning.store(false);
+    if (cursorThread.joinable())
+        cursorThread.join();
+    if (cursorFd >= 0)
+        close(cursorFd);
+
+    UploadStats uploads;
+    if (threadedUpload) {
+        upload_thread_stop(uploader);
+        uploads = upload_thread_stats(uploader);
+    } else {
+        uploads = desktop.stats;
+        desktop_texture_destroy(desktop);
+    }
+
+    frame_pacer_report(g_framePacer, g_frameHandoff.dropped.load(), true);
+    print_upload_stats(uploads);
+    print_tile_diff_stats(tileDiff);
+    print_latency_stats(latency);
+    print_cursor_layer_stats(cursor);
+
+    const uint64_t vrFrames = g_framePacer.vrFrames.load();
+    const int64_t p50 = latency_percentile(latency.stage[LATENCY_UPLOAD_TO_SUBMIT], 50.0) +
+                        latency_percentile(latency.stage[LATENCY_COPY_TO_UPLOAD], 50.0) +
+                        latency_percentile(latency.stage[LATENCY_CAPTURE_TO_COPY], 50.0);
+    printf("vrbench pattern=%s size=%dx%d capture_fps=%.1f upload_fps=%.1f "
+           "upload_mbps=%.1f vr_fps=%.1f fresh_fps=%.1f wasted=%llu "
+           "frame_latency_p50_ms=%.2f submit_p99_ms=%.2f mipmaps=%s mip_gpu_ms=%.3f "
+           "cursor_fps=%.1f cursor_ms=%.2f\n",
+           synthetic_pattern_name(opt.pattern), opt.width, opt.height,
+           g_framePacer.captures.load() / secs,
+           uploads.frames / secs,
+           uploads.bytes / secs / 1e6,
+           vrFrames / secs,
+           g_framePacer.freshFrames.load() / secs,
+           (unsigned long long)g_frameHandoff.dropped.load(),
+           p50 / 1e6,
+           latency_percentile(latency.stage[LATENCY_SUBMIT_TO_VSYNC], 99.0) / 1e6,
+           mip_mode_name(opt.mipmaps),
+           uploads.mipTimed ? (double)uploads.mipGpuNs / (double)uploads.mipTimed / 1e6 : 0.0,
+           cursor.positionsDrawn / secs,
+           cursor.timedDraws ? (double)cursor.motionToDrawNs / (double)cursor.timedDraws / 1e6 : 0.0);
+
+    tile_diff_pool_stop(tileDiffPool);
+    synthetic_source_destroy(source);
+    cursor_layer_close(cursor);
+    panel_mesh_destroy(panelMesh);
+
+    out->threaded = threadedUpload;
+    out->freshFps = g_framePacer.freshFrames.load() / secs;
+
+    // every frame taken from the handoff reaches the compositor once, bar
+    // the ones still being uploaded or waiting for a swap when the run ended
+    const uint64_t taken = g_frameHandoff.consumed.load();
+    const uint64_t sampled = latency.stage[LATENCY_UPLOAD_TO_SUBMIT].count;
+    const bool latencyOk = sampled <= taken && sampled + BENCH_UNSHOWN_FRAMES >= taken;
+    if (!latencyOk)
+        fprintf(stderr, "vrbench: %llu frames uploaded but %llu latency samples\n",
+                (unsigned long long)taken, (unsigned long long)sampled);
+
+    // nothing made it through: the pipeline is broken, fail the CI job
+    return (vrFrames && uploads.frames && latencyOk) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt;
+    if (!parse_options(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    BenchContext bc;
+    if (!create_contexts(bc)) {
+        destroy_contexts(bc);
+        return 1;
+    }
+    fprintf(stderr, "GL renderer: %s (%s)\n",
+            (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+
+    Renderer renderer;
+    if (!renderer_init(renderer, egl_get_proc)) {
+        fprintf(stderr, "Renderer initialization failed\n");
+        destroy_contexts(bc);
+        return 1;
+    }
+
+    // eye targets: one layered target, or two plain ones for two-pass
+    StereoTarget stereoTarget;
+    if (opt.singlePass &&
+        !stereo_target_init(stereoTarget, renderer, opt.eyeWidth, opt.eyeHeight))
+        opt.singlePass = false;
+
+    GLuint eyeTex[2] = {};
+    GLuint eyeFbo[2] = {};
+    if (!opt.singlePass) {
+        glGenTextures(2, eyeTex);
+        glGenFramebuffers(2, eyeFbo);
+        for (int eye = 0; eye < 2; ++eye) {
+            glBindTexture(GL_TEXTURE_2D, eyeTex[eye]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, opt.eyeWidth, opt.eyeHeight,
+                         0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindFramebuffer(GL_FRAMEBUFFER, eyeFbo[eye]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D, eyeTex[eye], 0);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    int status;
+    if (opt.compareUpload) {
+        // the same source through both upload paths: at a capture rate both
+        // keep up with, each shows about every frame, so their fresh rates
+        // agree unless one of them loses track of its swaps
+        BenchOptions o = opt;
+        BenchResult inlineRun, threadedRun;
+        o.uploadThread = false;
+        status = run_bench(o, bc, renderer, stereoTarget, eyeFbo, &inlineRun);
+        o.uploadThread = true;
+        status |= run_bench(o, bc, renderer, stereoTarget, eyeFbo, &threadedRun);
+
+        const double diff = std::fabs(threadedRun.freshFps - inlineRun.freshFps);
+        const bool agree = diff <= BENCH_FRESH_TOLERANCE * inlineRun.freshFps;
+        fprintf(stderr, "vrbench: fresh fps %.1f inline, %.1f %s, %s\n",
+                inlineRun.freshFps, threadedRun.freshFps,
+                threadedRun.threaded ? "threaded" : "inline again (no upload context)",
+                agree ? "agree" : "differ");
+        if (!agree)
+            status = 1;
+    } else {
+        BenchResult r;
+        status = run_bench(opt, bc, renderer, stereoTarget, eyeFbo, &r);
+    }
+
+    stereo_target_destroy(stereoTarget);
+    if (eyeFbo[0]) glDeleteFramebuffers(2, eyeFbo);
+    if (eyeTex[0]) glDeleteTextures(2, eyeTex);
+    renderer_destroy(renderer);
+    destroy_contexts(bc);
+    return status;
+}
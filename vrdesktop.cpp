@@ -1,12 +1,14 @@
 // vrdesktop.cpp
 // Wayland wlr-screencopy + SDL2 + OpenGL + OpenVR.
-// - Default output: DP-3 (override: -o NAME)
-// - Continuous capture (~120 fps) with cursor
+// - Default output: DP-3 (override: -o NAME[,NAME...] or -o all; one
+//   VR panel per output, laid out like the monitors)
+// - Capture paced to the headset refresh, with cursor
 // - Shows captured desktop on a quad in the SDL window (unless --no-window)
 // - Renders a 3D plane in VR (stereo) floating in front of the user.
 
 #include <cstdio>
 #include <cstdlib>
+#include <climits>
 #include <cstdint>
 #include <cstring>
 #include <cerrno>
@@ -18,14 +20,9 @@
 
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
-#include <wayland-client.h>
-#include "wlr-screencopy-unstable-v1-protocol.h"
-#include "xdg-output-unstable-v1-protocol.h"
-
 // --------------------//Tray Icon Support
 #include <atomic>
 #include <thread>
@@ -50,21 +47,25 @@
 #include <atomic>
 #include <vector>
 #include "config.h"
-
-struct SharedFrame {
-    std::mutex m;
-    std::vector<uint8_t> pixels;
-    int width  = 0;
-    int height = 0;
-    int stride = 0;
-    std::atomic<uint64_t> version{0};   // increments each time a new frame is available
-};
-
-static SharedFrame g_sharedFrame;
+#include "frame_handoff.h"
+#include "screencopy.h"
+#include "texture_upload.h"
+#include "upload_thread.h"
+#include "renderer.h"
+#include "overlay.h"
+#include "frame_pacer.h"
+#include "latency.h"
+#include "hud.h"
+#include "panel_layout.h"
+#include "cursor_layer.h"
+
+// capture thread -> render loop, one handoff per captured output
+static FrameHandoff g_frameHandoff[SCREENCOPY_MAX_STREAMS];
+static FramePacer g_framePacer;
 static std::atomic<bool> g_captureRunning{false};
 
 // ---------------------------------------------------------------------------
-// Simple shm helper
+// Tray menu requests (gtk callbacks -> main loop)
 // ---------------------------------------------------------------------------
 
 static std::atomic<bool> g_trayToggleRecenter{false};
@@ -73,427 +74,11 @@ static std::atomic<bool> g_trayToggleZoomOut{false};
 static std::atomic<bool> g_trayToggleCurved{false};
 static std::atomic<bool> g_trayTogglePreview{false};
 static std::atomic<bool> g_trayToggleSave{false};
+static std::atomic<bool> g_trayToggleStereo{false};
+static std::atomic<bool> g_trayShowLatency{false};
+static std::atomic<bool> g_trayToggleHud{false};
 static std::atomic<bool> g_trayQuitRequest{false};
 
-static int create_shm_file(off_t size)
-{
-    char template_name[] = "/dev/shm/vrdesktop-XXXXXX";
-    int fd = mkstemp(template_name);
-    if (fd < 0) {
-        std::fprintf(stderr, "mkstemp failed: %s\n", std::strerror(errno));
-        return -1;
-    }
-
-    // we don't need the name anymore
-    unlink(template_name);
-
-    if (ftruncate(fd, size) < 0) {
-        std::fprintf(stderr, "ftruncate failed: %s\n", std::strerror(errno));
-        close(fd);
-        return -1;
-    }
-
-    return fd;
-}
-
-// ---------------------------------------------------------------------------
-// Output tracking
-// ---------------------------------------------------------------------------
-
-#define MAX_OUTPUTS 16
-
-struct output_info {
-    wl_output *wl_output_obj = nullptr;
-    zxdg_output_v1 *xdg_output = nullptr;
-    char *name = nullptr;      // e.g. "DP-3"
-};
-
-struct screencopy_state {
-    wl_display *display = nullptr;
-    wl_registry *registry = nullptr;
-    wl_shm *shm = nullptr;
-    zwlr_screencopy_manager_v1 *screencopy_manager = nullptr;
-    zxdg_output_manager_v1 *xdg_output_manager = nullptr;
-
-    output_info outputs[MAX_OUTPUTS];
-    int num_outputs = 0;
-
-    wl_output *chosen_output = nullptr;
-
-    // frame data
-    int done = 0;
-    int failed = 0;
-
-    uint32_t width = 0;
-    uint32_t height = 0;
-    uint32_t stride = 0;
-    uint32_t format = 0; // wl_shm_format
-
-    int shm_fd = -1;
-    size_t shm_size = 0;
-    void *shm_data = nullptr;
-    wl_shm_pool *pool = nullptr;
-    wl_buffer *buffer = nullptr;
-};
-
-// ---------------------------------------------------------------------------
-// xdg-output listeners
-// ---------------------------------------------------------------------------
-
-static void xdg_output_logical_position(void *data,
-                                        zxdg_output_v1 *xdg_output,
-                                        int32_t x, int32_t y)
-{
-    (void)data; (void)xdg_output; (void)x; (void)y;
-}
-
-static void xdg_output_logical_size(void *data,
-                                    zxdg_output_v1 *xdg_output,
-                                    int32_t width, int32_t height)
-{
-    (void)data; (void)xdg_output; (void)width; (void)height;
-}
-
-static void xdg_output_done(void *data,
-                            zxdg_output_v1 *xdg_output)
-{
-    (void)data; (void)xdg_output;
-}
-
-static void xdg_output_name(void *data,
-                            zxdg_output_v1 *xdg_output,
-                            const char *name)
-{
-    screencopy_state *st = static_cast<screencopy_state *>(data);
-
-    for (int i = 0; i < st->num_outputs; ++i) {
-        if (st->outputs[i].xdg_output == xdg_output) {
-            free(st->outputs[i].name);
-            st->outputs[i].name = strdup(name);
-            std::fprintf(stderr, "Output %d name: %s\n", i, st->outputs[i].name);
-            break;
-        }
-    }
-}
-
-static void xdg_output_description(void *data,
-                                   zxdg_output_v1 *xdg_output,
-                                   const char *description)
-{
-    (void)data; (void)xdg_output; (void)description;
-}
-
-static const zxdg_output_v1_listener xdg_output_listener = {
-    xdg_output_logical_position,
-    xdg_output_logical_size,
-    xdg_output_done,
-    xdg_output_name,
-    xdg_output_description,
-};
-
-// ---------------------------------------------------------------------------
-// Wayland registry
-// ---------------------------------------------------------------------------
-
-static void registry_global(void *data,
-                            wl_registry *registry,
-                            uint32_t name,
-                            const char *interface,
-                            uint32_t version)
-{
-    (void)version;
-    screencopy_state *st = static_cast<screencopy_state *>(data);
-
-    if (std::strcmp(interface, wl_shm_interface.name) == 0) {
-        st->shm = static_cast<wl_shm *>(
-            wl_registry_bind(registry, name, &wl_shm_interface, 1));
-    } else if (std::strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0) {
-        st->screencopy_manager = static_cast<zwlr_screencopy_manager_v1 *>(
-            wl_registry_bind(registry, name, &zwlr_screencopy_manager_v1_interface, 3));
-    } else if (std::strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
-        st->xdg_output_manager = static_cast<zxdg_output_manager_v1 *>(
-            wl_registry_bind(registry, name, &zxdg_output_manager_v1_interface, 3));
-    } else if (std::strcmp(interface, wl_output_interface.name) == 0) {
-        if (st->num_outputs < MAX_OUTPUTS) {
-            output_info &out = st->outputs[st->num_outputs++];
-            std::memset(&out, 0, sizeof(out));
-            out.wl_output_obj = static_cast<wl_output *>(
-                wl_registry_bind(registry, name, &wl_output_interface, 2));
-        }
-    }
-}
-
-static void registry_global_remove(void *data,
-                                   wl_registry *registry,
-                                   uint32_t name)
-{
-    (void)data; (void)registry; (void)name;
-}
-
-static const wl_registry_listener registry_listener = {
-    registry_global,
-    registry_global_remove
-};
-
-static void setup_xdg_outputs(screencopy_state *st)
-{
-    if (!st->xdg_output_manager)
-        return;
-
-    for (int i = 0; i < st->num_outputs; ++i) {
-        if (!st->outputs[i].wl_output_obj || st->outputs[i].xdg_output)
-            continue;
-
-        st->outputs[i].xdg_output =
-            zxdg_output_manager_v1_get_xdg_output(
-                st->xdg_output_manager,
-                st->outputs[i].wl_output_obj);
-
-        zxdg_output_v1_add_listener(
-            st->outputs[i].xdg_output,
-            &xdg_output_listener,
-            st);
-    }
-}
-
-static void choose_output(screencopy_state *st, const char *requested_name)
-{
-    st->chosen_output = nullptr;
-
-    if (requested_name && st->xdg_output_manager) {
-        for (int i = 0; i < st->num_outputs; ++i) {
-            if (st->outputs[i].name &&
-                std::strcmp(st->outputs[i].name, requested_name) == 0) {
-                st->chosen_output = st->outputs[i].wl_output_obj;
-                std::fprintf(stderr, "Selected output \"%s\" (index %d)\n",
-                             st->outputs[i].name, i);
-                return;
-            }
-        }
-        std::fprintf(stderr,
-                     "Requested output \"%s\" not found, falling back to first output.\n",
-                     requested_name);
-    }
-
-    if (st->num_outputs > 0) {
-        st->chosen_output = st->outputs[0].wl_output_obj;
-        if (st->outputs[0].name)
-            std::fprintf(stderr, "Using output \"%s\" (index 0)\n", st->outputs[0].name);
-        else
-            std::fprintf(stderr, "Using first output (index 0, no name)\n");
-    } else {
-        std::fprintf(stderr, "No wl_output objects found!\n");
-    }
-}
-
-// ---------------------------------------------------------------------------
-// Screencopy frame listener
-// ---------------------------------------------------------------------------
-
-static void frame_buffer(void *data,
-                         zwlr_screencopy_frame_v1 *frame,
-                         uint32_t format,
-                         uint32_t width,
-                         uint32_t height,
-                         uint32_t stride)
-{
-    screencopy_state *st = static_cast<screencopy_state *>(data);
-    (void)frame;
-
-    st->format = format;
-    st->width  = width;
-    st->height = height;
-    st->stride = stride;
-
-    if (!st->buffer) {
-        st->shm_size = (size_t)stride * (size_t)height;
-        st->shm_fd = create_shm_file(st->shm_size);
-        if (st->shm_fd < 0) {
-            st->failed = 1;
-            return;
-        }
-
-        st->shm_data = mmap(nullptr, st->shm_size,
-                            PROT_READ | PROT_WRITE,
-                            MAP_SHARED, st->shm_fd, 0);
-        if (st->shm_data == MAP_FAILED) {
-            std::fprintf(stderr, "mmap failed: %s\n", std::strerror(errno));
-            close(st->shm_fd);
-            st->shm_fd = -1;
-            st->failed = 1;
-            return;
-        }
-
-        st->pool = wl_shm_create_pool(st->shm, st->shm_fd, (int)st->shm_size);
-        st->buffer = wl_shm_pool_create_buffer(
-            st->pool,
-            0,
-            (int)width,
-            (int)height,
-            (int)stride,
-            format
-        );
-    }
-
-    // Ask compositor to copy into this buffer
-    zwlr_screencopy_frame_v1_copy(frame, st->buffer);
-}
-
-static void frame_flags(void *data,
-                        zwlr_screencopy_frame_v1 *frame,
-                        uint32_t flags)
-{
-    (void)data; (void)frame; (void)flags;
-}
-
-static void frame_ready(void *data,
-                        zwlr_screencopy_frame_v1 *frame,
-                        uint32_t tv_sec_hi,
-                        uint32_t tv_sec_lo,
-                        uint32_t tv_nsec)
-{
-    screencopy_state *st = static_cast<screencopy_state *>(data);
-    (void)frame; (void)tv_sec_hi; (void)tv_sec_lo; (void)tv_nsec;
-
-    st->done = 1;
-    zwlr_screencopy_frame_v1_destroy(frame);
-}
-
-static void frame_failed(void *data,
-                         zwlr_screencopy_frame_v1 *frame)
-{
-    screencopy_state *st = static_cast<screencopy_state *>(data);
-    (void)frame;
-    st->failed = 1;
-    st->done = 1;
-}
-
-static void frame_damage(void *data,
-                         zwlr_screencopy_frame_v1 *frame,
-                         uint32_t x,
-                         uint32_t y,
-                         uint32_t width,
-                         uint32_t height)
-{
-    (void)data; (void)frame; (void)x; (void)y; (void)width; (void)height;
-}
-
-static void frame_linux_dmabuf(void *data,
-                               zwlr_screencopy_frame_v1 *frame,
-                               uint32_t format,
-                               uint32_t width,
-                               uint32_t height)
-{
-    (void)data; (void)frame; (void)format; (void)width; (void)height;
-}
-
-static void frame_buffer_done(void *data,
-                              zwlr_screencopy_frame_v1 *frame)
-{
-    (void)data; (void)frame;
-    // For shm path we don't need to do anything here.
-}
-
-static const zwlr_screencopy_frame_v1_listener frame_listener = {
-    frame_buffer,
-    frame_flags,
-    frame_ready,
-    frame_failed,
-    frame_damage,
-    frame_linux_dmabuf,
-    frame_buffer_done,
-};
-
-// ---------------------------------------------------------------------------
-// Capture one frame
-// ---------------------------------------------------------------------------
-
-static int screencopy_capture(screencopy_state *st)
-{
-    if (!st->chosen_output) {
-        std::fprintf(stderr, "No chosen_output set!\n");
-        return -1;
-    }
-
-    st->done   = 0;
-    st->failed = 0;
-
-    // overlay_cursor = 1 -> include cursor in capture
-    zwlr_screencopy_frame_v1 *frame =
-        zwlr_screencopy_manager_v1_capture_output(
-            st->screencopy_manager,
-            1,
-            st->chosen_output
-        );
-
-    zwlr_screencopy_frame_v1_add_listener(frame, &frame_listener, st);
-
-    // Pump events until the frame is done
-    while (!st->done && wl_display_dispatch(st->display) != -1) {
-        // nothing else
-    }
-
-    if (st->failed) {
-        std::fprintf(stderr, "screencopy: capture failed\n");
-        return -1;
-    }
-
-    return 0;
-}
-
-// ---------------------------------------------------------------------------
-// Upload frame into GL texture (create once, then subimage)
-// ---------------------------------------------------------------------------
-
-static void upload_frame_to_texture(screencopy_state *st,
-                                    GLuint &tex,
-                                    bool &tex_initialized)
-{
-    if (!st->shm_data || st->width == 0 || st->height == 0)
-        return;
-
-    if (!tex_initialized) {
-        glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
-    GLfloat maxAniso = 0.0f;
-    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso);
-
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RGBA,
-            (GLsizei)st->width,
-            (GLsizei)st->height,
-            0,
-            GL_RGBA,
-            GL_UNSIGNED_INT_8_8_8_8_REV,
-            st->shm_data
-        );
-
-        glBindTexture(GL_TEXTURE_2D, 0);
-        tex_initialized = true;
-    } else {
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-        glTexSubImage2D(
-            GL_TEXTURE_2D,
-            0,
-            0, 0,
-            (GLsizei)st->width,
-            (GLsizei)st->height,
-            GL_RGBA,
-            GL_UNSIGNED_INT_8_8_8_8_REV,
-            st->shm_data
-        );
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-}
-
 // ---------------------------------------------------------------------------
 // OpenVR state (minimal, with per-eye textures)
 // ---------------------------------------------------------------------------
@@ -506,10 +91,12 @@ struct VRState {
     GLuint eyeTex[2]{0, 0};
 };
 
-static bool init_openvr(VRState &vrState)
+// Overlay apps leave eye rendering to the compositor, so they get no eye
+// render targets.
+static bool init_openvr(VRState &vrState, vr::EVRApplicationType appType)
 {
     vr::EVRInitError eError = vr::VRInitError_None;
-    vrState.system = vr::VR_Init(&eError, vr::VRApplication_Scene);
+    vrState.system = vr::VR_Init(&eError, appType);
     if (eError != vr::VRInitError_None) {
         std::fprintf(stderr, "Unable to init OpenVR: %s\n",
                      vr::VR_GetVRInitErrorAsEnglishDescription(eError));
@@ -529,6 +116,9 @@ static bool init_openvr(VRState &vrState)
                  vrState.rtWidth, vrState.rtHeight);
     // For PSVR2 you should see something like ~2000x2040 here.
 
+    if (appType == vr::VRApplication_Overlay)
+        return true;
+
     glGenFramebuffers(2, vrState.eyeFbo);
     glGenTextures(2, vrState.eyeTex);
 
@@ -667,6 +257,7 @@ static void mat4_invert_rigid_row(const float in[16], float out[16])
 // --------- Global state for plane and head pose ---------
 static bool running = true;
 static bool g_useCurvedSurface = false;
+static bool g_singlePassStereo = true;       // --two-pass
 static bool hideWindow = true;               // --no-window
 static float g_planePoseRow[16];            // absoluteFromPlane (row-major)
 static bool  g_planePoseInitialized = false;
@@ -713,181 +304,6 @@ static void recenter_curve(float curveDistance)
     std::fprintf(stderr, "Recenter curve at distance %.2f m\n", curveDistance);
 }
 
-static void load_gl_projection_from_vr(const vr::HmdMatrix44_t &m)
-{
-    float mat[16];
-    // OpenVR is row-major; OpenGL wants column-major
-    for (int r = 0; r < 4; ++r) {
-        for (int c = 0; c < 4; ++c) {
-            mat[c * 4 + r] = m.m[r][c];
-        }
-    }
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(mat);
-}
-
-// Render plane in 3D (XY plane at z=0; caller sets camera/modelview)
-static void render_desktop_plane_3d(GLuint desktopTex,
-                                    float planeWidth,
-                                    float planeHeight)
-{
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, desktopTex);
-
-    const float hw = planeWidth  * 0.5f;
-    const float hh = planeHeight * 0.5f;
-
-    glBegin(GL_QUADS);
-        // Y flipped so desktop isn't upside-down
-        glTexCoord2f(0.f, 1.f); glVertex3f(-hw, -hh, 0.f);
-        glTexCoord2f(1.f, 1.f); glVertex3f( hw, -hh, 0.f);
-        glTexCoord2f(1.f, 0.f); glVertex3f( hw,  hh, 0.f);
-        glTexCoord2f(0.f, 0.f); glVertex3f(-hw,  hh, 0.f);
-    glEnd();
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-}
-
-// Render desktop on a cylindrical segment centered on Z axis
-static void render_desktop_curved_3d(GLuint desktopTex,
-                                     float planeWidth,
-                                     float planeHeight)
-{
-    if (!desktopTex)
-        return;
-
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, desktopTex);
-
-    // How much of a cylinder arc to use (in degrees)
-    const float arcDegrees = 90.0f;     // 90° wrap around you
-    const int   segments   = 64;        // geometry resolution
-
-    // Convert to radians
-    const float arcRadians = arcDegrees * (float)M_PI / 180.0f;
-
-    // planeWidth is the chord length; approximate radius so chord spans arc
-    // chord = 2 * R * sin(theta/2)
-    const float halfArc = arcRadians * 0.5f;
-    const float radius  = planeWidth / (2.0f * sinf(halfArc));
-
-    const float halfHeight = planeHeight * 0.5f;
-
-    // Angle range from -halfArc..+halfArc (screen centered on -Z)
-    const float thetaStart = -halfArc;
-    const float thetaEnd   =  halfArc;
-
-    glBegin(GL_TRIANGLE_STRIP);
-
-    for (int i = 0; i <= segments; ++i) {
-        float t = (float)i / (float)segments;
-        float theta = thetaStart + t * (thetaEnd - thetaStart);
-
-        // Cylinder parametric: around Y axis, facing -Z
-        float x = radius * sinf(theta);
-        float z = -radius * cosf(theta);
-
-        // Texture coordinate across width
-        float u = t;   // 0..1 across arc
-
-        // Top vertex (y = +halfHeight)
-        glTexCoord2f(u, 0.0f);
-        glVertex3f(x, +halfHeight, z);
-
-        // Bottom vertex (y = -halfHeight)
-        glTexCoord2f(u, 1.0f);
-        glVertex3f(x, -halfHeight, z);
-    }
-
-    glEnd();
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-}
-
-static void render_desktop_curved(GLuint desktopTex,
-                                     float planeWidth,
-                                     float planeHeight)
-{
-    if (!desktopTex)
-        return;
-
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, desktopTex);
-
-    // How much of a cylinder arc to use (in degrees)
-    const float arcDegrees = 90.0f;     // 90° wrap around you
-    const int   segments   = 64;        // geometry resolution
-
-    // Convert to radians
-    const float arcRadians = arcDegrees * (float)M_PI / 180.0f;
-
-    // planeWidth is the chord length; approximate radius so chord spans arc
-    // chord = 2 * R * sin(theta/2)
-    const float halfArc = arcRadians * 0.5f;
-    const float radius  = planeWidth / (2.0f * sinf(halfArc));
-
-    const float halfHeight = planeHeight * 0.5f;
-
-    // Angle range from -halfArc..+halfArc (screen centered on -Z)
-    const float thetaStart = -halfArc;
-    const float thetaEnd   =  halfArc;
-
-    glBegin(GL_TRIANGLE_STRIP);
-
-    for (int i = 0; i <= segments; ++i) {
-        float t = (float)i / (float)segments;
-        float theta = thetaStart + t * (thetaEnd - thetaStart);
-
-        // Cylinder parametric: around Y axis, facing -Z
-        float x = radius * sinf(theta);
-        float z = -radius * cosf(theta);
-
-        // Texture coordinate across width
-        float u = t;   // 0..1 across arc
-
-        // Top vertex (y = +halfHeight)
-        glTexCoord2f(u, 0.0f);
-        glVertex3f(x, +halfHeight, z);
-
-        // Bottom vertex (y = -halfHeight)
-        glTexCoord2f(u, 1.0f);
-        glVertex3f(x, -halfHeight, z);
-    }
-
-    glEnd();
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-}
-
-
-// Render to SDL window (simple 2D quad)
-static void render_desktop_quad_2d(GLuint desktopTex)
-{
-    glClearColor(0.f, 0.f, 0.f, 1.f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, desktopTex);
-
-    glBegin(GL_QUADS);
-        glTexCoord2f(0.f, 1.f); glVertex2f(-0.8f, -0.8f);
-        glTexCoord2f(1.f, 1.f); glVertex2f( 0.8f, -0.8f);
-        glTexCoord2f(1.f, 0.f); glVertex2f( 0.8f,  0.8f);
-        glTexCoord2f(0.f, 0.f); glVertex2f(-0.8f,  0.8f);
-    glEnd();
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-}
-
 // -------------------------------------------------------------------------
 // terminal input
 // -------------------------------------------------------------------------
@@ -950,30 +366,420 @@ int read_cli_key()
 //
 //
 
+// Every published frame feeds the pacer's capture-time average.
+static void on_capture_published(void *user, const capture_request &req)
+{
+    (void)user;
+    frame_pacer_capture_done(g_framePacer, req.issue_ns, req.ready_ns);
+}
+
+static bool any_stream_can_issue(const screencopy_state *st)
+{
+    for (int i = 0; i < st->num_streams; ++i)
+        if (screencopy_can_issue(&st->streams[i], g_frameHandoff[i]))
+            return true;
+    return false;
+}
+
 static void capture_thread_func(screencopy_state *st)
 {
-    // Initialise shared buffer the first time
-    {
-        std::lock_guard<std::mutex> lock(g_sharedFrame.m);
-        g_sharedFrame.width  = st->width;
-        g_sharedFrame.height = st->height;
-        g_sharedFrame.stride = st->stride;
-        g_sharedFrame.pixels.resize(st->stride * st->height);
-    }
+    int64_t nextIssue = frame_pacer_next_issue(g_framePacer);
 
     while (g_captureRunning.load()) {
-        if (screencopy_capture(st) == 0) {
-            // Copy shm buffer into our shared CPU buffer
-            std::lock_guard<std::mutex> lock(g_sharedFrame.m);
-            std::memcpy(g_sharedFrame.pixels.data(),
-                        st->shm_data,
-                        g_sharedFrame.stride * g_sharedFrame.height);
-            g_sharedFrame.version.fetch_add(1, std::memory_order_relaxed);
+        // keep up to max_in_flight requests outstanding per output, one per
+        // headset frame, each timed to land just before its vsync; every
+        // output with room is captured for the same vsync
+        if (pacer_now_ns() >= nextIssue) {
+            bool issued = false;
+            for (int i = 0; i < st->num_streams; ++i) {
+                capture_stream *s = &st->streams[i];
+                if (screencopy_can_issue(s, g_frameHandoff[i]) &&
+                    screencopy_issue(s, g_frameHandoff[i], st->use_damage) == 0)
+                    issued = true;
+            }
+            if (issued)
+                nextIssue = frame_pacer_next_issue(g_framePacer);
+        }
+
+        // sleep until the next issue is due, compositor events arrive or
+        // we are woken for shutdown; with every pipeline full only a
+        // completion can free a request, so the timer stays off
+        screencopy_arm_timer(st, any_stream_can_issue(st) ? nextIssue : 0);
+        if (screencopy_wait(st) < 0) {
+            std::fprintf(stderr, "screencopy: Wayland connection lost\n");
+            break;
+        }
+
+        // hand completed frames on in the order they were requested
+        for (int i = 0; i < st->num_streams; ++i)
+            screencopy_collect(&st->streams[i], g_frameHandoff[i], on_capture_published, nullptr);
+    }
+    for (int i = 0; i < st->num_streams; ++i)
+        screencopy_abort(&st->streams[i], g_frameHandoff[i]);
+}
+
+// Handoff counters summed over the captured outputs.
+static uint64_t handoff_total(std::atomic<uint64_t> FrameHandoff::*counter, int count)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < count; ++i)
+        total += (g_frameHandoff[i].*counter).load(std::memory_order_relaxed);
+    return total;
+}
+
+// ----------------------------------------------------------------------
+// Latency accounting (render thread)
+// ----------------------------------------------------------------------
+
+// A frame reached the VR compositor for the first time: shownFrames moved
+// on since the last submit, so t holds the frame's own timestamps.
+static void record_frame_latency(LatencyStats &l, const DesktopTexture &t, int64_t submitNs)
+{
+    latency_record(l, LATENCY_CAPTURE_TO_COPY, t.readyNs - t.presentNs);
+    latency_record(l, LATENCY_COPY_TO_UPLOAD, t.uploadNs - t.readyNs);
+    latency_record(l, LATENCY_UPLOAD_TO_SUBMIT, submitNs - t.uploadNs);
+}
+
+// Submit -> scan-out of a frame the compositor has finished with.
+// GetFrameTiming times are relative to the frame's starting vsync.
+static void record_vsync_latency(LatencyStats &l, const vr::Compositor_FrameTiming &timing,
+                                 int64_t periodNs)
+{
+    uint32_t vsyncs = timing.m_nNumVSyncsToFirstView ? timing.m_nNumVSyncsToFirstView : 1;
+    int64_t vsyncNs  = (int64_t)vsyncs * periodNs;
+    int64_t submitNs = (int64_t)(timing.m_flNewFrameReadyMs * 1e6);
+    latency_record(l, LATENCY_SUBMIT_TO_VSYNC, vsyncNs - submitNs);
+}
+
+// ----------------------------------------------------------------------
+// Compositor frame timing (render thread)
+// ----------------------------------------------------------------------
+
+struct CompositorStats {
+    uint32_t lastFrameIndex = 0;            // GetFrameTiming frame already counted
+    vr::Compositor_FrameTiming last = {};
+    uint64_t droppedFrames = 0;
+    uint64_t reprojectedFrames = 0;         // shown for more than one vsync
+};
+
+// Fetch the newest frame the compositor has finished with, once per frame.
+// Returns false if it is the one already counted.
+static bool update_compositor_stats(CompositorStats &c)
+{
+    vr::Compositor_FrameTiming timing = {};
+    timing.m_nSize = sizeof(timing);
+    if (!vr::VRCompositor()->GetFrameTiming(&timing, 1) ||
+        timing.m_nFrameIndex == c.lastFrameIndex)
+        return false;
+
+    c.lastFrameIndex = timing.m_nFrameIndex;
+    c.last = timing;
+    c.droppedFrames += timing.m_nNumDroppedFrames;
+    if (timing.m_nNumFramePresents > 1)
+        c.reprojectedFrames++;
+    return true;
+}
+
+// ----------------------------------------------------------------------
+// Stats HUD (render thread)
+// ----------------------------------------------------------------------
+
+#define HUD_REFRESH_NS 500000000ll
+
+// Totals sampled at each HUD refresh; rates are the difference between two.
+struct HudSample {
+    int64_t ns = 0;
+    uint64_t captures = 0;
+    uint64_t vrFrames = 0;
+    uint64_t freshFrames = 0;       // submits after an upload swap to a new capture
+    uint64_t wasted = 0;
+    uint64_t uploadBytes = 0;
+};
+
+static HudSample sample_hud(uint64_t uploadBytes, int numOutputs)
+{
+    HudSample s;
+    s.ns = pacer_now_ns();
+    s.captures    = g_framePacer.captures.load(std::memory_order_relaxed);
+    s.vrFrames    = g_framePacer.vrFrames.load(std::memory_order_relaxed);
+    s.freshFrames = g_framePacer.freshFrames.load(std::memory_order_relaxed);
+    s.wasted      = handoff_total(&FrameHandoff::dropped, numOutputs);
+    s.uploadBytes = uploadBytes;
+    return s;
+}
+
+static void set_hud_lines(Hud &hud, const HudSample &prev, const HudSample &cur,
+                          const CompositorStats &c, int numOutputs)
+{
+    const double secs = (double)(cur.ns - prev.ns) / 1e9;
+    if (secs <= 0.0)
+        return;
+
+    hud_set_line(hud, 0, "CAP %5.1f FPS  VR %5.1f  NEW %5.1f",
+                 (cur.captures - prev.captures) / secs,
+                 (cur.vrFrames - prev.vrFrames) / secs,
+                 (cur.freshFrames - prev.freshFrames) / secs);
+    hud_set_line(hud, 1, "UPLOAD %6.1f MB/S  COPY %5.2f MS",
+                 (cur.uploadBytes - prev.uploadBytes) / secs / 1e6,
+                 g_framePacer.captureNs.load(std::memory_order_relaxed) / 1e6);
+    hud_set_line(hud, 2, "GPU %5.2f MS  COMPOSITOR %5.2f MS",
+                 c.last.m_flTotalRenderGpuMs, c.last.m_flCompositorRenderGpuMs);
+    hud_set_line(hud, 3, "FRAME INTERVAL %5.2f MS",
+                 c.last.m_flClientFrameIntervalMs);
+    hud_set_line(hud, 4, "DROPPED %llu  REPROJECTED %llu",
+                 (unsigned long long)c.droppedFrames,
+                 (unsigned long long)c.reprojectedFrames);
+    int claimed = 0, pending = 0;
+    for (int i = 0; i < numOutputs; ++i) {
+        claimed += g_frameHandoff[i].claimed.load(std::memory_order_relaxed);
+        pending += handoff_pending(g_frameHandoff[i]);
+    }
+    hud_set_line(hud, 5, "QUEUE %d IN FLIGHT %d READY  WASTED %.1f/S",
+                 claimed, pending, (cur.wasted - prev.wasted) / secs);
+}
+
+// plane<-HUD: centred under the panel, on the panel's front surface
+static void hud_offset_row(float planeWidth, float planeHeight, bool curved, float out[16])
+{
+    mat4_identity(out);
+    out[1*4 + 3] = -0.5f * planeHeight - HUD_GAP_METERS - 0.5f * hud_height_meters();
+    if (curved) {
+        const float halfArc = PANEL_CURVE_ARC_DEGREES * (float)M_PI / 180.0f * 0.5f;
+        out[2*4 + 3] = -planeWidth / (2.0f * sinf(halfArc));
+    }
+}
+
+// ----------------------------------------------------------------------
+// Upload thread GL context (shared with the main context, on a hidden
+// 1x1 window so it never competes for the preview window's drawable)
+// ----------------------------------------------------------------------
+
+struct UploadContext {
+    SDL_Window *window = nullptr;
+    SDL_GLContext ctx = nullptr;
+};
+
+static bool upload_context_make_current(void *user)
+{
+    UploadContext *uc = static_cast<UploadContext *>(user);
+    return SDL_GL_MakeCurrent(uc->window, uc->ctx) == 0;
+}
+
+static void upload_context_release(void *user)
+{
+    UploadContext *uc = static_cast<UploadContext *>(user);
+    SDL_GL_MakeCurrent(uc->window, nullptr);
+}
+
+// Must be called with the main context current; leaves it current.
+static bool create_upload_context(UploadContext &uc, SDL_Window *mainWindow,
+                                  SDL_GLContext mainCtx)
+{
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    uc.window = SDL_CreateWindow("VR Desktop upload", 0, 0, 1, 1,
+                                 SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (uc.window)
+        uc.ctx = SDL_GL_CreateContext(uc.window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(mainWindow, mainCtx);
+
+    if (!uc.ctx) {
+        fprintf(stderr, "Shared upload context unavailable: %s\n", SDL_GetError());
+        if (uc.window)
+            SDL_DestroyWindow(uc.window);
+        uc.window = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------
+// Desktop panels: one per captured output
+// ----------------------------------------------------------------------
+
+struct DesktopPanel {
+    capture_stream *stream = nullptr;
+    FrameHandoff *handoff = nullptr;
+    char name[32] = "unnamed";              // a copy: outputs belong to the capture thread
+
+    // every panel uploads on its own thread and context, so the uploads of
+    // several monitors run on separate cores
+    UploadContext uploadCtx;
+    UploadThread uploader;
+    bool threadedUpload = false;
+    DesktopTexture desktop;                 // render-thread uploads only
+    const FrameSlot *current = nullptr;     // ... and the frame it last took
+    const DesktopTexture *shown = nullptr;
+    uint64_t shownFrames = 0;               // new captures shown has switched to
+    uint64_t submittedFrames = 0;           // ... of which the compositor has had
+    PanelMesh mesh;                         // plane or cylinder, rebuilt only for this panel
+
+    PanelPlacement place;
+    capture_region logical;                 // what shown covers, for the cursor layer
+    int placedWidth = 0;                    // frame size place.height was fitted to
+    int placedHeight = 0;
+    OverlayPanel overlay;
+    bool warnedTiled = false;
+};
+
+// Newest frame for the panel: from the upload thread, or acquired and
+// uploaded here. The slot is ours until the next acquire, so the upload
+// runs without holding anything the capture thread needs, and tiles that
+// came into view can be caught up from it while the desktop is idle.
+static void panel_take_frame(DesktopPanel &p)
+{
+    if (p.threadedUpload) {
+        p.shown = upload_thread_front(p.uploader);
+        p.shownFrames = p.uploader.frontFrames;
+    } else {
+        FrameSlot *frame = handoff_acquire(*p.handoff);
+        if (frame) {
+            p.current = frame;
+            p.shownFrames++;
+        }
+        if (frame || (p.current && desktop_texture_needs_refresh(p.desktop))) {
+            upload_frame_to_texture(p.desktop, p.current, nullptr);
+            p.shown = &p.desktop;
         }
+    }
 
-        // Optional: small sleep to avoid hammering compositor if you want
-        // std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // the output changed mode: keep the panel's width and place, follow
+    // the new aspect (until then the last frame of the old size is shown)
+    if (p.shown && p.shown->width > 0 &&
+        (p.shown->width != p.placedWidth || p.shown->height != p.placedHeight)) {
+        if (p.placedWidth)
+            fprintf(stderr, "Panel %s resized to %dx%d\n", p.name, p.shown->width, p.shown->height);
+        p.placedWidth = p.shown->width;
+        p.placedHeight = p.shown->height;
+        p.place.height = p.place.width * (float)p.placedHeight / (float)p.placedWidth;
     }
+
+    // the cursor layer maps the pointer through what the shown frame covers,
+    // which follows moves and mode changes, and geometry that came late
+    if (p.shown) {
+        const FrameRect &l = p.shown->logical;
+        p.logical.x = l.x;
+        p.logical.y = l.y;
+        p.logical.width = l.width;
+        p.logical.height = l.height;
+    }
+}
+
+// Tell the uploads which of the panel's tiles are in view.
+static void panel_set_visible(DesktopPanel &p, uint32_t visibleTiles)
+{
+    if (p.threadedUpload)
+        upload_thread_set_visible(p.uploader, visibleTiles);
+    else
+        p.desktop.visibleTiles = visibleTiles;
+}
+
+// The overlay takes a single texture; an output too large for one is not
+// handed over.
+static GLuint overlay_texture(DesktopPanel &p)
+{
+    if (p.shown->numTiles == 1)
+        return p.shown->tiles[0].tex;
+    if (!p.warnedTiled) {
+        fprintf(stderr, "Panel %s: %dx%d exceeds GL_MAX_TEXTURE_SIZE, not shown as an overlay\n",
+                p.name, p.shown->width, p.shown->height);
+        p.warnedTiled = true;
+    }
+    return 0;
+}
+
+// The upload thread gets the texture shown before the last swap back once
+// the compositor has been handed another one, or never had it.
+static void panel_release_overlay_texture(DesktopPanel &p)
+{
+    const DesktopTexture *held = p.threadedUpload ? upload_thread_held(p.uploader) : nullptr;
+    if (held && (held->numTiles != 1 || held->tiles[0].tex != p.overlay.texture))
+        upload_thread_release_back(p.uploader);
+}
+
+static uint64_t panel_upload_bytes(const DesktopPanel &p)
+{
+    return p.threadedUpload ? p.uploader.uploadBytes.load(std::memory_order_relaxed)
+                            : p.desktop.stats.bytes;
+}
+
+// Arrange the panels like the monitors. Outputs without an xdg-output
+// geometry go to the right of the others at their captured size. Reads the
+// streams directly, so only before the capture thread starts; later size
+// changes come with the frames (panel_take_frame).
+static void arrange_panels(DesktopPanel *panels, int count, float baseWidth)
+{
+    PanelRect rects[SCREENCOPY_MAX_STREAMS];
+    capture_region logical[SCREENCOPY_MAX_STREAMS];
+    int right = 0;
+    for (int i = 0; i < count; ++i) {
+        logical[i] = screencopy_stream_rect(panels[i].stream);
+        if (logical[i].width > 0 && logical[i].x + logical[i].width > right)
+            right = logical[i].x + logical[i].width;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const capture_stream *s = panels[i].stream;
+        const capture_region &l = logical[i];
+        PanelRect &r = rects[i];
+        if (l.width > 0 && l.height > 0) {
+            r.x = l.x;
+            r.y = l.y;
+            r.width = l.width;
+            r.height = l.height;
+        } else {
+            r.x = right;
+            r.y = 0;
+            r.width = s->width ? (int)s->width : 1920;
+            r.height = s->height ? (int)s->height : 1080;
+            right += r.width;
+        }
+        // the captured buffer decides the aspect (transformed outputs)
+        r.aspect = s->width ? (float)s->height / (float)s->width : 0.0f;
+    }
+
+    PanelPlacement places[SCREENCOPY_MAX_STREAMS];
+    panel_layout_arrange(rects, count, baseWidth, places);
+    for (int i = 0; i < count; ++i) {
+        places[i].nudgeX = panels[i].place.nudgeX;
+        places[i].nudgeY = panels[i].place.nudgeY;
+        panels[i].place = places[i];
+        panels[i].logical = logical[i];
+        panels[i].placedWidth = (int)panels[i].stream->width;
+        panels[i].placedHeight = (int)panels[i].stream->height;
+    }
+}
+
+// The panel showing the part of the desktop the pointer is over, with the
+// pointer's frame UVs on it; -1 if none.
+static int cursor_panel(const CursorLayer &c, const DesktopPanel *panels, int count, float uv[4])
+{
+    for (int i = 0; i < count; ++i) {
+        const capture_region &l = panels[i].logical;
+        if (panels[i].shown && cursor_layer_uv(c, l.x, l.y, l.width, l.height, uv))
+            return i;
+    }
+    return -1;
+}
+
+static const char *panel_name(const DesktopPanel &p)
+{
+    return p.name;
+}
+
+static int select_next_panel(const DesktopPanel *panels, int count, int active)
+{
+    active = (active + 1) % count;
+    fprintf(stderr, "Selected panel %d (%s)\n", active + 1, panel_name(panels[active]));
+    return active;
+}
+
+static void nudge_panel(DesktopPanel &p, float dx, float dy)
+{
+    p.place.nudgeX += dx;
+    p.place.nudgeY += dy;
+    fprintf(stderr, "Panel %s nudged to %.2f, %.2f m\n",
+            panel_name(p), p.place.nudgeX, p.place.nudgeY);
 }
 
 // ----------------------------------------------------------------------
@@ -993,9 +799,11 @@ static void print_usage(const char *prog)
         "  -h, --help\n"
         "       Show this help text.\n"
         "\n"
-        "  -o <output>, --output <output>\n"
-        "       Select a Wayland output name (default: DP-3).\n"
-        "       Example: --output HDMI-A-1\n"
+        "  -o <outputs>, --output <outputs>\n"
+        "       Wayland outputs to capture, comma-separated, or \"all\"\n"
+        "       (default: DP-3). Each output gets its own VR panel,\n"
+        "       arranged like the monitors.\n"
+        "       Example: --output DP-1,HDMI-A-1\n"
         "\n"
         "  -n, --no-window\n"
         "       Hide the SDL window (VR-only mode).\n"
@@ -1009,10 +817,88 @@ static void print_usage(const char *prog)
         "       Enable curved desktop surface (cylindrical)\n"
         "       instead of a flat plane.\n"
         "\n"
+        "  --pbo-ring <n>\n"
+        "       Number of pixel buffer objects used to stream texture\n"
+        "       uploads (0 = upload from client memory). Default: 3.\n"
+        "\n"
+        "  --inline-upload\n"
+        "       Upload frames on the render thread instead of a\n"
+        "       dedicated upload thread.\n"
+        "\n"
+        "  --tile-size <n>\n"
+        "       Edge in px of the tiles the desktop texture is split\n"
+        "       into (capped by GL_MAX_TEXTURE_SIZE; a multiple of 16\n"
+        "       with mipmaps). Tiles out of view skip their uploads.\n"
+        "       Default: 2048.\n"
+        "\n"
+        "  --mipmaps <off|full|damage>\n"
+        "       Mip chain upkeep for trilinear sampling of a zoomed-out\n"
+        "       panel: none, glGenerateMipmap per written tile, or only\n"
+        "       the damaged area of each level. Default: damage.\n"
+        "\n"
+        "  --no-damage\n"
+        "       Capture every frame in full instead of waiting for\n"
+        "       compositor damage (copy_with_damage).\n"
+        "\n"
+        "  --tile-diff\n"
+        "       Work out damage from 64 px tile hashes for frames the\n"
+        "       compositor sends without any, and drop unchanged frames.\n"
+        "       For compositors whose damage is missing or always full.\n"
+        "\n"
+        "  --tile-diff-threads <n>\n"
+        "       Threads hashing tiles (0 = one per core). Default: 0.\n"
+        "\n"
+        "  --overlay\n"
+        "       Hand the desktop to the OpenVR compositor as an overlay\n"
+        "       instead of rendering the eyes; a texture is pushed only\n"
+        "       when a new frame arrives.\n"
+        "\n"
+        "  --overlay-stub\n"
+        "       Overlay mode against a logging stub instead of OpenVR\n"
+        "       (no headset needed).\n"
+        "\n"
+        "  --in-flight <n>\n"
+        "       Screencopy requests kept outstanding at once (1-3),\n"
+        "       hiding the compositor round trip. Default: 2.\n"
+        "\n"
+        "  --no-pacing\n"
+        "       Capture as fast as the compositor allows instead of once\n"
+        "       per headset frame.\n"
+        "\n"
+        "  --two-pass\n"
+        "       Render each eye with its own draw instead of both\n"
+        "       eyes in one layered pass.\n"
+        "\n"
+        "  --hud\n"
+        "       Show the frame timing HUD below the desktop panel\n"
+        "       (not in overlay mode).\n"
+        "\n"
+        "  --cursor-layer\n"
+        "       Capture without the pointer and draw it as its own quad\n"
+        "       at headset frame rate, from position and image messages\n"
+        "       on a local socket (see cursor_layer.h). Headset only:\n"
+        "       not in overlay mode or the preview window.\n"
+        "\n"
+        "  --cursor-socket <path>\n"
+        "       Socket for --cursor-layer (implies it).\n"
+        "       Default: $XDG_RUNTIME_DIR/vrdesktop-cursor.\n"
+        "\n"
+        "  --region <x>,<y>,<w>x<h>\n"
+        "       Capture only this rectangle of the desktop, in logical\n"
+        "       (xdg-output) coordinates, onto its own panel. Repeat for\n"
+        "       up to 4 regions; replaces the -o outputs.\n"
+        "       Example: --region 2560,0,1920x1080\n"
+        "\n"
         "Keyboard Controls:\n"
         "  Numpad +     Zoom in (move plane closer)  \n"
         "  Numpad -     Zoom out (move plane farther)\n"
         "  Numpad 5     Recenter desktop plane to the middle of your view\n"
+        "  Tab          Select the next panel (multiple outputs)\n"
+        "  Numpad 4/6   Nudge the selected panel left / right\n"
+        "  Numpad 8/2   Nudge the selected panel up / down\n"
+        "  s            Toggle single-pass / two-pass stereo\n"
+        "  l            Print latency percentiles\n"
+        "  h            Toggle the frame timing HUD\n"
         "  ESC          Quit\n"
         "\n"
         "Description:\n"
@@ -1027,10 +913,11 @@ static void print_usage(const char *prog)
         "  %s                          # default: DP-3, flat screen\n"
         "  %s --curved                 # curved cinema-style surface\n"
         "  %s --output HDMI-A-1        # select a specific display\n"
+        "  %s --output all             # one panel per monitor\n"
         "  %s --distance 3.0           # place screen 3m away\n"
         "  %s -n --curved              # VR only, curved\n"
         "\n",
-        prog, prog, prog, prog, prog, prog
+        prog, prog, prog, prog, prog, prog, prog
     );
 }
 
@@ -1078,6 +965,18 @@ static void on_menu_toggle_save(GtkMenuItem*, gpointer) {
     g_trayToggleSave.store(true);
 }
 
+static void on_menu_toggle_stereo(GtkMenuItem*, gpointer) {
+    g_trayToggleStereo.store(true);
+}
+
+static void on_menu_show_latency(GtkMenuItem*, gpointer) {
+    g_trayShowLatency.store(true);
+}
+
+static void on_menu_toggle_hud(GtkMenuItem*, gpointer) {
+    g_trayToggleHud.store(true);
+}
+
 static void on_menu_quit(GtkMenuItem*, gpointer) {
     g_trayQuitRequest.store(true);
 }
@@ -1117,6 +1016,9 @@ int main(int argc, char **argv)
     GtkWidget *item_zoom_out = gtk_menu_item_new_with_label("Zoom Out");
     GtkWidget *item_preview = gtk_menu_item_new_with_label("Show Preview");
     GtkWidget *item_curved = gtk_menu_item_new_with_label("Toggle Curved/Flat");
+    GtkWidget *item_stereo = gtk_menu_item_new_with_label("Toggle Single/Two-Pass Stereo");
+    GtkWidget *item_latency = gtk_menu_item_new_with_label("Print Latency Stats");
+    GtkWidget *item_hud = gtk_menu_item_new_with_label("Toggle Stats HUD");
     GtkWidget *item_save_config = gtk_menu_item_new_with_label("Save Configuration");
     GtkWidget *item_quit = gtk_menu_item_new_with_label("Quit");
 
@@ -1125,6 +1027,9 @@ int main(int argc, char **argv)
     g_signal_connect(item_zoom_out, "activate", G_CALLBACK(on_menu_toggle_zoom_out), nullptr);
     g_signal_connect(item_curved, "activate", G_CALLBACK(on_menu_toggle_curved_flat), nullptr);
     g_signal_connect(item_preview, "activate", G_CALLBACK(on_menu_toggle_preview), nullptr);
+    g_signal_connect(item_stereo, "activate", G_CALLBACK(on_menu_toggle_stereo), nullptr);
+    g_signal_connect(item_latency, "activate", G_CALLBACK(on_menu_show_latency), nullptr);
+    g_signal_connect(item_hud, "activate", G_CALLBACK(on_menu_toggle_hud), nullptr);
     g_signal_connect(item_save_config, "activate", G_CALLBACK(on_menu_toggle_save), nullptr);
     g_signal_connect(item_quit, "activate", G_CALLBACK(on_menu_quit), nullptr);
 
@@ -1133,12 +1038,30 @@ int main(int argc, char **argv)
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_zoom_out);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_preview);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_curved);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_stereo);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_latency);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_hud);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_save_config);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), item_quit);
     gtk_widget_show_all(menu);
     app_indicator_set_menu(indicator, GTK_MENU(menu));
 
     const char *requested_output = cfg.displayOutput.c_str();  // default Wayland output
+    capture_region regions[SCREENCOPY_MAX_STREAMS];
+    int numRegions = 0;
+    bool useDamage = true;
+    bool useTileDiff = false;
+    int tileDiffThreads = 0;
+    int pboRingDepth = UPLOAD_DEFAULT_PBOS;
+    int tileSize = 0;
+    MipMode mipmaps = MIP_DAMAGE;
+    bool useUploadThread = true;
+    OverlayBackend overlayBackend = OVERLAY_BACKEND_NONE;
+    bool usePacing = true;
+    int captureInFlight = SCREENCOPY_DEFAULT_IN_FLIGHT;
+    bool showHud = false;
+    bool useCursorLayer = false;
+    const char *cursorSocket = nullptr;
     float planeDistance = 0.7;
     float curveDistance = 0.7;
     fprintf(stderr, "show window value: %d", cfg.hide_window);
@@ -1160,6 +1083,49 @@ int main(int argc, char **argv)
     } else if (strcmp(argv[i], "-c") == 0) {
             g_useCurvedSurface = true;
             fprintf(stderr, "Using curved desktop surface.\n");
+    } else if (strcmp(argv[i], "--no-damage") == 0) {
+            useDamage = false;
+    } else if (strcmp(argv[i], "--tile-diff") == 0) {
+            useTileDiff = true;
+    } else if (strcmp(argv[i], "--tile-diff-threads") == 0 && i + 1 < argc) {
+            tileDiffThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--pbo-ring") == 0 && i + 1 < argc) {
+            pboRingDepth = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--inline-upload") == 0) {
+            useUploadThread = false;
+    } else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            tileSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--mipmaps") == 0 && i + 1 < argc) {
+            if (!parse_mip_mode(argv[++i], &mipmaps)) {
+                fprintf(stderr, "Bad mipmap mode \"%s\" (expected off, full or damage)\n", argv[i]);
+                return 1;
+            }
+    } else if (strcmp(argv[i], "--two-pass") == 0) {
+            g_singlePassStereo = false;
+    } else if (strcmp(argv[i], "--in-flight") == 0 && i + 1 < argc) {
+            captureInFlight = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--no-pacing") == 0) {
+            usePacing = false;
+    } else if (strcmp(argv[i], "--hud") == 0) {
+            showHud = true;
+    } else if (strcmp(argv[i], "--cursor-layer") == 0) {
+            useCursorLayer = true;
+    } else if (strcmp(argv[i], "--cursor-socket") == 0 && i + 1 < argc) {
+            useCursorLayer = true;
+            cursorSocket = argv[++i];
+    } else if (strcmp(argv[i], "--region") == 0 && i + 1 < argc) {
+            if (numRegions == SCREENCOPY_MAX_STREAMS) {
+                fprintf(stderr, "At most %d regions, ignoring %s\n", SCREENCOPY_MAX_STREAMS, argv[++i]);
+            } else if (!screencopy_parse_region(argv[++i], &regions[numRegions])) {
+                fprintf(stderr, "Bad region \"%s\" (expected X,Y,WxH)\n", argv[i]);
+                return 1;
+            } else {
+                numRegions++;
+            }
+    } else if (strcmp(argv[i], "--overlay") == 0) {
+            overlayBackend = OVERLAY_BACKEND_OPENVR;
+    } else if (strcmp(argv[i], "--overlay-stub") == 0) {
+            overlayBackend = OVERLAY_BACKEND_STUB;
     } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -1185,29 +1151,38 @@ int main(int argc, char **argv)
 
     // ---------------- Wayland init ----------------
     screencopy_state st{};
-    st.shm_fd = -1;
-
-    st.display = wl_display_connect(nullptr);
-    if (!st.display) {
-        fprintf(stderr, "Failed to connect to Wayland\n");
+    if (!screencopy_connect(&st, requested_output, regions, numRegions))
         return 1;
+    screencopy_set_in_flight(&st, captureInFlight);
+
+    st.use_damage = useDamage &&
+        st.screencopy_version >= ZWLR_SCREENCOPY_FRAME_V1_COPY_WITH_DAMAGE_SINCE_VERSION;
+    fprintf(stderr, "Damage-driven capture: %s\n", st.use_damage ? "on" : "off");
+    if (useTileDiff)
+        screencopy_set_tile_diff(&st, tileDiffThreads);
+
+    // the pointer as its own layer: the frames are captured without it
+    CursorLayer cursor;
+    if (useCursorLayer) {
+        if (overlayBackend != OVERLAY_BACKEND_NONE) {
+            fprintf(stderr, "Cursor layer needs scene rendering (not available in overlay mode)\n");
+        } else if (cursor_layer_open(cursor, cursorSocket)) {
+            st.overlay_cursor = false;
+            fprintf(stderr, "Cursor layer: pointer from %s, not captured\n", cursor.path);
+        }
     }
 
-    st.registry = wl_display_get_registry(st.display);
-    wl_registry_add_listener(st.registry, &registry_listener, &st);
-    wl_display_roundtrip(st.display);
-
-    if (!st.shm || !st.screencopy_manager || st.num_outputs == 0) {
-        fprintf(stderr, "Wayland globals missing\n");
-        return 1;
+    // one panel per captured output
+    const int numPanels = st.num_streams;
+    DesktopPanel panels[SCREENCOPY_MAX_STREAMS];
+    for (int i = 0; i < numPanels; ++i) {
+        panels[i].stream = &st.streams[i];
+        panels[i].handoff = &g_frameHandoff[i];
+        const char *name = screencopy_stream_output(&st.streams[i]).name;
+        if (name)
+            snprintf(panels[i].name, sizeof(panels[i].name), "%s", name);
     }
-
-    setup_xdg_outputs(&st);
-    wl_display_roundtrip(st.display);
-
-    choose_output(&st, requested_output);
-    if (!st.chosen_output)
-        return 1;
+    int activePanel = 0;        // the one nudged by the keys, with the HUD under it
 
     // ---------------- SDL + OpenGL init ----------------
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
@@ -1215,7 +1190,9 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
@@ -1242,35 +1219,98 @@ int main(int argc, char **argv)
 
     SDL_GL_SetSwapInterval(0);
 
+    Renderer renderer;
+    if (!renderer_init(renderer, SDL_GL_GetProcAddress)) {
+        fprintf(stderr, "Renderer initialization failed\n");
+        return 1;
+    }
+
     // Window size is irrelevant for VR resolution
     int winW = 1280, winH = 720;
 
     // ---------------- OpenVR init ----------------
     VRState vrState{};
-    bool vr_ok = init_openvr(vrState);
+    const bool overlayMode = overlayBackend != OVERLAY_BACKEND_NONE;
+    bool vr_ok;
+    if (overlayMode) {
+        vr_ok = overlayBackend == OVERLAY_BACKEND_STUB ||
+                init_openvr(vrState, vr::VRApplication_Overlay);
+        for (int i = 0; vr_ok && i < numPanels; ++i)
+            vr_ok = overlay_panel_init(panels[i].overlay, overlayBackend, i);
+    } else {
+        vr_ok = init_openvr(vrState, vr::VRApplication_Scene);
+    }
 
     if (!vr_ok)
         fprintf(stderr, "OpenVR unavailable — VR disabled.\n");
 
-    // ---------------- Capture first frame ----------------
-    GLuint desktopTex = 0;
-    bool desktopTexInitialized = false;
+    // both eyes as layers of one array texture; without it we stay two-pass
+    StereoTarget stereoTarget;
+    bool haveStereoTarget = vr_ok && !overlayMode &&
+        stereo_target_init(stereoTarget, renderer,
+                           (int)vrState.rtWidth, (int)vrState.rtHeight);
+    if (!haveStereoTarget)
+        g_singlePassStereo = false;
+    fprintf(stderr, "Stereo rendering: %s\n",
+            g_singlePassStereo ? "single pass" : "two pass");
+
+    // stats HUD, drawn next to the panel in scene mode
+    Hud hud;
+    const bool haveHud = vr_ok && !overlayMode && hud_init(hud);
+    hud.visible = haveHud && showHud;
+
+    // ---------------- Capture pacing ----------------
+    float hmdRefreshHz = 0.0f;
+    if (vrState.system)
+        hmdRefreshHz = vrState.system->GetFloatTrackedDeviceProperty(
+            vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+    frame_pacer_init(g_framePacer, hmdRefreshHz, usePacing);
+    LatencyStats latency;
+    CompositorStats compositorStats;
+
+    // ---------------- Capture first frames ----------------
+    // first frame is a plain copy so we always have something to show;
+    // whichever upload path is active picks it up from the handoff
+    for (int i = 0; i < numPanels; ++i) {
+        handoff_init(g_frameHandoff[i], panels[i].stream->num_buffers);
+        if (screencopy_capture_sync(panels[i].stream, g_frameHandoff[i], false) != 0)
+            fprintf(stderr, "Initial capture of output %d failed\n", i);
+    }
 
-    if (screencopy_capture(&st) == 0)
-        upload_frame_to_texture(&st, desktopTex, desktopTexInitialized);
-    else
-        fprintf(stderr, "Initial capture failed\n");
+    // ---------------- Texture upload ----------------
+    // the compositor takes one texture per overlay: make the tiles as large
+    // as the driver allows, so any output that fits is a single tile
+    if (overlayMode)
+        tileSize = INT_MAX;
+    int uploadThreads = 0;
+    for (int i = 0; i < numPanels; ++i) {
+        DesktopPanel &p = panels[i];
+        // the compositor samples an overlay's texture whenever it likes
+        p.uploader.holdBack = vr_ok && overlayMode;
+        p.threadedUpload = useUploadThread &&
+            create_upload_context(p.uploadCtx, window, glctx) &&
+            upload_thread_start(p.uploader, *p.handoff, pboRingDepth, tileSize, mipmaps,
+                                upload_context_make_current,
+                                upload_context_release, &p.uploadCtx);
+        // only used when uploads stay on the render thread
+        if (!p.threadedUpload)
+            desktop_texture_init(p.desktop, pboRingDepth, tileSize, mipmaps);
+        else
+            uploadThreads++;
+    }
+    fprintf(stderr, "Texture upload: %d upload thread(s), %d on the render thread\n",
+            uploadThreads, numPanels - uploadThreads);
+    HudSample hudPrev;
+
+    // ---------------- Panel layout + interaction ----------------
+    // the first output is planeWidth wide, the others follow its scale;
+    // laid out before the capture thread owns the stream geometry
+    const float planeWidth = 1.5f;
+    arrange_panels(panels, numPanels, planeWidth);
 
     g_captureRunning.store(true);
     std::thread captureThread(capture_thread_func, &st);
 
-    // ---------------- Plane size + interaction ----------------
-    float planeWidth = 1.5f;
-    float planeHeight = 0.9f;
-
-    if (st.width && st.height)
-        planeHeight = planeWidth * ((float)st.height / (float)st.width);
-
     const float planeDistanceMin = 0.5f;
     const float planeDistanceMax = 5.0f;
     const float curveDistanceMin = -1.0f;
@@ -1334,6 +1374,22 @@ int main(int argc, char **argv)
                     g_useCurvedSurface = !g_useCurvedSurface;
                     fprintf(stderr, "Surface mode: %s\n",
                         g_useCurvedSurface ? "curved" : "flat");
+            } else if (key == SDLK_s) {
+                    g_trayToggleStereo.store(true);
+            } else if (key == SDLK_l) {
+                    g_trayShowLatency.store(true);
+            } else if (key == SDLK_h) {
+                    g_trayToggleHud.store(true);
+            } else if (key == SDLK_TAB) {
+                    activePanel = select_next_panel(panels, numPanels, activePanel);
+            } else if (key == SDLK_KP_4) {
+                    nudge_panel(panels[activePanel], -PANEL_NUDGE_METERS, 0.0f);
+            } else if (key == SDLK_KP_6) {
+                    nudge_panel(panels[activePanel],  PANEL_NUDGE_METERS, 0.0f);
+            } else if (key == SDLK_KP_8) {
+                    nudge_panel(panels[activePanel], 0.0f,  PANEL_NUDGE_METERS);
+            } else if (key == SDLK_KP_2) {
+                    nudge_panel(panels[activePanel], 0.0f, -PANEL_NUDGE_METERS);
                 }
             }
     }
@@ -1383,6 +1439,22 @@ int main(int argc, char **argv)
                 g_useCurvedSurface = !g_useCurvedSurface;
                 fprintf(stderr, "Surface mode: %s\n",
                     g_useCurvedSurface ? "curved" : "flat");
+        } else if (ch == 's') {
+                g_trayToggleStereo.store(true);
+        } else if (ch == 'l') {
+                g_trayShowLatency.store(true);
+        } else if (ch == 'h') {
+                g_trayToggleHud.store(true);
+        } else if (ch == '\t') {
+                activePanel = select_next_panel(panels, numPanels, activePanel);
+        } else if (ch == '4') {
+                nudge_panel(panels[activePanel], -PANEL_NUDGE_METERS, 0.0f);
+        } else if (ch == '6') {
+                nudge_panel(panels[activePanel],  PANEL_NUDGE_METERS, 0.0f);
+        } else if (ch == '8') {
+                nudge_panel(panels[activePanel], 0.0f,  PANEL_NUDGE_METERS);
+        } else if (ch == '2') {
+                nudge_panel(panels[activePanel], 0.0f, -PANEL_NUDGE_METERS);
                }
             }
     }
@@ -1426,6 +1498,26 @@ int main(int argc, char **argv)
             g_useCurvedSurface = !g_useCurvedSurface;
             fprintf(stderr, "Surface mode (tray): %s\n", g_useCurvedSurface ? "curved" : "flat");
         }
+        if (g_trayToggleStereo.exchange(false)) {
+            if (haveStereoTarget) {
+                g_singlePassStereo = !g_singlePassStereo;
+                fprintf(stderr, "Stereo rendering: %s\n",
+                        g_singlePassStereo ? "single pass" : "two pass");
+            } else {
+                fprintf(stderr, "Single-pass stereo unsupported, staying two pass\n");
+            }
+        }
+        if (g_trayShowLatency.exchange(false)) {
+            print_latency_stats(latency);
+        }
+        if (g_trayToggleHud.exchange(false)) {
+            if (haveHud) {
+                hud.visible = !hud.visible;
+                fprintf(stderr, "Stats HUD: %s\n", hud.visible ? "shown" : "hidden");
+            } else {
+                fprintf(stderr, "Stats HUD needs scene rendering (not available in overlay mode)\n");
+            }
+        }
         if (g_trayTogglePreview.exchange(false)) {
             hideWindow = !hideWindow;
         fprintf(stderr, "Window Hidden: %d\n", hideWindow);
@@ -1450,41 +1542,79 @@ int main(int argc, char **argv)
         }
     }
     // ------------ 120fps screencopy capture ------------
-    static uint64_t lastUploadedVersion = 0;
-
-    uint64_t v = g_sharedFrame.version.load(std::memory_order_relaxed);
-    if (v != lastUploadedVersion && v != 0) {
-        std::lock_guard<std::mutex> lock(g_sharedFrame.m);
-
-        if (!desktopTexInitialized) {
-        glGenTextures(1, &desktopTex);
-            glBindTexture(GL_TEXTURE_2D, desktopTex);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                         g_sharedFrame.width,
-                         g_sharedFrame.height,
-                         0, GL_RGBA, GL_UNSIGNED_BYTE,
-                         g_sharedFrame.pixels.data());
-            desktopTexInitialized = true;
-        } else {
-            glBindTexture(GL_TEXTURE_2D, desktopTex);
-            glTexSubImage2D(GL_TEXTURE_2D, 0,
-                            0, 0,
-                            g_sharedFrame.width,
-                            g_sharedFrame.height,
-                            GL_RGBA, GL_UNSIGNED_BYTE,
-                            g_sharedFrame.pixels.data());
+    // newest texture of every panel; drawn once any of them has one
+    bool anyShown = false;
+    for (int i = 0; i < numPanels; ++i) {
+        panel_take_frame(panels[i]);
+        anyShown = anyShown || panels[i].shown;
+    }
+    DesktopPanel &active = panels[activePanel];
+
+        // ------------ Capture pacing ------------
+        if (vr_ok && vrState.system) {
+            float sinceVsync = 0.0f;
+            uint64_t vsyncFrame = 0;
+            if (vrState.system->GetTimeSinceLastVsync(&sinceVsync, &vsyncFrame))
+                frame_pacer_vsync(g_framePacer, sinceVsync, 0.0f);
         }
-
-        lastUploadedVersion = v;
+        frame_pacer_report(g_framePacer, handoff_total(&FrameHandoff::dropped, numPanels), false);
+
+        // ------------ Stats HUD ------------
+        // sampled even while hidden so the first rates shown are valid;
+        // the texture is only redrawn when a line actually changes
+        if (haveHud && pacer_now_ns() - hudPrev.ns >= HUD_REFRESH_NS) {
+            uint64_t uploadBytes = 0;
+            for (int i = 0; i < numPanels; ++i)
+                uploadBytes += panel_upload_bytes(panels[i]);
+            HudSample cur = sample_hud(uploadBytes, numPanels);
+            if (hud.visible && hudPrev.ns)
+                set_hud_lines(hud, hudPrev, cur, compositorStats, numPanels);
+            hudPrev = cur;
+        }
+        if (hud.visible)
+            hud_update(hud);
+
+        // ------------ VR overlay ------------
+    if (vr_ok && anyShown && overlayMode) {
+        // the compositor draws and reprojects the panels; we only need the
+        // head pose to place them and a new texture when a frame arrives
+        if (overlay_panel_head_pose(panels[0].overlay, g_lastAbsoluteFromHeadRow)) {
+            g_haveHeadPose = true;
+            if (!g_planePoseInitialized) {
+                recenter_plane(planeDistance);
+            }
+            if (!g_curvePoseInitialized) {
+                recenter_curve(curveDistance);
+            }
+        }
+        bool fresh = false;
+        for (int i = 0; i < numPanels; ++i) {
+            DesktopPanel &p = panels[i];
+            if (!p.shown)
+                continue;
+            if (g_haveHeadPose) {
+                // the compositor curves each overlay about its own centre,
+                // so overlays are laid out side by side like flat panels
+                float planeFromPanel[16], absoluteFromPanel[16];
+                panel_offset_row(p.place, planeWidth, false, planeFromPanel);
+                mat4_mul_row(g_planePoseRow, planeFromPanel, absoluteFromPanel);
+                overlay_panel_set_geometry(p.overlay, p.place.width,
+                                           g_useCurvedSurface ? PANEL_CURVE_ARC_DEGREES / 360.0f : 0.0f,
+                                           absoluteFromPanel);
+                uint64_t pushed = p.overlay.textureSeq;
+                overlay_panel_set_texture(p.overlay, overlay_texture(p), p.shownFrames);
+                if (p.overlay.textureSeq != pushed)
+                    record_frame_latency(latency, *p.shown, pacer_now_ns());
+            }
+            panel_release_overlay_texture(p);
+            fresh = fresh || p.shownFrames != p.submittedFrames;
+            p.submittedFrames = p.shownFrames;
+        }
+        overlay_panel_wait_frame(panels[0].overlay, 100);
+        frame_pacer_frame(g_framePacer, fresh);
     }
-
-
         // ------------ VR rendering ------------
-    if (vr_ok && desktopTexInitialized) {
+    if (vr_ok && anyShown && !overlayMode) {
         vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
         vr::VRCompositor()->WaitGetPoses(
         poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
@@ -1508,18 +1638,18 @@ int main(int argc, char **argv)
                 recenter_curve(curveDistance);
             }
         }
-        // Safety: if we *still* don't have a pose, skip VR for this frame
-        if (!g_haveHeadPose) {
-            // Optionally clear the eye FBOs to black so they don't contain garbage
-            for (int eye = 0; eye < 2; ++eye) {
-                glBindFramebuffer(GL_FRAMEBUFFER, vrState.eyeFbo[eye]);
-                glViewport(0, 0, vrState.rtWidth, vrState.rtHeight);
-                glClearColor(0.f, 0.f, 0.f, 1.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-            }
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        } else {
-            // ---- Render each eye using the same HMD pose ----
+        // clip<-panel per panel and eye, column-major for the shader
+        // uniform, and clip<-HUD for the stats panel below the active one
+        float panelMvpCol[SCREENCOPY_MAX_STREAMS][2][16];
+        float hudMvpCol[2][16];
+        float planeFromPanelRow[SCREENCOPY_MAX_STREAMS][16];
+        for (int i = 0; i < numPanels; ++i)
+            panel_offset_row(panels[i].place, planeWidth, g_useCurvedSurface, planeFromPanelRow[i]);
+        float activeFromHudRow[16], planeFromHudRow[16];
+        hud_offset_row(active.place.width, active.place.height, g_useCurvedSurface, activeFromHudRow);
+        mat4_mul_row(planeFromPanelRow[activePanel], activeFromHudRow, planeFromHudRow);
+        const bool drawHud = hud.visible && g_haveHeadPose;
+        if (g_haveHeadPose) {
             for (int eye = 0; eye < 2; ++eye) {
                 vr::Hmd_Eye vrEye = (eye == 0) ? vr::Eye_Left : vr::Eye_Right;
 
@@ -1542,105 +1672,193 @@ int main(int argc, char **argv)
                 float eyeFromPlaneRow[16];
                 mat4_mul_row(eyeFromAbsoluteRow, g_planePoseRow, eyeFromPlaneRow);
 
-                // Convert to column-major for OpenGL
-                float mvCol[16];
-                mat4_row_to_col(eyeFromPlaneRow, mvCol);
-
-                // Projection from OpenVR
+                // Projection from OpenVR (row-major, like our matrices)
                 vr::HmdMatrix44_t proj =
                     vrState.system->GetProjectionMatrix(vrEye, 0.1f, 100.0f);
 
-                float projCol[16];
+                float projRow[16];
                 for (int r = 0; r < 4; ++r)
                     for (int c = 0; c < 4; ++c)
-                        projCol[c*4 + r] = proj.m[r][c];
+                        projRow[r*4 + c] = proj.m[r][c];
+
+                float mvpRow[16];
+                mat4_mul_row(projRow, eyeFromPlaneRow, mvpRow);
+                for (int i = 0; i < numPanels; ++i) {
+                    float panelMvpRow[16];
+                    mat4_mul_row(mvpRow, planeFromPanelRow[i], panelMvpRow);
+                    mat4_row_to_col(panelMvpRow, panelMvpCol[i][eye]);
+                }
 
-                // --- Draw into this eye's FBO ---
-                glBindFramebuffer(GL_FRAMEBUFFER, vrState.eyeFbo[eye]);
-                glViewport(0, 0, vrState.rtWidth, vrState.rtHeight);
+                float hudMvpRow[16];
+                mat4_mul_row(mvpRow, planeFromHudRow, hudMvpRow);
+                mat4_row_to_col(hudMvpRow, hudMvpCol[eye]);
+            }
+
+            // tiles neither eye sees skip their uploads; the preview
+            // window shows all of the active panel
+            for (int i = 0; i < numPanels; ++i) {
+                if (!panels[i].shown)
+                    continue;
+                uint32_t visible = ~0u;
+                if (hideWindow || i != activePanel)
+                    visible = renderer_visible_tiles(*panels[i].shown, panelMvpCol[i], 2,
+                                                     panels[i].place.width, panels[i].place.height,
+                                                     g_useCurvedSurface);
+                panel_set_visible(panels[i], visible);
+            }
+        }
+
+        // newest pointer, drawn over the panel it is on
+        float cursorUv[4];
+        cursor_layer_poll(cursor);
+        const int cursorPanel = g_haveHeadPose ? cursor_panel(cursor, panels, numPanels, cursorUv) : -1;
 
-                glMatrixMode(GL_PROJECTION);
-                glLoadMatrixf(projCol);
+        if (g_singlePassStereo) {
+            // ---- Both eyes in one draw into the layered target ----
+            glBindFramebuffer(GL_FRAMEBUFFER, stereoTarget.fbo);
+            glViewport(0, 0, stereoTarget.width, stereoTarget.height);
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);   // clears every layer
+
+            for (int i = 0; i < numPanels && g_haveHeadPose; ++i)
+                if (panels[i].shown)
+                    renderer_draw_panel_stereo(renderer, panels[i].mesh, *panels[i].shown, panelMvpCol[i],
+                                               panels[i].place.width, panels[i].place.height,
+                                               g_useCurvedSurface);
+            if (cursorPanel >= 0)
+                renderer_draw_cursor_stereo(renderer, cursor.tex, cursorUv, panelMvpCol[cursorPanel],
+                                            panels[cursorPanel].place.width,
+                                            panels[cursorPanel].place.height, g_useCurvedSurface);
+            if (drawHud)
+                renderer_draw_hud_stereo(renderer, hud.tex, hudMvpCol,
+                                         HUD_WIDTH_METERS, hud_height_meters());
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-                glMatrixMode(GL_MODELVIEW);
-                glLoadMatrixf(mvCol);
+            // the eye index selects the array layer
+            vr::Texture_t stereoTex = {
+                (void*)(uintptr_t)stereoTarget.tex,
+                vr::TextureType_OpenGL,
+                vr::ColorSpace_Auto
+            };
+            vr::VRCompositor()->Submit(vr::Eye_Left,  &stereoTex, nullptr,
+                                       vr::Submit_GlArrayTexture);
+            vr::VRCompositor()->Submit(vr::Eye_Right, &stereoTex, nullptr,
+                                       vr::Submit_GlArrayTexture);
+        } else {
+            // ---- Render each eye using the same HMD pose ----
+            // (without a pose the eyes are only cleared so they don't
+            // contain garbage)
+            for (int eye = 0; eye < 2; ++eye) {
+                glBindFramebuffer(GL_FRAMEBUFFER, vrState.eyeFbo[eye]);
+                glViewport(0, 0, vrState.rtWidth, vrState.rtHeight);
 
                 glClearColor(0.f, 0.f, 0.f, 1.f);
                 glClear(GL_COLOR_BUFFER_BIT);
 
-                if (g_useCurvedSurface) {
-                    render_desktop_curved_3d(desktopTex, planeWidth, planeHeight);
-                } else {
-                    render_desktop_plane_3d(desktopTex, planeWidth, planeHeight);
-                }
+                for (int i = 0; i < numPanels && g_haveHeadPose; ++i)
+                    if (panels[i].shown)
+                        renderer_draw_panel(renderer, panels[i].mesh, *panels[i].shown, panelMvpCol[i][eye],
+                                            panels[i].place.width, panels[i].place.height,
+                                            g_useCurvedSurface);
+                if (cursorPanel >= 0)
+                    renderer_draw_cursor(renderer, cursor.tex, cursorUv, panelMvpCol[cursorPanel][eye],
+                                         panels[cursorPanel].place.width,
+                                         panels[cursorPanel].place.height, g_useCurvedSurface);
+                if (drawHud)
+                    renderer_draw_hud(renderer, hud.tex, hudMvpCol[eye],
+                                      HUD_WIDTH_METERS, hud_height_meters());
             }
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        }
 
-        // ---- Submit both eyes to the compositor ----
-        vr::Texture_t leftEyeTex  = {
-            (void*)(uintptr_t)vrState.eyeTex[0],
-            vr::TextureType_OpenGL,
-            vr::ColorSpace_Auto
-        };
-        vr::Texture_t rightEyeTex = {
-            (void*)(uintptr_t)vrState.eyeTex[1],
-            vr::TextureType_OpenGL,
-            vr::ColorSpace_Auto
-        };
-        vr::VRCompositor()->Submit(vr::Eye_Left,  &leftEyeTex);
-        vr::VRCompositor()->Submit(vr::Eye_Right, &rightEyeTex);
+            // ---- Submit both eyes to the compositor ----
+            vr::Texture_t leftEyeTex  = {
+                (void*)(uintptr_t)vrState.eyeTex[0],
+                vr::TextureType_OpenGL,
+                vr::ColorSpace_Auto
+            };
+            vr::Texture_t rightEyeTex = {
+                (void*)(uintptr_t)vrState.eyeTex[1],
+                vr::TextureType_OpenGL,
+                vr::ColorSpace_Auto
+            };
+            vr::VRCompositor()->Submit(vr::Eye_Left,  &leftEyeTex);
+            vr::VRCompositor()->Submit(vr::Eye_Right, &rightEyeTex);
+        }
+        if (cursorPanel >= 0)
+            cursor_layer_drawn(cursor, pacer_now_ns());
+        bool fresh = false;
+        for (int i = 0; i < numPanels; ++i) {
+            DesktopPanel &p = panels[i];
+            if (!p.shown || p.shownFrames == p.submittedFrames)
+                continue;
+            if (g_haveHeadPose)
+                record_frame_latency(latency, *p.shown, pacer_now_ns());
+            fresh = true;
+            p.submittedFrames = p.shownFrames;
+        }
+        if (update_compositor_stats(compositorStats))
+            record_vsync_latency(latency, compositorStats.last, g_framePacer.periodNs.load());
+        frame_pacer_frame(g_framePacer, fresh);
     }
         // ------------ Optional SDL window preview ------------
-        if (!hideWindow && desktopTexInitialized) {
+        if (!hideWindow && active.shown) {
             SDL_GetWindowSize(window, &winW, &winH);
             glViewport(0, 0, winW, winH);
             glDisable(GL_SCISSOR_TEST);
             glClearColor(0.f, 0.f, 0.f, 1.f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            if (g_useCurvedSurface) {
-                render_desktop_curved(desktopTex, planeWidth, planeHeight);
-            } else {
-                render_desktop_quad_2d(desktopTex);
-            }
+            renderer_draw_preview(renderer, active.mesh, *active.shown,
+                                  active.place.width, active.place.height, g_useCurvedSurface,
+                                  winH > 0 ? (float)winW / (float)winH : 1.0f);
             SDL_GL_SwapWindow(window);
         }
     }
 
     // ---------------- Cleanup ----------------
     g_captureRunning.store(false);
+    screencopy_wake(&st);
     if (captureThread.joinable()) {
         captureThread.join();
     }
-    if (desktopTex)
-        glDeleteTextures(1, &desktopTex);
-        shutdown_openvr(vrState);
-
-    if (st.buffer) wl_buffer_destroy(st.buffer);
-    if (st.pool) wl_shm_pool_destroy(st.pool);
-    if (st.shm_data && st.shm_data != MAP_FAILED)
-        munmap(st.shm_data, st.shm_size);
-    if (st.shm_fd >= 0)
-        close(st.shm_fd);
-
-    for (int i = 0; i < st.num_outputs; i++) {
-        if (st.outputs[i].xdg_output)
-            zxdg_output_v1_destroy(st.outputs[i].xdg_output);
-        if (st.outputs[i].wl_output_obj)
-            wl_output_destroy(st.outputs[i].wl_output_obj);
-        free(st.outputs[i].name);
+    fprintf(stderr, "Frames captured: %llu, uploaded: %llu, dropped: %llu\n",
+            (unsigned long long)handoff_total(&FrameHandoff::published, numPanels),
+            (unsigned long long)handoff_total(&FrameHandoff::consumed, numPanels),
+            (unsigned long long)handoff_total(&FrameHandoff::dropped, numPanels));
+    frame_pacer_report(g_framePacer, handoff_total(&FrameHandoff::dropped, numPanels), true);
+    print_latency_stats(latency);
+    print_cursor_layer_stats(cursor);
+    for (int i = 0; i < numPanels; ++i) {
+        DesktopPanel &p = panels[i];
+        if (numPanels > 1)
+            fprintf(stderr, "Panel %d (%s):\n", i + 1, panel_name(p));
+        if (p.stream->reallocations)
+            fprintf(stderr, "Capture buffers reallocated: %llu\n",
+                    (unsigned long long)p.stream->reallocations);
+        print_tile_diff_stats(p.stream->tile_diff);
+        if (p.threadedUpload) {
+            upload_thread_stop(p.uploader);
+            print_upload_stats(upload_thread_stats(p.uploader));
+        } else {
+            print_upload_stats(p.desktop.stats);
+            desktop_texture_destroy(p.desktop);
+        }
+        if (overlayMode && vr_ok) {
+            print_overlay_stats(p.overlay);
+            overlay_panel_destroy(p.overlay);
+        }
+        panel_mesh_destroy(p.mesh);
+        if (p.uploadCtx.ctx)
+            SDL_GL_DeleteContext(p.uploadCtx.ctx);
+        if (p.uploadCtx.window)
+            SDL_DestroyWindow(p.uploadCtx.window);
     }
+    stereo_target_destroy(stereoTarget);
+    hud_destroy(hud);
+    cursor_layer_close(cursor);
+    renderer_destroy(renderer);
+        shutdown_openvr(vrState);
 
-    if (st.xdg_output_manager)
-        zxdg_output_manager_v1_destroy(st.xdg_output_manager);
-    if (st.screencopy_manager)
-        zwlr_screencopy_manager_v1_destroy(st.screencopy_manager);
-    if (st.shm)
-        wl_shm_destroy(st.shm);
-    if (st.registry)
-        wl_registry_destroy(st.registry);
-    if (st.display)
-        wl_display_disconnect(st.display);
+    screencopy_disconnect(&st);
 
     SDL_GL_DeleteContext(glctx);
     SDL_DestroyWindow(window);